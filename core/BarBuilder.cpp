@@ -0,0 +1,313 @@
+#include "BarBuilder.h"
+#include "NumberFormat.h"
+#include "config.h"
+#include <cfloat>
+#include <cstring>
+#include <iostream>
+
+static const int64_t NANOS_PER_SECOND = 1000000000LL;
+static const int64_t NANOS_PER_DAY = 86400 * NANOS_PER_SECOND;
+static const int64_t BEIJING_OFFSET_NS = 8 * 3600 * NANOS_PER_SECOND;
+
+static const int64_t PERIOD_NS[BarBuilder::PERIOD_COUNT] = {
+    NANOS_PER_SECOND, 60 * NANOS_PER_SECOND, 300 * NANOS_PER_SECOND
+};
+
+// 追加字符串字面量（长度在编译期确定，不含结尾的 '\0'）
+#define APPEND_LITERAL(p, s) (memcpy(p, s, sizeof(s) - 1), p += sizeof(s) - 1)
+
+// 行情的交易所时间（UTC 纪元纳秒），UpdateTime 不合法时返回 0。
+// 大商所夜盘的 ActionDay 为下一交易日而不是自然日，因此不使用日期字段：
+// 取 UpdateTime 所在的、离本地接收时间最近（前后 12 小时内）的北京时间日期。
+static int64_t BarTimeNanos(const TickRecord& tick) {
+    const char* t = tick.Field.UpdateTime;
+    if (t[2] != ':' || t[5] != ':') return 0;
+    const int digits[] = {0, 1, 3, 4, 6, 7};
+    for (int i = 0; i < 6; ++i) {
+        if (t[digits[i]] < '0' || t[digits[i]] > '9') return 0;
+    }
+    int64_t seconds = ((t[0] - '0') * 10 + (t[1] - '0')) * 3600 + ((t[3] - '0') * 10 + (t[4] - '0')) * 60 +
+                      (t[6] - '0') * 10 + (t[7] - '0');
+    int64_t timeOfDay = seconds * NANOS_PER_SECOND + static_cast<int64_t>(tick.Field.UpdateMillisec) * 1000000LL;
+
+    int64_t localRecv = tick.RecvTimeNs + BEIJING_OFFSET_NS;
+    int64_t local = localRecv - localRecv % NANOS_PER_DAY + timeOfDay;
+    if (local - localRecv > NANOS_PER_DAY / 2) {
+        local -= NANOS_PER_DAY;
+    } else if (localRecv - local > NANOS_PER_DAY / 2) {
+        local += NANOS_PER_DAY;
+    }
+    return local - BEIJING_OFFSET_NS;
+}
+
+static bool IsTradePrice(double price) {
+    return !NumberFormat::IsInvalidPrice(price) && price > 0;
+}
+
+BarBuilder::InstrumentBars::InstrumentBars(uint32_t history)
+    : PendingVolume(0), PendingTurnover(0), Slots(new Slot[PERIOD_COUNT * history]) {
+    memset(Open, 0, sizeof(Open));
+    for (int p = 0; p < PERIOD_COUNT; ++p) Closed[p].store(0, std::memory_order_relaxed);
+}
+
+BarBuilder::BarBuilder(uint32_t instrumentCapacity, uint32_t history)
+    : m_nCapacity(instrumentCapacity), m_nHistory(history > 0 ? history : 1), m_pRegistry(nullptr),
+      m_pPublisher(nullptr), m_instruments(new std::atomic<InstrumentBars*>[instrumentCapacity]),
+      m_nClockNs(0), m_nClockOffsetNs(0), m_nNextSweepNs(0), m_nSequence(0),
+      m_nPublished(0), m_nLateTicks(0), m_nUntimedTicks(0) {
+    for (uint32_t i = 0; i < m_nCapacity; ++i) m_instruments[i].store(nullptr, std::memory_order_relaxed);
+}
+
+BarBuilder::~BarBuilder() {
+    for (uint32_t i = 0; i < m_nCapacity; ++i) delete m_instruments[i].load(std::memory_order_relaxed);
+}
+
+const char* BarBuilder::PeriodName(Period period) {
+    static const char* const NAMES[PERIOD_COUNT] = {"1s", "1m", "5m"};
+    return NAMES[period];
+}
+
+BarBuilder::InstrumentBars* BarBuilder::Acquire(uint32_t index) {
+    InstrumentBars* state = m_instruments[index].load(std::memory_order_relaxed);
+    if (!state) {
+        state = new InstrumentBars(m_nHistory);
+        m_instruments[index].store(state, std::memory_order_release);
+        m_active.push_back(index);
+    }
+    return state;
+}
+
+void BarBuilder::OnTick(TickContext& ctx) {
+    uint32_t index = ctx.InstrumentIndex();
+    if (index >= m_nCapacity) return;
+    const TickRecord& tick = ctx.Tick();
+    const CThostFtdcDepthMarketDataField& f = tick.Field;
+    // 成交量取流水线计算的增量：首条行情为 0，倒退的旧行情不参与合成
+    const TickDelta& delta = ctx.Delta();
+    if (delta.Type == TickDelta::KIND_STALE) return;
+    InstrumentBars& state = *Acquire(index);
+
+    int64_t timeNs = BarTimeNanos(tick);
+    if (timeNs == 0) {
+        // 无法归入区间：成交量留给下一条行情
+        m_nUntimedTicks.store(m_nUntimedTicks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        state.PendingVolume += delta.Volume;
+        state.PendingTurnover += delta.Turnover;
+        return;
+    }
+    uint32_t tradingDay = ParseTradingDay(f.TradingDay);
+    int64_t volume = state.PendingVolume + delta.Volume;
+    double turnover = state.PendingTurnover + delta.Turnover;
+    double openInterestBefore = f.OpenInterest - delta.OpenInterest;
+    state.PendingVolume = 0;
+    state.PendingTurnover = 0;
+
+    bool late = false;
+    for (int p = 0; p < PERIOD_COUNT; ++p) {
+        Period period = static_cast<Period>(p);
+        int64_t start = timeNs - timeNs % PERIOD_NS[p];
+        Bar& bar = state.Open[p];
+        if (bar.Ticks != 0 && start > bar.StartNs) CloseBar(index, state, period);
+        if (bar.Ticks != 0 && start < bar.StartNs) {
+            // 迟到行情：只计入当前 K 线的成交量和持仓量
+            late = true;
+            bar.Volume += volume;
+            bar.Turnover += turnover;
+            bar.OpenInterestChange += f.OpenInterest - bar.OpenInterest;
+            bar.OpenInterest = f.OpenInterest;
+            continue;
+        }
+        if (bar.Ticks == 0) {
+            bar.StartNs = start;
+            bar.TradingDay = tradingDay;
+            bar.Open = bar.High = bar.Low = bar.Close = DBL_MAX;
+            bar.Volume = 0;
+            bar.Turnover = 0;
+            bar.OpenInterestChange = 0;
+            bar.OpenInterest = openInterestBefore;
+        }
+        ++bar.Ticks;
+        if (IsTradePrice(f.LastPrice)) {
+            if (bar.Open == DBL_MAX) {
+                bar.Open = bar.High = bar.Low = f.LastPrice;
+            } else {
+                if (f.LastPrice > bar.High) bar.High = f.LastPrice;
+                if (f.LastPrice < bar.Low) bar.Low = f.LastPrice;
+            }
+            bar.Close = f.LastPrice;
+        }
+        bar.Volume += volume;
+        bar.Turnover += turnover;
+        bar.OpenInterestChange += f.OpenInterest - bar.OpenInterest;
+        bar.OpenInterest = f.OpenInterest;
+    }
+    if (late) m_nLateTicks.store(m_nLateTicks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (timeNs > m_nClockNs) {
+        m_nClockNs = timeNs;
+        m_nClockOffsetNs = timeNs - WallClockNanos();
+        if (m_nClockNs >= m_nNextSweepNs) Sweep(m_nClockNs);
+    }
+}
+
+// 交易所时钟每前进一秒检查一次：没有新行情的合约，区间终点早于时钟 BAR_CLOSE_DELAY_MS 以上的 K 线收盘
+void BarBuilder::Sweep(int64_t clockNs) {
+    int64_t limit = clockNs - static_cast<int64_t>(BAR_CLOSE_DELAY_MS) * 1000000LL;
+    for (size_t i = 0; i < m_active.size(); ++i) {
+        InstrumentBars& state = *m_instruments[m_active[i]].load(std::memory_order_relaxed);
+        for (int p = 0; p < PERIOD_COUNT; ++p) {
+            const Bar& bar = state.Open[p];
+            if (bar.Ticks != 0 && bar.StartNs + PERIOD_NS[p] <= limit) {
+                CloseBar(m_active[i], state, static_cast<Period>(p));
+            }
+        }
+    }
+    m_nNextSweepNs = clockNs - clockNs % NANOS_PER_SECOND + NANOS_PER_SECOND;
+}
+
+// 写入已收盘环并发布，随后清空未收盘的 K 线
+void BarBuilder::CloseBar(uint32_t index, InstrumentBars& state, Period period) {
+    Bar& bar = state.Open[period];
+    bar.Sequence = ++m_nSequence;
+
+    uint64_t position = state.Closed[period].load(std::memory_order_relaxed) + 1;
+    Slot& slot = state.Slots[period * m_nHistory + (position - 1) % m_nHistory];
+    uint64_t version = slot.Version.load(std::memory_order_relaxed);
+    slot.Version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.Position = position;
+    slot.Data = bar;
+    slot.Version.store(version + 2, std::memory_order_release);
+    state.Closed[period].store(position, std::memory_order_release);
+
+    if (m_pPublisher && m_pRegistry) {
+        size_t len = EncodeBar(m_frame, m_pRegistry->Name(index), period, bar);
+        m_pPublisher->Publish(m_frame, len, index * PERIOD_COUNT + period, bar.Sequence);
+    }
+    m_nPublished.store(m_nPublished.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    bar.Ticks = 0;
+}
+
+// 没有行情时交易所时钟不再前进，收盘前的最后几根 K 线要等到下一节的第一条行情才能收盘。
+// 空闲时用本地时钟加上最近一次推进时钟时的时间差（交易所时间 - 处理时的本地时间）估计交易所时钟。
+// 取处理时而不是行情中的接收时间：回放的接收时间来自录制文件，与当前本地时钟无关
+void BarBuilder::OnIdle() {
+    if (m_nClockNs != 0) {
+        int64_t clockNs = WallClockNanos() + m_nClockOffsetNs;
+        if (clockNs >= m_nNextSweepNs && clockNs > m_nClockNs) Sweep(clockNs);
+    }
+    if (m_pPublisher) m_pPublisher->OnIdle();
+}
+
+// 停止时发布所有有行情的未收盘 K 线（可能不完整），收盘后停止采集也不会丢失最后的 K 线
+void BarBuilder::OnStop() {
+    for (size_t i = 0; i < m_active.size(); ++i) {
+        InstrumentBars& state = *m_instruments[m_active[i]].load(std::memory_order_relaxed);
+        for (int p = 0; p < PERIOD_COUNT; ++p) {
+            if (state.Open[p].Ticks != 0) CloseBar(m_active[i], state, static_cast<Period>(p));
+        }
+    }
+    if (m_pPublisher) m_pPublisher->OnStop();
+}
+
+void BarBuilder::ReportStats() {
+    std::cerr << "=== BarBuilder: instruments=" << m_active.size()
+              << ", bars=" << m_nPublished.load(std::memory_order_relaxed)
+              << ", late_ticks=" << m_nLateTicks.load(std::memory_order_relaxed)
+              << ", untimed_ticks=" << m_nUntimedTicks.load(std::memory_order_relaxed)
+              << " ===" << std::endl;
+    if (m_pPublisher) m_pPublisher->ReportStats();
+}
+
+size_t BarBuilder::ReadBars(uint32_t index, Period period, Bar* out, size_t count) const {
+    if (index >= m_nCapacity) return 0;
+    const InstrumentBars* state = m_instruments[index].load(std::memory_order_acquire);
+    if (!state) return 0;
+    uint64_t closed = state->Closed[period].load(std::memory_order_acquire);
+    uint64_t first = closed > m_nHistory ? closed - m_nHistory : 0;
+    if (closed - first > count) first = closed - count;
+
+    size_t n = 0;
+    for (uint64_t position = first + 1; position <= closed; ++position) {
+        const Slot& slot = state->Slots[period * m_nHistory + (position - 1) % m_nHistory];
+        while (true) {
+            uint64_t before = slot.Version.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            uint64_t stored = slot.Position;
+            out[n] = slot.Data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.Version.load(std::memory_order_relaxed) != before) continue;
+            // 读取期间槽位已被更新的 K 线覆盖时跳过
+            if (stored == position) ++n;
+            break;
+        }
+    }
+    return n;
+}
+
+// 新客户端的快照：各合约各周期保留的已收盘 K 线中，序号不超过 lastSequence 的部分；
+// 更新的 K 线还在发布服务器的入站队列中，随后会经日志送达
+size_t BarBuilder::AppendSnapshot(std::string& out, uint64_t lastSequence) {
+    if (!m_pRegistry) return 0;
+    std::vector<Bar> bars(m_nHistory);
+    char frame[BAR_FRAME_SIZE];
+    size_t frames = 0;
+    uint32_t size = m_pRegistry->Size();
+    for (uint32_t i = 0; i < size && i < m_nCapacity; ++i) {
+        for (int p = 0; p < PERIOD_COUNT; ++p) {
+            size_t n = ReadBars(i, static_cast<Period>(p), bars.data(), bars.size());
+            for (size_t j = 0; j < n; ++j) {
+                if (bars[j].Sequence > lastSequence) continue;
+                out.append(frame, EncodeBar(frame, m_pRegistry->Name(i), static_cast<Period>(p), bars[j]));
+                ++frames;
+            }
+        }
+    }
+    return frames;
+}
+
+static char* AppendBarPrice(char* p, double price) {
+    if (price == DBL_MAX) {
+        APPEND_LITERAL(p, "null");
+        return p;
+    }
+    return NumberFormat::FormatDouble(p, price);
+}
+
+// {"Close":..,"High":..,"InstrumentID":"..","Low":..,"Open":..,"OpenInterest":..,"OpenInterestChange":..,
+//  "Period":"1m","Start":<纪元毫秒>,"Ticks":..,"TradingDay":"YYYYMMDD","Turnover":..,"Volume":..}
+size_t BarBuilder::EncodeBar(char* buf, const std::string& instrument, Period period, const Bar& bar) {
+    char* p = buf;
+    APPEND_LITERAL(p, "data: {\"Close\":");
+    p = AppendBarPrice(p, bar.Close);
+    APPEND_LITERAL(p, ",\"High\":");
+    p = AppendBarPrice(p, bar.High);
+    APPEND_LITERAL(p, ",\"InstrumentID\":\"");
+    size_t len = instrument.size() < 80 ? instrument.size() : 80;
+    memcpy(p, instrument.data(), len);
+    p += len;
+    APPEND_LITERAL(p, "\",\"Low\":");
+    p = AppendBarPrice(p, bar.Low);
+    APPEND_LITERAL(p, ",\"Open\":");
+    p = AppendBarPrice(p, bar.Open);
+    APPEND_LITERAL(p, ",\"OpenInterest\":");
+    p = NumberFormat::FormatDouble(p, bar.OpenInterest);
+    APPEND_LITERAL(p, ",\"OpenInterestChange\":");
+    p = NumberFormat::FormatDouble(p, bar.OpenInterestChange);
+    APPEND_LITERAL(p, ",\"Period\":\"");
+    const char* name = PeriodName(period);
+    memcpy(p, name, 2);
+    p += 2;
+    APPEND_LITERAL(p, "\",\"Start\":");
+    p = NumberFormat::FormatInt(p, bar.StartNs / 1000000LL);
+    APPEND_LITERAL(p, ",\"Ticks\":");
+    p = NumberFormat::FormatUInt(p, bar.Ticks);
+    APPEND_LITERAL(p, ",\"TradingDay\":\"");
+    p = NumberFormat::FormatUInt(p, bar.TradingDay);
+    APPEND_LITERAL(p, "\",\"Turnover\":");
+    p = NumberFormat::FormatDouble(p, bar.Turnover);
+    APPEND_LITERAL(p, ",\"Volume\":");
+    p = NumberFormat::FormatInt(p, bar.Volume);
+    APPEND_LITERAL(p, "}\n\n");
+    return p - buf;
+}
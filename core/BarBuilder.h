@@ -0,0 +1,125 @@
+#ifndef BAR_BUILDER_H
+#define BAR_BUILDER_H
+
+#include "TickSink.h"
+#include "InstrumentRegistry.h"
+#include "SseServer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// K 线合成（--bar-port=PORT 启用），作为流水线的输出端运行在工作线程中，
+// 把行情流增量合成为每个合约的 1 秒、1 分钟、5 分钟 OHLCV K 线：
+//   - 价格取 LastPrice，成交量、成交额取流水线计算的逐笔增量（TickContext::Delta()），
+//     持仓量记录收盘值及相对上一根 K 线的变化；
+//   - 每个合约的第一条行情增量为 0，累计量倒退的旧行情（KIND_STALE）不参与合成；
+//   - K 线按交易所时间划分和收盘：合约的下一条行情落入新区间时收盘，
+//     没有新行情的合约在交易所时钟（各合约行情时间的最大值，空闲时由本地时钟推算）越过区间终点
+//     BAR_CLOSE_DELAY_MS 后收盘，停止时有行情的未收盘 K 线全部发布；
+//     时间早于当前 K 线的迟到行情只计入成交量和持仓量。
+// 收盘的 K 线编码为 SSE 帧交给独立的 SseServer 作为单独的数据流推送，新客户端先收到各合约
+// 保留的历史 K 线。每个合约的状态和已收盘 K 线环（每个周期 BAR_HISTORY 根）在首条行情时分配，
+// 按合约编号索引；环的槽位带顺序锁，任意线程可以无锁读取。
+class BarBuilder : public TickSink, public SseSnapshotSource
+{
+public:
+    enum Period
+    {
+        PERIOD_1S,
+        PERIOD_1M,
+        PERIOD_5M,
+        PERIOD_COUNT
+    };
+
+    struct Bar
+    {
+        int64_t StartNs;            // 区间起点（交易所时间，UTC 纪元纳秒）
+        uint64_t Sequence;          // 发布序号，从 1 开始
+        uint32_t TradingDay;        // YYYYMMDD
+        uint32_t Ticks;             // 区间内的行情数
+        double Open;                // 区间内没有有效成交价时四个价格均为 DBL_MAX
+        double High;
+        double Low;
+        double Close;
+        int64_t Volume;
+        double Turnover;
+        double OpenInterest;        // 收盘时的持仓量
+        double OpenInterestChange;  // 相对区间开始前的持仓量变化
+    };
+
+    BarBuilder(uint32_t instrumentCapacity, uint32_t history);
+    ~BarBuilder();
+
+    // 以下设置须在流水线启动之前调用
+    void SetRegistry(const InstrumentRegistry* pRegistry) { m_pRegistry = pRegistry; }
+    void SetPublisher(SseServer* pPublisher) { m_pPublisher = pPublisher; }
+
+    virtual void OnTick(TickContext& ctx) override;
+    virtual void OnIdle() override;
+    virtual void OnStop() override;
+    virtual void ReportStats() override;
+    virtual const char* Name() const override { return "bars"; }
+    virtual uint64_t BytesOut() const override { return m_pPublisher ? m_pPublisher->BytesOut() : 0; }
+
+    // 读取合约最近至多 count 根已收盘的 K 线（由旧到新），返回根数；任意线程
+    size_t ReadBars(uint32_t index, Period period, Bar* out, size_t count) const;
+
+    // SseSnapshotSource：在发布服务器的线程中调用
+    virtual size_t AppendSnapshot(std::string& out, uint64_t lastSequence) override;
+
+    static const char* PeriodName(Period period);
+
+    // 编码为 SSE 帧（"data: {...}\n\n"），buf 至少 BAR_FRAME_SIZE 字节，返回帧长度
+    static const size_t BAR_FRAME_SIZE = 512;
+    static size_t EncodeBar(char* buf, const std::string& instrument, Period period, const Bar& bar);
+
+private:
+    // 已收盘 K 线环中的一个槽位
+    struct Slot
+    {
+        std::atomic<uint64_t> Version{0};   // 奇数表示正在写入
+        uint64_t Position = 0;              // 该槽位保存的是第几根已收盘的 K 线（从 1 开始）
+        Bar Data;
+    };
+
+    struct InstrumentBars
+    {
+        InstrumentBars(uint32_t history);
+
+        // 以下只在工作线程中访问
+        int64_t PendingVolume;      // 无法归入区间的行情的增量，计入该合约的下一条行情
+        double PendingTurnover;
+        Bar Open[PERIOD_COUNT];     // 未收盘的 K 线，Ticks 为 0 表示没有
+
+        std::atomic<uint64_t> Closed[PERIOD_COUNT];    // 已收盘的根数
+        std::unique_ptr<Slot[]> Slots;                  // PERIOD_COUNT 个环，每个 history 个槽位
+    };
+
+    InstrumentBars* Acquire(uint32_t index);
+    void CloseBar(uint32_t index, InstrumentBars& state, Period period);
+    void Sweep(int64_t clockNs);
+
+    uint32_t m_nCapacity;
+    uint32_t m_nHistory;
+    const InstrumentRegistry* m_pRegistry;
+    SseServer* m_pPublisher;
+
+    // 合约编号 -> 状态，首条行情时由工作线程分配
+    std::unique_ptr<std::atomic<InstrumentBars*>[]> m_instruments;
+    std::vector<uint32_t> m_active;     // 已分配状态的合约编号，仅工作线程使用
+    int64_t m_nClockNs;                 // 交易所时钟：已见行情时间的最大值
+    int64_t m_nClockOffsetNs;           // 最近推进时钟时交易所时间减本地时间，空闲时据此估计时钟
+    int64_t m_nNextSweepNs;             // 交易所时钟到达该时间时检查所有未收盘的 K 线
+    uint64_t m_nSequence;               // 已发布的 K 线数
+    char m_frame[BAR_FRAME_SIZE];       // 工作线程的编码缓冲区
+
+    std::atomic<uint64_t> m_nPublished;
+    std::atomic<uint64_t> m_nLateTicks;     // 早于当前 K 线区间的行情数
+    std::atomic<uint64_t> m_nUntimedTicks;  // UpdateTime 不合法、无法归入区间的行情数
+};
+
+#endif // BAR_BUILDER_H
@@ -0,0 +1,144 @@
+#include "BatchWriter.h"
+#include "LatencyHistogram.h"
+#include "TickRecord.h"
+#include "Tsc.h"
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <unistd.h>
+
+// 暂存区至少预留的容量，保证单帧较大时也无需扩容
+static const size_t MIN_BUFFER_SIZE = 64 * 1024;
+
+BatchWriter::BatchWriter(int fd, const Policy& policy)
+    : m_fd(fd), m_policy(policy), m_nUsed(0), m_nFrames(0), m_nFirstFrameNs(0),
+      m_pWriteLatency(nullptr), m_pTotalLatency(nullptr),
+      m_nSyscalls(0), m_nFramesWritten(0), m_nBytesWritten(0), m_nErrors(0) {
+    if (m_policy.MaxFrames == 0) m_policy.MaxFrames = 1;
+    if (m_policy.MaxBytes == 0) m_policy.MaxBytes = 1;
+    m_buffer.resize(m_policy.MaxBytes + MIN_BUFFER_SIZE);
+}
+
+void BatchWriter::SetLatencyHistograms(LatencyHistogram* pWrite, LatencyHistogram* pTotal) {
+    m_pWriteLatency = pWrite;
+    m_pTotalLatency = pTotal;
+    // 一个批次最多 MaxFrames 帧，加上超大帧直接写出的一帧
+    if (m_pWriteLatency || m_pTotalLatency) m_stamps.reserve(m_policy.MaxFrames + 1);
+}
+
+void BatchWriter::Append(const char* data, size_t len, uint64_t entryTsc, uint64_t encodedTsc) {
+    bool stamped = entryTsc != 0 && (m_pWriteLatency || m_pTotalLatency);
+
+    // 单帧超过暂存区容量：与暂存数据一起用一次 writev 直接写出，不做拷贝
+    if (len > m_buffer.size()) {
+        struct iovec iov[2];
+        int count = 0;
+        if (m_nUsed > 0) {
+            iov[count].iov_base = m_buffer.data();
+            iov[count].iov_len = m_nUsed;
+            ++count;
+        }
+        iov[count].iov_base = const_cast<char*>(data);
+        iov[count].iov_len = len;
+        ++count;
+        if (stamped) m_stamps.push_back(FrameStamp{entryTsc, encodedTsc});
+        RecordLatency(WriteAll(iov, count));
+        m_nFramesWritten.store(m_nFramesWritten.load(std::memory_order_relaxed) + m_nFrames + 1, std::memory_order_relaxed);
+        m_nUsed = 0;
+        m_nFrames = 0;
+        return;
+    }
+
+    if (m_nUsed + len > m_buffer.size()) Flush();
+
+    if (m_nFrames == 0 && m_policy.MaxDelayUs > 0) m_nFirstFrameNs = MonotonicNanos();
+    memcpy(m_buffer.data() + m_nUsed, data, len);
+    m_nUsed += len;
+    ++m_nFrames;
+    if (stamped) m_stamps.push_back(FrameStamp{entryTsc, encodedTsc});
+
+    if (m_nUsed >= m_policy.MaxBytes || m_nFrames >= m_policy.MaxFrames) {
+        Flush();
+    } else if (m_policy.MaxDelayUs > 0) {
+        Poll(MonotonicNanos());
+    }
+}
+
+void BatchWriter::OnIdle() {
+    if (m_policy.FlushWhenIdle) Flush();
+}
+
+void BatchWriter::Poll(int64_t nowNs) {
+    if (m_nFrames != 0 && m_policy.MaxDelayUs > 0 &&
+        nowNs - m_nFirstFrameNs >= m_policy.MaxDelayUs * 1000) {
+        Flush();
+    }
+}
+
+int64_t BatchWriter::NanosUntilDeadline(int64_t nowNs) const {
+    if (m_nFrames == 0 || m_policy.MaxDelayUs <= 0) return -1;
+    int64_t remaining = m_nFirstFrameNs + m_policy.MaxDelayUs * 1000 - nowNs;
+    return remaining > 0 ? remaining : 0;
+}
+
+void BatchWriter::Flush() {
+    if (m_nFrames == 0) return;
+
+    // 暂存区中的帧是连续存放的，合并为一个向量即可
+    struct iovec iov;
+    iov.iov_base = m_buffer.data();
+    iov.iov_len = m_nUsed;
+    RecordLatency(WriteAll(&iov, 1));
+
+    m_nFramesWritten.store(m_nFramesWritten.load(std::memory_order_relaxed) + m_nFrames, std::memory_order_relaxed);
+    m_nUsed = 0;
+    m_nFrames = 0;
+}
+
+// 处理部分写入和 EINTR，直到全部写出（返回 true）或发生错误
+bool BatchWriter::WriteAll(struct iovec* iov, int count) {
+    while (count > 0) {
+        ssize_t n = writev(m_fd, iov, count > IOV_MAX ? IOV_MAX : count);
+        CountSyscall();
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            m_nErrors.store(m_nErrors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        m_nBytesWritten.store(m_nBytesWritten.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+
+        size_t written = static_cast<size_t>(n);
+        while (count > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+
+// 批次写出后记录其中各帧的延迟，写出失败的批次不计入
+void BatchWriter::RecordLatency(bool written) {
+    if (m_stamps.empty()) return;
+    if (written) {
+        uint64_t now = ReadTsc();
+        for (size_t i = 0; i < m_stamps.size(); ++i) {
+            if (m_pWriteLatency) m_pWriteLatency->Record(TscElapsed(m_stamps[i].EncodedTsc, now));
+            if (m_pTotalLatency) m_pTotalLatency->Record(TscElapsed(m_stamps[i].EntryTsc, now));
+        }
+    }
+    m_stamps.clear();
+}
+
+BatchWriter::Stats BatchWriter::GetStats() const {
+    Stats stats;
+    stats.Syscalls = m_nSyscalls.load(std::memory_order_relaxed);
+    stats.Frames = m_nFramesWritten.load(std::memory_order_relaxed);
+    stats.Bytes = m_nBytesWritten.load(std::memory_order_relaxed);
+    stats.Errors = m_nErrors.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,92 @@
+#ifndef BATCH_WRITER_H
+#define BATCH_WRITER_H
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class LatencyHistogram;
+
+// 批量输出器
+// 将编码好的帧暂存在预分配的缓冲区中，按策略合并成一次 writev 系统调用写出，
+// 避免每条行情都产生一次 write(2)。非线程安全，只应在流水线工作线程中使用。
+class BatchWriter
+{
+public:
+    // 刷新策略：满足任一条件即写出
+    struct Policy
+    {
+        size_t MaxBytes;      // 暂存字节数达到该值时写出
+        size_t MaxFrames;     // 暂存帧数达到该值时写出
+        int64_t MaxDelayUs;   // 最早一帧暂存超过该时间（微秒）时写出，0 表示不限制
+        bool FlushWhenIdle;   // 上游队列为空时立即写出
+    };
+
+    // 输出统计，只由工作线程写入，可在任意线程读取
+    struct Stats
+    {
+        uint64_t Syscalls;    // writev 调用次数
+        uint64_t Frames;      // 已写出的帧数
+        uint64_t Bytes;       // 已写出的字节数
+        uint64_t Errors;      // 写出失败次数（失败的批次被丢弃）
+    };
+
+    BatchWriter(int fd, const Policy& policy);
+
+    // 设置后，带时间戳的帧在所在批次写出成功时记录 编码完成 -> 写出（pWrite）和 入口 -> 写出（pTotal）
+    // 两段延迟（TSC 周期）；须在第一次 Append() 之前调用
+    void SetLatencyHistograms(LatencyHistogram* pWrite, LatencyHistogram* pTotal);
+
+    // 追加一帧，数据会被拷贝；满足策略时立即写出
+    // entryTsc 和 encodedTsc 为该帧的入口和编码完成时间戳，为 0 时（流头、合约定义等）不计入延迟统计
+    void Append(const char* data, size_t len, uint64_t entryTsc = 0, uint64_t encodedTsc = 0);
+
+    // 上游暂时没有数据时调用
+    void OnIdle();
+
+    // 检查延迟上限，超时则写出；nowNs 为单调时钟
+    void Poll(int64_t nowNs);
+
+    // 距离下一次因延迟上限而必须写出的时间（纳秒），没有暂存数据时返回 -1
+    int64_t NanosUntilDeadline(int64_t nowNs) const;
+
+    // 立即写出所有暂存数据
+    void Flush();
+
+    bool Empty() const { return m_nFrames == 0; }
+    Stats GetStats() const;
+
+private:
+    // 一帧的时间戳
+    struct FrameStamp
+    {
+        uint64_t EntryTsc;
+        uint64_t EncodedTsc;
+    };
+
+    bool WriteAll(struct iovec* iov, int count);
+    void RecordLatency(bool written);
+    void CountSyscall() { m_nSyscalls.store(m_nSyscalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    int m_fd;
+    Policy m_policy;
+
+    std::vector<char> m_buffer;         // 帧暂存区
+    size_t m_nUsed;                     // 暂存区已用字节数
+    size_t m_nFrames;                   // 暂存帧数
+    int64_t m_nFirstFrameNs;            // 当前批次第一帧的暂存时间
+
+    LatencyHistogram* m_pWriteLatency;
+    LatencyHistogram* m_pTotalLatency;
+    std::vector<FrameStamp> m_stamps;   // 当前批次中带时间戳的帧
+
+    std::atomic<uint64_t> m_nSyscalls;
+    std::atomic<uint64_t> m_nFramesWritten;
+    std::atomic<uint64_t> m_nBytesWritten;
+    std::atomic<uint64_t> m_nErrors;
+};
+
+#endif // BATCH_WRITER_H
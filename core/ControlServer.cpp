@@ -0,0 +1,289 @@
+#include "ControlServer.h"
+#include "TickPipeline.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// 单个连接未成行输入的上限，超出后断开
+static const size_t MAX_LINE_BYTES = 1024 * 1024;
+// 同时保持的连接数上限
+static const size_t MAX_CONNECTIONS = 64;
+
+ControlServer::ControlServer()
+    : m_nListenFd(-1), m_nEventFd(-1), m_bRunning(false), m_pPipeline(nullptr) {}
+
+ControlServer::~ControlServer() {
+    Stop();
+}
+
+bool ControlServer::Start(const char* path, const std::vector<SubscriptionManager*>& subscriptions) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        std::cerr << "Control socket path too long: " << path << std::endl;
+        return false;
+    }
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    m_nListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_nListenFd < 0) {
+        std::cerr << "socket failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    // 上次运行遗留的套接字文件
+    unlink(path);
+    if (bind(m_nListenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(m_nListenFd, 16) != 0) {
+        std::cerr << "bind/listen on " << path << " failed: " << strerror(errno) << std::endl;
+        close(m_nListenFd);
+        m_nListenFd = -1;
+        return false;
+    }
+    m_nEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_nEventFd < 0) {
+        std::cerr << "eventfd creation failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_path = path;
+    m_subscriptions = subscriptions;
+    m_bRunning = true;
+    m_thread = std::thread(&ControlServer::Run, this);
+    std::cerr << "Control socket listening on " << path << std::endl;
+    return true;
+}
+
+void ControlServer::Stop() {
+    if (m_bRunning.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t ret = write(m_nEventFd, &one, sizeof(one));
+        (void)ret;
+        if (m_thread.joinable()) m_thread.join();
+    }
+    for (size_t i = 0; i < m_connections.size(); ++i) close(m_connections[i].Fd);
+    m_connections.clear();
+    if (m_nListenFd >= 0) {
+        close(m_nListenFd);
+        unlink(m_path.c_str());
+    }
+    if (m_nEventFd >= 0) close(m_nEventFd);
+    m_nListenFd = m_nEventFd = -1;
+}
+
+void ControlServer::Run() {
+    std::vector<struct pollfd> fds;
+    std::vector<Line> lines;
+    std::vector<SubscriptionManager::Command> commands;
+
+    while (m_bRunning.load()) {
+        fds.clear();
+        fds.push_back({m_nEventFd, POLLIN, 0});
+        fds.push_back({m_nListenFd, POLLIN, 0});
+        for (size_t i = 0; i < m_connections.size(); ++i) {
+            short events = POLLIN;
+            if (!m_connections[i].Out.empty()) events |= POLLOUT;
+            fds.push_back({m_connections[i].Fd, events, 0});
+        }
+        int n = poll(fds.data(), fds.size(), -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "poll failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (fds[0].revents) break;
+
+        // 先读完所有连接，再把本轮的增删命令一次性交给 SubscriptionManager
+        lines.clear();
+        commands.clear();
+        for (size_t i = 0; i < m_connections.size(); ++i) {
+            if (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) ReadConnection(i, lines, commands);
+        }
+        ApplyCommands(commands);
+        Reply(lines, commands);
+
+        for (size_t i = 0; i < m_connections.size();) {
+            Connection& conn = m_connections[i];
+            FlushConnection(conn);
+            if (conn.Fd < 0 || (conn.Closing && conn.Out.empty())) {
+                if (conn.Fd >= 0) close(conn.Fd);
+                m_connections.erase(m_connections.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+        if (fds[1].revents & POLLIN) Accept();
+    }
+}
+
+// 冗余前置时多个会话都拥有同一合约：各会话分别应用，每条命令取最好的结果
+// （Applied > Unchanged > Unknown > Rejected），不让最后一个会话的结果覆盖前面的
+void ControlServer::ApplyCommands(std::vector<SubscriptionManager::Command>& commands) {
+    if (commands.empty()) return;
+    m_results.assign(commands.size(), SubscriptionManager::CommandResult::Rejected);
+    for (size_t i = 0; i < m_subscriptions.size(); ++i) {
+        for (size_t j = 0; j < commands.size(); ++j) commands[j].Result = SubscriptionManager::CommandResult::Rejected;
+        m_subscriptions[i]->Apply(commands);
+        for (size_t j = 0; j < commands.size(); ++j) {
+            if (commands[j].Result < m_results[j]) m_results[j] = commands[j].Result;
+        }
+    }
+    for (size_t j = 0; j < commands.size(); ++j) commands[j].Result = m_results[j];
+}
+
+void ControlServer::Accept() {
+    while (true) {
+        int fd = accept4(m_nListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "accept failed: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        if (m_connections.size() >= MAX_CONNECTIONS) {
+            close(fd);
+            continue;
+        }
+        Connection conn;
+        conn.Fd = fd;
+        conn.Closing = false;
+        m_connections.push_back(conn);
+    }
+}
+
+void ControlServer::ReadConnection(size_t index, std::vector<Line>& lines,
+                                   std::vector<SubscriptionManager::Command>& commands) {
+    Connection& conn = m_connections[index];
+    char buf[4096];
+    while (true) {
+        ssize_t n = read(conn.Fd, buf, sizeof(buf));
+        if (n > 0) {
+            conn.In.append(buf, n);
+            continue;
+        }
+        if (n == 0) {
+            conn.Closing = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            conn.Closing = true;
+            conn.Out.clear();
+        }
+        break;
+    }
+
+    size_t start = 0;
+    size_t eol;
+    while ((eol = conn.In.find('\n', start)) != std::string::npos) {
+        ParseLine(index, conn.In.substr(start, eol - start), lines, commands);
+        start = eol + 1;
+    }
+    conn.In.erase(0, start);
+    // 对端关闭时最后一行可以没有换行符
+    if (conn.Closing && !conn.In.empty()) {
+        ParseLine(index, conn.In, lines, commands);
+        conn.In.clear();
+    }
+    if (conn.In.size() > MAX_LINE_BYTES) {
+        conn.In.clear();
+        conn.Out += "error line too long\n";
+        conn.Closing = true;
+    }
+}
+
+void ControlServer::ParseLine(size_t index, const std::string& text, std::vector<Line>& lines,
+                              std::vector<SubscriptionManager::Command>& commands) {
+    std::istringstream in(text);
+    Line line;
+    line.Connection = index;
+    line.FirstCommand = commands.size();
+    line.CommandCount = 0;
+    if (!(in >> line.Verb)) return;     // 空行
+
+    bool add = line.Verb == "add" || line.Verb == "sub";
+    bool remove = line.Verb == "remove" || line.Verb == "unsub";
+    if (add || remove) {
+        SubscriptionManager::Command cmd;
+        cmd.Add = add;
+        cmd.Result = SubscriptionManager::CommandResult::Rejected;
+        while (in >> cmd.InstrumentID) {
+            commands.push_back(cmd);
+            ++line.CommandCount;
+        }
+    }
+    lines.push_back(line);
+}
+
+void ControlServer::Reply(const std::vector<Line>& lines, const std::vector<SubscriptionManager::Command>& commands) {
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const Line& line = lines[i];
+        std::string& out = m_connections[line.Connection].Out;
+        if (line.Verb == "add" || line.Verb == "sub" || line.Verb == "remove" || line.Verb == "unsub") {
+            if (line.CommandCount == 0) {
+                out += "error " + line.Verb + " needs at least one instrument\n";
+                continue;
+            }
+            int counts[4] = {0, 0, 0, 0};
+            for (size_t j = 0; j < line.CommandCount; ++j) {
+                ++counts[static_cast<int>(commands[line.FirstCommand + j].Result)];
+            }
+            out += "ok applied=" + std::to_string(counts[0]) + " unchanged=" + std::to_string(counts[1]) +
+                   " unknown=" + std::to_string(counts[2]) + " rejected=" + std::to_string(counts[3]) + "\n";
+        } else if (line.Verb == "list") {
+            std::string list;
+            for (size_t j = 0; j < m_subscriptions.size(); ++j) m_subscriptions[j]->List(list);
+            size_t count = 0;
+            for (size_t j = 0; j < list.size(); ++j) count += list[j] == '\n';
+            out += list;
+            out += "ok " + std::to_string(count) + "\n";
+        } else if (line.Verb == "stats") {
+            uint64_t total = 0, subscribed = 0, failed = 0, requests = 0, retries = 0;
+            for (size_t j = 0; j < m_subscriptions.size(); ++j) {
+                SubscriptionManager::Stats stats = m_subscriptions[j]->GetStats();
+                total += stats.Total;
+                subscribed += stats.Subscribed;
+                failed += stats.Failed;
+                requests += stats.Requests;
+                retries += stats.Retries;
+            }
+            out += "ok total=" + std::to_string(total) + " subscribed=" + std::to_string(subscribed) +
+                   " failed=" + std::to_string(failed) + " requests=" + std::to_string(requests) +
+                   " retries=" + std::to_string(retries) + "\n";
+        } else if (line.Verb == "latency") {
+            std::string report = m_pPipeline ? m_pPipeline->DescribeLatency() : std::string();
+            if (report.empty()) {
+                out += "error latency stats disabled\n";
+                continue;
+            }
+            size_t count = 0;
+            for (size_t j = 0; j < report.size(); ++j) count += report[j] == '\n';
+            out += report;
+            out += "ok " + std::to_string(count) + "\n";
+        } else {
+            out += "error unknown command " + line.Verb + "\n";
+        }
+    }
+}
+
+void ControlServer::FlushConnection(Connection& conn) {
+    while (conn.Fd >= 0 && !conn.Out.empty()) {
+        ssize_t n = send(conn.Fd, conn.Out.data(), conn.Out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.Out.erase(0, n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                close(conn.Fd);
+                conn.Fd = -1;
+            }
+            return;
+        }
+    }
+}
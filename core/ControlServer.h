@@ -0,0 +1,74 @@
+#ifndef CONTROL_SERVER_H
+#define CONTROL_SERVER_H
+
+#include "SubscriptionManager.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TickPipeline;
+
+// 本地控制通道（--control=PATH），在 Unix 域套接字上接受文本命令，运行中增删订阅的合约：
+//   add ID [ID ...]      加入订阅（别名 sub）
+//   remove ID [ID ...]   取消订阅（别名 unsub）
+//   list                 列出订阅集合及每个合约的状态，以 "ok N" 结束
+//   stats                订阅统计
+//   latency              流水线各阶段自启动以来的延迟分布（每阶段一行），以 "ok N" 结束
+// 每行命令回复一行 "ok ..." 或 "error ..."。一轮 poll 中从所有连接读到的增删命令
+// 合并为一次 SubscriptionManager::Apply()，最终由发送线程合并成一次 API 调用。
+// 多会话时命令交给每个会话的 SubscriptionManager，由其按 SessionRouter 认领本会话的合约。
+// 例：printf 'add au2606 ag2606\n' | socat - UNIX-CONNECT:/tmp/ctp-md.sock
+class ControlServer
+{
+public:
+    ControlServer();
+    ~ControlServer();
+
+    // 设置后才支持 latency 命令，须在 Start() 之前调用
+    void SetPipeline(const TickPipeline* pPipeline) { m_pPipeline = pPipeline; }
+
+    // 在 path 上监听并启动控制线程，失败时返回 false 并在 stderr 输出原因
+    bool Start(const char* path, const std::vector<SubscriptionManager*>& subscriptions);
+    void Stop();
+
+private:
+    struct Connection
+    {
+        int Fd;
+        std::string In;             // 尚未成行的输入
+        std::string Out;            // 尚未写出的回复
+        bool Closing;               // 对端已关闭输入，写完回复后关闭
+    };
+
+    // 本轮读到的一行命令
+    struct Line
+    {
+        size_t Connection;          // m_connections 下标
+        std::string Verb;
+        size_t FirstCommand;        // 增删命令在合并列表中的范围
+        size_t CommandCount;
+    };
+
+    void Run();
+    void Accept();
+    void ReadConnection(size_t index, std::vector<Line>& lines, std::vector<SubscriptionManager::Command>& commands);
+    void ParseLine(size_t index, const std::string& text, std::vector<Line>& lines,
+                   std::vector<SubscriptionManager::Command>& commands);
+    void ApplyCommands(std::vector<SubscriptionManager::Command>& commands);
+    void Reply(const std::vector<Line>& lines, const std::vector<SubscriptionManager::Command>& commands);
+    void FlushConnection(Connection& conn);
+
+    std::string m_path;
+    int m_nListenFd;
+    int m_nEventFd;
+    std::thread m_thread;
+    std::atomic<bool> m_bRunning;
+    std::vector<SubscriptionManager*> m_subscriptions;
+    std::vector<SubscriptionManager::CommandResult> m_results;     // ApplyCommands() 合并结果用
+    const TickPipeline* m_pPipeline;
+    std::vector<Connection> m_connections;      // 只在控制线程中访问
+};
+
+#endif // CONTROL_SERVER_H
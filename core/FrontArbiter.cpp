@@ -0,0 +1,115 @@
+#include "FrontArbiter.h"
+#include <cstring>
+#include <iostream>
+
+FrontArbiter::FrontArbiter(const std::vector<std::string>& fronts, const std::vector<uint32_t>& laneFronts,
+                           uint32_t instrumentCapacity)
+    : m_fronts(fronts), m_laneFronts(laneFronts), m_states(instrumentCapacity), m_counters(fronts.size()) {
+    memset(m_states.data(), 0, sizeof(InstrumentState) * m_states.size());
+}
+
+// 键的各字段先各自混合再组合，最低位固定为 1，0 表示空条目
+uint64_t FrontArbiter::TickKey(const CThostFtdcDepthMarketDataField& field) {
+    uint64_t time = 0;
+    memcpy(&time, field.UpdateTime, 8);     // HH:MM:SS
+    uint64_t turnover = 0;
+    memcpy(&turnover, &field.Turnover, sizeof(turnover));
+    uint64_t h = time ^ (static_cast<uint64_t>(static_cast<uint32_t>(field.UpdateMillisec)) << 32 |
+                         static_cast<uint32_t>(field.Volume));
+    h = (h ^ (h >> 31)) * 0x9E3779B97F4A7C15ULL;
+    h ^= turnover;
+    h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ULL;
+    return (h ^ (h >> 32)) | 1;
+}
+
+// 交易日内单调的行情时间（毫秒）加 1，UpdateTime 不合法时返回 0。
+// 夜盘跨越午夜但属于同一交易日，18 点以后的时间排在前面：21:00 < 次日 01:00 < 09:00 < 15:00
+uint32_t FrontArbiter::SessionTimeKey(const CThostFtdcDepthMarketDataField& field) {
+    const char* t = field.UpdateTime;
+    if (t[2] != ':' || t[5] != ':') return 0;
+    const int digits[] = {0, 1, 3, 4, 6, 7};
+    for (int i = 0; i < 6; ++i) {
+        if (t[digits[i]] < '0' || t[digits[i]] > '9') return 0;
+    }
+    uint32_t seconds = ((t[0] - '0') * 10 + (t[1] - '0')) * 3600 + ((t[3] - '0') * 10 + (t[4] - '0')) * 60 +
+                       (t[6] - '0') * 10 + (t[7] - '0');
+    seconds = seconds >= 18 * 3600 ? seconds - 18 * 3600 : seconds + 6 * 3600;
+    return seconds * 1000 + static_cast<uint32_t>(field.UpdateMillisec % 1000) + 1;
+}
+
+bool FrontArbiter::Accept(uint32_t index, size_t lane, const TickRecord& tick) {
+    if (index >= m_states.size()) return true;
+    const CThostFtdcDepthMarketDataField& field = tick.Field;
+    uint32_t front = m_laneFronts[lane];
+    Counters& counters = m_counters[front];
+    InstrumentState& state = m_states[index];
+
+    // 新交易日成交量从零开始；前一交易日的行情只可能是落后的副本
+    uint32_t day = ParseTradingDay(field.TradingDay);
+    if (day != 0 && day != state.TradingDay) {
+        if (day < state.TradingDay) {
+            Increment(counters.Stale);
+            return false;
+        }
+        state.TradingDay = day;
+        state.TimeKey = 0;
+        state.Volume = 0;
+    }
+
+    uint64_t key = TickKey(field);
+    for (uint32_t i = 0; i < WINDOW; ++i) {
+        const Entry& entry = state.Recent[i];
+        if (entry.Key != key) continue;
+        // 同一前置重复推送（如重新订阅后的快照）不计入胜负
+        if (entry.Front != front) {
+            int64_t lag = tick.RecvTimeNs - entry.RecvTimeNs;
+            Increment(counters.Losses);
+            counters.LagSumNs.store(counters.LagSumNs.load(std::memory_order_relaxed) + lag, std::memory_order_relaxed);
+            if (lag > counters.LagMaxNs.load(std::memory_order_relaxed)) {
+                counters.LagMaxNs.store(lag, std::memory_order_relaxed);
+            }
+        }
+        return false;
+    }
+    uint32_t timeKey = SessionTimeKey(field);
+    if (field.Volume < state.Volume || (timeKey != 0 && timeKey < state.TimeKey)) {
+        Increment(counters.Stale);
+        return false;
+    }
+
+    state.Volume = field.Volume;
+    if (timeKey != 0) state.TimeKey = timeKey;
+    Entry& entry = state.Recent[state.Next];
+    entry.Key = key;
+    entry.RecvTimeNs = tick.RecvTimeNs;
+    entry.Front = front;
+    state.Next = (state.Next + 1) % WINDOW;
+    Increment(counters.Wins);
+    return true;
+}
+
+FrontArbiter::FrontStats FrontArbiter::GetStats(size_t front) const {
+    const Counters& counters = m_counters[front];
+    FrontStats stats;
+    stats.Wins = counters.Wins.load(std::memory_order_relaxed);
+    stats.Losses = counters.Losses.load(std::memory_order_relaxed);
+    stats.Stale = counters.Stale.load(std::memory_order_relaxed);
+    stats.LagSumNs = counters.LagSumNs.load(std::memory_order_relaxed);
+    stats.LagMaxNs = counters.LagMaxNs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FrontArbiter::ReportStats() const {
+    for (size_t i = 0; i < m_fronts.size(); ++i) {
+        FrontStats stats = GetStats(i);
+        uint64_t total = stats.Wins + stats.Losses;
+        std::cerr << "=== FrontArbiter: front=" << m_fronts[i]
+                  << ", wins=" << stats.Wins
+                  << ", losses=" << stats.Losses
+                  << ", stale=" << stats.Stale
+                  << ", win_rate=" << (total > 0 ? static_cast<double>(stats.Wins) / total : 0.0)
+                  << ", avg_lag_us=" << (stats.Losses > 0 ? stats.LagSumNs / 1e3 / stats.Losses : 0.0)
+                  << ", max_lag_us=" << stats.LagMaxNs / 1e3
+                  << " ===" << std::endl;
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef FRONT_ARBITER_H
+#define FRONT_ARBITER_H
+
+#include "TickRecord.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 冗余前置仲裁：多个前置订阅相同的合约时，同一条行情只放行最先到达的一份。
+// 行情以合约加 (UpdateTime, UpdateMillisec, Volume, Turnover) 识别。每个合约记住最近放行的
+// WINDOW 条行情的键、来源前置和接收时间，后到的副本据此计入各前置的胜负和落后时间；
+// 成交量小于已放行行情的，或行情时间早于已放行行情的（同一交易日内），视为落后太多的旧行情，同样丢弃：
+// 落后超过 WINDOW 条的前置重发的无成交报价行情成交量不变，只能靠行情时间识别。
+// 某个前置断线时另一个前置的行情自然成为最先到达者，无需切换。
+// 只在流水线的工作线程中调用 Accept()，统计可在任意线程读取。
+class FrontArbiter
+{
+public:
+    static const uint32_t WINDOW = 8;
+
+    struct FrontStats
+    {
+        uint64_t Wins;          // 最先到达并放行的行情数
+        uint64_t Losses;        // 其他前置已放行的副本数
+        uint64_t Stale;         // 比已放行行情更旧的行情数
+        int64_t LagSumNs;       // 副本相对于最先到达者的落后时间之和
+        int64_t LagMaxNs;
+    };
+
+    // laneFronts：流水线队列编号 -> 前置编号
+    FrontArbiter(const std::vector<std::string>& fronts, const std::vector<uint32_t>& laneFronts,
+                 uint32_t instrumentCapacity);
+
+    // 行情是否应当放行；index 为 INVALID_INDEX（未注册合约）时总是放行
+    bool Accept(uint32_t index, size_t lane, const TickRecord& tick);
+
+    size_t FrontCount() const { return m_fronts.size(); }
+    const std::string& FrontName(size_t front) const { return m_fronts[front]; }
+    FrontStats GetStats(size_t front) const;
+
+    // 输出各前置的胜率和落后时间到 stderr
+    void ReportStats() const;
+
+private:
+    struct Entry
+    {
+        uint64_t Key;
+        int64_t RecvTimeNs;
+        uint32_t Front;
+    };
+
+    struct InstrumentState
+    {
+        uint32_t TradingDay;    // YYYYMMDD，0 表示尚无行情
+        uint32_t Next;          // Recent 中下一个写入位置
+        uint32_t TimeKey;       // 已放行行情的最大行情时间（SessionTimeKey），0 表示尚无
+        int64_t Volume;         // 已放行行情的最大成交量
+        Entry Recent[WINDOW];
+    };
+
+    // 单一写入线程，读取方可在任意线程
+    struct Counters
+    {
+        std::atomic<uint64_t> Wins;
+        std::atomic<uint64_t> Losses;
+        std::atomic<uint64_t> Stale;
+        std::atomic<int64_t> LagSumNs;
+        std::atomic<int64_t> LagMaxNs;
+    };
+
+    static uint64_t TickKey(const CThostFtdcDepthMarketDataField& field);
+    static uint32_t SessionTimeKey(const CThostFtdcDepthMarketDataField& field);
+    static void Increment(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::vector<std::string> m_fronts;
+    std::vector<uint32_t> m_laneFronts;
+    std::vector<InstrumentState> m_states;      // 合约编号 -> 去重状态
+    std::vector<Counters> m_counters;           // 前置编号 -> 统计
+};
+
+#endif // FRONT_ARBITER_H
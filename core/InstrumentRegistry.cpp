@@ -0,0 +1,193 @@
+#include "InstrumentRegistry.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// 每个桶尝试的偏移参数上限，超过后换一个种子重建
+static const uint32_t MAX_PILOT = 0xFFFF;
+static const int MAX_SEED_ATTEMPTS = 256;
+
+InstrumentRegistry::InstrumentRegistry() : m_nSize(0), m_nCapacity(0), m_pTable(nullptr) {
+    Build();
+}
+
+InstrumentRegistry::~InstrumentRegistry() {}
+
+void InstrumentRegistry::Reserve(uint32_t capacity) {
+    if (capacity < m_names.size()) capacity = static_cast<uint32_t>(m_names.size());
+    m_names.reserve(capacity);
+    m_nCapacity = capacity;
+}
+
+// splitmix64 的终结函数，双射
+uint64_t InstrumentRegistry::Mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// 只处理有内容的 64 位字，常见的合约代码（不超过 8 个字符）只需一次混合；
+// 桶和槽位分别取哈希值的低位和高位，两者都必须依赖键的每一位，因此每个字都做完整的混合
+uint64_t InstrumentRegistry::Hash(const uint64_t* key, size_t len, uint64_t seed) {
+    uint64_t h = seed ^ len;
+    size_t words = (len + 7) / 8;
+    for (size_t i = 0; i < words; ++i) {
+        h = Mix(h ^ key[i]);
+    }
+    return h;
+}
+
+// 把合约代码读入补零的定长键；缓冲区足够长时整块读取再按长度清零，避免变长拷贝
+void InstrumentRegistry::LoadKey(const char* str, size_t len, size_t maxLen, uint64_t* key) {
+    if (maxLen >= KEY_BYTES) {
+        memcpy(key, str, KEY_BYTES);
+        for (size_t i = 0; i < KEY_BYTES / 8; ++i) {
+            size_t valid = len > i * 8 ? len - i * 8 : 0;
+            if (valid < 8) key[i] &= (1ULL << (valid * 8)) - 1;
+        }
+    } else {
+        memset(key, 0, KEY_BYTES);
+        memcpy(key, str, len);
+    }
+}
+
+uint32_t InstrumentRegistry::Add(const char* instrumentID) {
+    auto it = m_byName.find(instrumentID);
+    if (it != m_byName.end()) return it->second;
+
+    uint32_t index = static_cast<uint32_t>(m_names.size());
+    if (m_nCapacity && index >= m_nCapacity) return INVALID_INDEX;
+    m_names.push_back(instrumentID);
+    m_byName.emplace(m_names.back(), index);
+    m_nSize.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+bool InstrumentRegistry::Build() {
+    std::unique_ptr<Table> table(new Table());
+    for (int attempt = 0; attempt < MAX_SEED_ATTEMPTS; ++attempt) {
+        if (TryBuild(Mix(attempt + 1), *table)) {
+            // 并发的 Find() 可能仍在读取刚替换的旧表，只释放更早的表
+            m_pTable.store(table.get(), std::memory_order_release);
+            m_tables.push_back(std::move(table));
+            if (m_tables.size() > RETIRED_TABLES + 1) m_tables.erase(m_tables.begin());
+            return true;
+        }
+    }
+    // 哈希值大量重复时才会走到这里，实际不会发生；保留原查找表，已有合约不受影响
+    std::cerr << "InstrumentRegistry: failed to build perfect hash for " << m_names.size()
+              << " instruments" << std::endl;
+    return false;
+}
+
+// 负载因子不超过 0.8，平均每个桶约 4 个合约。桶内合约的槽位为 (哈希高位 ^ 偏移量)，
+// 高位相同的两个合约无论偏移量取何值都会冲突，此时换种子重建；
+// 否则按桶从大到小依次寻找使桶内合约全部落在空槽位的偏移参数。
+bool InstrumentRegistry::TryBuild(uint64_t seed, Table& result) const {
+    size_t count = 0;
+    for (uint32_t i = 0; i < m_names.size(); ++i) {
+        if (m_names[i].size() <= KEY_BYTES) ++count;
+    }
+    size_t slots = 16;
+    while (slots * 4 < count * 5) slots <<= 1;
+    size_t buckets = 1;
+    while (buckets * 4 < count) buckets <<= 1;
+    const size_t slotMask = slots - 1;
+    const size_t bucketMask = buckets - 1;
+
+    std::vector<Slot> table(slots);
+    for (size_t i = 0; i < slots; ++i) {
+        memset(table[i].Key, 0, sizeof(table[i].Key));
+        table[i].Index = INVALID_INDEX;
+    }
+
+    std::vector<uint64_t> hashes(m_names.size());
+    std::vector<std::vector<uint32_t>> members(buckets);
+    std::vector<uint32_t> longIndices;
+    for (uint32_t i = 0; i < m_names.size(); ++i) {
+        const std::string& name = m_names[i];
+        if (name.size() > KEY_BYTES) {
+            longIndices.push_back(i);
+            continue;
+        }
+        uint64_t key[KEY_BYTES / 8];
+        LoadKey(name.data(), name.size(), name.size(), key);
+        hashes[i] = Hash(key, name.size(), seed);
+        members[hashes[i] & bucketMask].push_back(i);
+    }
+
+    std::vector<uint32_t> order(buckets);
+    for (uint32_t b = 0; b < buckets; ++b) order[b] = b;
+    std::stable_sort(order.begin(), order.end(), [&members](uint32_t a, uint32_t b) {
+        return members[a].size() > members[b].size();
+    });
+
+    std::vector<uint64_t> pilots(buckets, 0);
+    std::vector<size_t> positions;
+    for (size_t k = 0; k < buckets; ++k) {
+        const std::vector<uint32_t>& bucket = members[order[k]];
+        if (bucket.empty()) break;
+
+        for (size_t j = 0; j < bucket.size(); ++j) {
+            for (size_t t = 0; t < j; ++t) {
+                if (((hashes[bucket[j]] ^ hashes[bucket[t]]) >> 32 & slotMask) == 0) return false;
+            }
+        }
+
+        bool placed = false;
+        for (uint32_t pilot = 0; pilot <= MAX_PILOT && !placed; ++pilot) {
+            uint64_t offset = Mix(pilot);
+            positions.clear();
+            placed = true;
+            for (size_t j = 0; j < bucket.size(); ++j) {
+                size_t pos = ((hashes[bucket[j]] >> 32) ^ offset) & slotMask;
+                if (table[pos].Index != INVALID_INDEX) {
+                    placed = false;
+                    break;
+                }
+                positions.push_back(pos);
+            }
+            if (!placed) continue;
+            pilots[order[k]] = offset;
+            for (size_t j = 0; j < bucket.size(); ++j) {
+                const std::string& name = m_names[bucket[j]];
+                memcpy(table[positions[j]].Key, name.data(), name.size());
+                table[positions[j]].Index = bucket[j];
+            }
+        }
+        if (!placed) return false;
+    }
+
+    result.Seed = seed;
+    result.BucketMask = bucketMask;
+    result.SlotMask = slotMask;
+    result.Pilots.swap(pilots);
+    result.Slots.swap(table);
+    result.LongIndices.swap(longIndices);
+    return true;
+}
+
+uint32_t InstrumentRegistry::Find(const char* instrumentID, size_t maxLen) const {
+    const Table* table = m_pTable.load(std::memory_order_acquire);
+    size_t len = strnlen(instrumentID, maxLen);
+    if (len > KEY_BYTES) {
+        for (size_t i = 0; i < table->LongIndices.size(); ++i) {
+            const std::string& name = m_names[table->LongIndices[i]];
+            if (name.size() == len && memcmp(name.data(), instrumentID, len) == 0) return table->LongIndices[i];
+        }
+        return INVALID_INDEX;
+    }
+
+    uint64_t key[KEY_BYTES / 8];
+    LoadKey(instrumentID, len, maxLen, key);
+    uint64_t h = Hash(key, len, table->Seed);
+    const Slot& slot = table->Slots[((h >> 32) ^ table->Pilots[h & table->BucketMask]) & table->SlotMask];
+    // 空槽位的 Index 为 INVALID_INDEX，比较键相同时同样返回 INVALID_INDEX
+    if (slot.Key[0] == key[0] && slot.Key[1] == key[1] && slot.Key[2] == key[2] && slot.Key[3] == key[3]) {
+        return slot.Index;
+    }
+    return INVALID_INDEX;
+}
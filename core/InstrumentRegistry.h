@@ -0,0 +1,84 @@
+#ifndef INSTRUMENT_REGISTRY_H
+#define INSTRUMENT_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 合约注册表：为每个订阅的合约分配从 0 开始的连续编号，下游按合约维护的结构（缓存、K 线、统计）
+// 都可以是以编号为下标的平坦数组。编号一经分配不再改变，取消订阅的合约保留原编号。
+// 查找使用完美哈希（hash-and-displace）：合约代码补零成定长键，哈希值的低位选桶，
+// 高位与桶的偏移量异或后直接定位到唯一的槽位，只需一次探测和四次 64 位比较，
+// 不做字符串比较，也不分配内存。
+// Add() 只登记合约，Build() 之后新登记的合约才能被 Find() 查到。
+// 调用 Reserve() 之后注册表可以在运行中增长：Add()/Build() 由单一线程调用，
+// Find()/Name()/Size() 可在任意线程并发调用；Build() 构建新的查找表后原子替换。
+// 读取方不登记自己何时离开旧表，替换后旧表再保留 RETIRED_TABLES 次 Build() 才释放：读取方持有表指针的时间
+// 只有一次查找，远短于连续多次重建（每次重建还要经过一轮控制命令）。每张表的槽位数为合约数的 1.25 倍以上
+// 向上取 2 的幂，每个槽位 40 字节，16384 个合约约 1.3 MB，因此旧表不能无限保留。
+class InstrumentRegistry
+{
+public:
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+    static constexpr size_t KEY_BYTES = 32;    // 定长键的长度，更长的合约代码退化为线性查找
+    static constexpr size_t RETIRED_TABLES = 4; // 替换后仍保留的旧查找表张数
+
+    InstrumentRegistry();
+    ~InstrumentRegistry();
+
+    // 预留容量，此后登记的合约数不能超过 capacity；须在其他线程开始读取之前调用
+    void Reserve(uint32_t capacity);
+
+    // 登记合约并返回其编号；已登记的合约返回原编号，超出预留容量时返回 INVALID_INDEX
+    uint32_t Add(const char* instrumentID);
+
+    // 为当前登记的全部合约构建查找表；失败时保留原查找表（此后登记的合约仍查不到）并返回 false
+    bool Build();
+
+    // 查找合约编号，未注册时返回 INVALID_INDEX
+    // instrumentID 可以是未以 '\0' 结尾的定长字符数组，最多读取 maxLen 字节
+    uint32_t Find(const char* instrumentID, size_t maxLen = 81) const;
+
+    const std::string& Name(uint32_t index) const { return m_names[index]; }
+    uint32_t Size() const { return m_nSize.load(std::memory_order_acquire); }
+
+    // 预留容量，未调用 Reserve() 时为当前合约数
+    uint32_t Capacity() const { return m_nCapacity ? m_nCapacity : Size(); }
+
+private:
+    struct Slot
+    {
+        uint64_t Key[KEY_BYTES / 8];    // 补零的合约代码
+        uint32_t Index;
+    };
+
+    // 一次 Build() 的结果，发布后只读
+    struct Table
+    {
+        uint64_t Seed;
+        size_t BucketMask;
+        size_t SlotMask;
+        std::vector<uint64_t> Pilots;       // 桶 -> 槽位偏移量（偏移参数混合后的值）
+        std::vector<Slot> Slots;
+        std::vector<uint32_t> LongIndices;  // 代码长度超过 KEY_BYTES 的合约
+    };
+
+    static uint64_t Mix(uint64_t x);
+    static uint64_t Hash(const uint64_t* key, size_t len, uint64_t seed);
+    static void LoadKey(const char* str, size_t len, size_t maxLen, uint64_t* key);
+    bool TryBuild(uint64_t seed, Table& table) const;
+
+    std::vector<std::string> m_names;                       // 编号 -> 合约代码，预留容量后不再搬移
+    std::unordered_map<std::string, uint32_t> m_byName;     // 登记时去重，仅写入线程使用
+    std::atomic<uint32_t> m_nSize;
+    uint32_t m_nCapacity;
+
+    std::atomic<const Table*> m_pTable;                     // 当前查找表
+    std::vector<std::unique_ptr<Table>> m_tables;           // 最近的 RETIRED_TABLES 张旧表和当前表，按构建顺序
+};
+
+#endif // INSTRUMENT_REGISTRY_H
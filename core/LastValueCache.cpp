@@ -0,0 +1,29 @@
+#include "LastValueCache.h"
+#include <cstring>
+
+LastValueCache::LastValueCache(size_t capacity) : m_entries(capacity) {}
+
+void LastValueCache::Update(uint32_t index, uint64_t sequence, const TickRecord& tick) {
+    if (index >= m_entries.size()) return;
+    Entry& entry = m_entries[index];
+    uint64_t version = entry.Version.load(std::memory_order_relaxed);
+    entry.Version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.Sequence = sequence;
+    memcpy(&entry.Tick, &tick, sizeof(entry.Tick));
+    entry.Version.store(version + 2, std::memory_order_release);
+}
+
+bool LastValueCache::Read(uint32_t index, TickRecord& tick, uint64_t& sequence) const {
+    if (index >= m_entries.size()) return false;
+    const Entry& entry = m_entries[index];
+    while (true) {
+        uint64_t before = entry.Version.load(std::memory_order_acquire);
+        if (before == 0) return false;
+        if (before & 1) continue;
+        sequence = entry.Sequence;
+        memcpy(&tick, &entry.Tick, sizeof(tick));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.Version.load(std::memory_order_relaxed) == before) return true;
+    }
+}
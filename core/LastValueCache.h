@@ -0,0 +1,38 @@
+#ifndef LAST_VALUE_CACHE_H
+#define LAST_VALUE_CACHE_H
+
+#include "TickRecord.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 按合约编号保存每个合约的最新一条行情，供新连接的客户端获取快照
+// 只有流水线工作线程写入；每个条目带一个顺序锁版本号，读取方在任意线程无锁拷贝，
+// 遇到并发写入时重试，写入方永远不会被读取方阻塞。
+class LastValueCache
+{
+public:
+    explicit LastValueCache(size_t capacity);
+
+    // 写入一条行情及其流水线序号，编号超出容量时忽略（仅流水线工作线程调用）
+    void Update(uint32_t index, uint64_t sequence, const TickRecord& tick);
+
+    // 读取一致的拷贝，该合约尚无行情时返回 false（任意线程）
+    bool Read(uint32_t index, TickRecord& tick, uint64_t& sequence) const;
+
+    size_t Capacity() const { return m_entries.size(); }
+
+private:
+    struct alignas(64) Entry
+    {
+        std::atomic<uint64_t> Version{0};   // 奇数表示正在写入，0 表示从未写入
+        uint64_t Sequence = 0;
+        TickRecord Tick;
+    };
+
+    std::vector<Entry> m_entries;
+};
+
+#endif // LAST_VALUE_CACHE_H
@@ -0,0 +1,74 @@
+#include "LatencyHistogram.h"
+#include <cmath>
+#include <cstdio>
+
+LatencyHistogram::LatencyHistogram() : m_nSum(0) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) m_counts[i].store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Read(Snapshot& snapshot) const {
+    snapshot.Count = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        snapshot.Counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        snapshot.Count += snapshot.Counts[i];
+    }
+    snapshot.Sum = m_nSum.load(std::memory_order_relaxed);
+}
+
+// 下标 i < 2 * SUB_BUCKETS 时每桶宽度为 1；之后每 SUB_BUCKETS 个桶宽度翻倍
+uint64_t LatencyHistogram::BucketLow(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+    size_t shift = index / SUB_BUCKETS - 1;
+    return static_cast<uint64_t>(index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+}
+
+uint64_t LatencyHistogram::BucketWidth(size_t index) {
+    if (index < SUB_BUCKETS) return 1;
+    return 1ULL << (index / SUB_BUCKETS - 1);
+}
+
+void LatencyHistogram::Snapshot::Add(const Snapshot& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) Counts[i] += other.Counts[i];
+    Count += other.Count;
+    Sum += other.Sum;
+}
+
+void LatencyHistogram::Snapshot::Subtract(const Snapshot& earlier) {
+    Count = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        // 并发读取时较晚的快照个别桶可能反而较小，按 0 处理
+        Counts[i] = Counts[i] > earlier.Counts[i] ? Counts[i] - earlier.Counts[i] : 0;
+        Count += Counts[i];
+    }
+    Sum = Sum > earlier.Sum ? Sum - earlier.Sum : 0;
+}
+
+uint64_t LatencyHistogram::Snapshot::Percentile(double q) const {
+    if (Count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * Count));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += Counts[i];
+        if (seen >= rank) return BucketLow(i) + BucketWidth(i) / 2;
+    }
+    return Max();
+}
+
+uint64_t LatencyHistogram::Snapshot::Max() const {
+    for (size_t i = BUCKET_COUNT; i-- > 0;) {
+        if (Counts[i] != 0) return BucketLow(i) + (BucketWidth(i) - 1);
+    }
+    return 0;
+}
+
+std::string LatencyHistogram::Snapshot::Describe(double nanosPerUnit) const {
+    double scale = nanosPerUnit / 1000.0;
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "count=%llu, mean_us=%.2f, p50_us=%.2f, p90_us=%.2f, p99_us=%.2f, p999_us=%.2f, max_us=%.2f",
+             static_cast<unsigned long long>(Count), Count > 0 ? static_cast<double>(Sum) / Count * scale : 0.0,
+             Percentile(0.5) * scale, Percentile(0.9) * scale, Percentile(0.99) * scale,
+             Percentile(0.999) * scale, Max() * scale);
+    return buf;
+}
@@ -0,0 +1,67 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// HDR 风格的延迟直方图：对数-线性分桶，每个 2 的幂区间等分为 SUB_BUCKETS 档，
+// 覆盖整个 uint64_t 范围，相对误差不超过 1/SUB_BUCKETS。值的单位由调用方决定（流水线中为 TSC 周期）。
+// 只有一个写入线程，Record() 只做一次普通的加法（relaxed 读改写，无锁、无原子 RMW 指令）；
+// 任意线程可以随时 Read() 快照，与写入并发时各桶计数之间可能相差正在写入的几条。
+class LatencyHistogram
+{
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+    static const size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    // 某一时刻的计数拷贝，两次快照相减即为区间内的分布
+    struct Snapshot
+    {
+        std::vector<uint64_t> Counts;
+        uint64_t Count;
+        uint64_t Sum;
+
+        Snapshot() : Counts(BUCKET_COUNT, 0), Count(0), Sum(0) {}
+
+        void Add(const Snapshot& other);
+        void Subtract(const Snapshot& earlier);
+
+        // 分位数 q（0~1）所在桶的中值，没有数据时返回 0
+        uint64_t Percentile(double q) const;
+        uint64_t Max() const;
+
+        // "count=N, mean_us=..., p50_us=..., p90_us=..., p99_us=..., p999_us=..., max_us=..."，
+        // nanosPerUnit 为每个计数单位对应的纳秒数
+        std::string Describe(double nanosPerUnit) const;
+    };
+
+    LatencyHistogram();
+
+    void Record(uint64_t value) {
+        std::atomic<uint64_t>& bucket = m_counts[BucketIndex(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_nSum.store(m_nSum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void Read(Snapshot& snapshot) const;
+
+    static size_t BucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+        int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return static_cast<size_t>(shift) * SUB_BUCKETS + static_cast<size_t>(value >> shift);
+    }
+
+    // 桶的取值范围 [BucketLow, BucketLow + BucketWidth)
+    static uint64_t BucketLow(size_t index);
+    static uint64_t BucketWidth(size_t index);
+
+private:
+    std::atomic<uint64_t> m_counts[BUCKET_COUNT];
+    std::atomic<uint64_t> m_nSum;
+};
+
+#endif // LATENCY_HISTOGRAM_H
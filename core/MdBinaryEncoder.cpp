@@ -0,0 +1,118 @@
+#include "MdBinaryEncoder.h"
+#include "NumberFormat.h"
+#include <cstring>
+
+MdBinaryEncoder::MdBinaryEncoder() : m_nSize(0), m_nDepth(1), m_bTickDeltas(false) {
+    memset(m_buffer, 0, sizeof(m_buffer));
+}
+
+void MdBinaryEncoder::SetDepth(int depth) {
+    m_nDepth = depth >= 5 ? 5 : 1;
+}
+
+int64_t MdBinaryEncoder::ScalePrice(double price) {
+    if (NumberFormat::IsInvalidPrice(price)) return MD_BINARY_NULL_PRICE;
+    double scaled = price * MD_BINARY_PRICE_SCALE;
+    return static_cast<int64_t>(scaled >= 0 ? scaled + 0.5 : scaled - 0.5);
+}
+
+size_t MdBinaryEncoder::EncodeStreamHeader() {
+    MdBinaryStreamHeader* header = reinterpret_cast<MdBinaryStreamHeader*>(m_buffer);
+    header->Magic = MD_BINARY_MAGIC;
+    header->Version = MD_BINARY_VERSION;
+    header->HeaderSize = sizeof(MdBinaryStreamHeader);
+    header->PriceScale = MD_BINARY_PRICE_SCALE;
+    m_nSize = sizeof(MdBinaryStreamHeader);
+    return m_nSize;
+}
+
+size_t MdBinaryEncoder::EncodeInstrumentDef(uint32_t instrumentIndex, const char* instrumentID) {
+    MdBinaryInstrumentDef* def = reinterpret_cast<MdBinaryInstrumentDef*>(m_buffer);
+    def->Header.Length = sizeof(MdBinaryInstrumentDef);
+    def->Header.Type = MD_BINARY_MSG_INSTRUMENT_DEF;
+    def->InstrumentIndex = instrumentIndex;
+    memset(def->InstrumentID, 0, sizeof(def->InstrumentID));
+    strncpy(def->InstrumentID, instrumentID, sizeof(def->InstrumentID) - 1);
+    m_nSize = sizeof(MdBinaryInstrumentDef);
+    return m_nSize;
+}
+
+size_t MdBinaryEncoder::EncodeTick(const TickRecord& tick, uint32_t instrumentIndex, const TickDelta* pDelta) {
+    m_nSize = m_nDepth == 5 ? EncodeL5(tick, instrumentIndex) : EncodeL1(tick, instrumentIndex);
+    if (m_bTickDeltas && pDelta) m_nSize += EncodeDelta(m_buffer + m_nSize, *pDelta, instrumentIndex);
+    return m_nSize;
+}
+
+static_assert(TickDelta::KIND_BASELINE == MD_BINARY_DELTA_BASELINE && TickDelta::KIND_TICK == MD_BINARY_DELTA_TICK &&
+              TickDelta::KIND_ROLLOVER == MD_BINARY_DELTA_ROLLOVER && TickDelta::KIND_GAP == MD_BINARY_DELTA_GAP &&
+              TickDelta::KIND_STALE == MD_BINARY_DELTA_STALE, "TickDelta::Kind must match MD_BINARY_DELTA_*");
+
+size_t MdBinaryEncoder::EncodeDelta(char* out, const TickDelta& delta, uint32_t instrumentIndex) {
+    MdBinaryTickDelta* rec = reinterpret_cast<MdBinaryTickDelta*>(out);
+    rec->Header.Length = sizeof(MdBinaryTickDelta);
+    rec->Header.Type = MD_BINARY_MSG_TICK_DELTA;
+    rec->InstrumentIndex = instrumentIndex;
+    rec->Volume = delta.Volume;
+    rec->Kind = static_cast<uint32_t>(delta.Type);
+    rec->Turnover = delta.Turnover;
+    rec->OpenInterest = delta.OpenInterest;
+    rec->TradePrice = ScalePrice(delta.TradePrice);
+    return sizeof(MdBinaryTickDelta);
+}
+
+size_t MdBinaryEncoder::EncodeL1(const TickRecord& tick, uint32_t instrumentIndex) {
+    const CThostFtdcDepthMarketDataField& f = tick.Field;
+    MdBinaryTickL1* rec = reinterpret_cast<MdBinaryTickL1*>(m_buffer);
+    rec->Header.Length = sizeof(MdBinaryTickL1);
+    rec->Header.Type = MD_BINARY_MSG_TICK_L1;
+    rec->InstrumentIndex = instrumentIndex;
+    rec->ExchangeTimeNs = ExchangeTimeNanos(f);
+    rec->RecvTimeNs = tick.RecvTimeNs;
+    rec->LastPrice = ScalePrice(f.LastPrice);
+    rec->BidPrice1 = ScalePrice(f.BidPrice1);
+    rec->AskPrice1 = ScalePrice(f.AskPrice1);
+    rec->Volume = f.Volume;
+    rec->BidVolume1 = f.BidVolume1;
+    rec->AskVolume1 = f.AskVolume1;
+    rec->Reserved = 0;
+    return sizeof(MdBinaryTickL1);
+}
+
+size_t MdBinaryEncoder::EncodeL5(const TickRecord& tick, uint32_t instrumentIndex) {
+    const CThostFtdcDepthMarketDataField& f = tick.Field;
+    MdBinaryTickL5* rec = reinterpret_cast<MdBinaryTickL5*>(m_buffer);
+    rec->Header.Length = sizeof(MdBinaryTickL5);
+    rec->Header.Type = MD_BINARY_MSG_TICK_L5;
+    rec->InstrumentIndex = instrumentIndex;
+    rec->ExchangeTimeNs = ExchangeTimeNanos(f);
+    rec->RecvTimeNs = tick.RecvTimeNs;
+    rec->LastPrice = ScalePrice(f.LastPrice);
+    rec->AveragePrice = ScalePrice(f.AveragePrice);
+    rec->UpperLimitPrice = ScalePrice(f.UpperLimitPrice);
+    rec->LowerLimitPrice = ScalePrice(f.LowerLimitPrice);
+    rec->Turnover = f.Turnover;
+    rec->OpenInterest = f.OpenInterest;
+    rec->Volume = f.Volume;
+    rec->Reserved = 0;
+    rec->BidPrice[0] = ScalePrice(f.BidPrice1);
+    rec->BidPrice[1] = ScalePrice(f.BidPrice2);
+    rec->BidPrice[2] = ScalePrice(f.BidPrice3);
+    rec->BidPrice[3] = ScalePrice(f.BidPrice4);
+    rec->BidPrice[4] = ScalePrice(f.BidPrice5);
+    rec->AskPrice[0] = ScalePrice(f.AskPrice1);
+    rec->AskPrice[1] = ScalePrice(f.AskPrice2);
+    rec->AskPrice[2] = ScalePrice(f.AskPrice3);
+    rec->AskPrice[3] = ScalePrice(f.AskPrice4);
+    rec->AskPrice[4] = ScalePrice(f.AskPrice5);
+    rec->BidVolume[0] = f.BidVolume1;
+    rec->BidVolume[1] = f.BidVolume2;
+    rec->BidVolume[2] = f.BidVolume3;
+    rec->BidVolume[3] = f.BidVolume4;
+    rec->BidVolume[4] = f.BidVolume5;
+    rec->AskVolume[0] = f.AskVolume1;
+    rec->AskVolume[1] = f.AskVolume2;
+    rec->AskVolume[2] = f.AskVolume3;
+    rec->AskVolume[3] = f.AskVolume4;
+    rec->AskVolume[4] = f.AskVolume5;
+    return sizeof(MdBinaryTickL5);
+}
@@ -0,0 +1,45 @@
+#ifndef MD_BINARY_ENCODER_H
+#define MD_BINARY_ENCODER_H
+
+#include "MdBinaryFormat.h"
+#include "TickRecord.h"
+#include "TickDeltaTracker.h"
+
+#include <cstddef>
+
+// 二进制行情编码器，输出格式见 MdBinaryFormat.h
+// 与 MdJsonEncoder 一样写入内部固定缓冲区，不做堆分配，非线程安全。
+class MdBinaryEncoder
+{
+public:
+    MdBinaryEncoder();
+
+    // 盘口深度：1 输出 MdBinaryTickL1，5 输出 MdBinaryTickL5
+    void SetDepth(int depth);
+
+    // 输出 MdBinaryTickDelta（见 TickDeltaTracker）
+    void SetTickDeltas(bool enable) { m_bTickDeltas = enable; }
+
+    size_t EncodeStreamHeader();
+    size_t EncodeInstrumentDef(uint32_t instrumentIndex, const char* instrumentID);
+    // pDelta 非空且开启了逐笔增量时，在行情消息之后紧接着输出 MdBinaryTickDelta，返回两条消息的总长度
+    size_t EncodeTick(const TickRecord& tick, uint32_t instrumentIndex, const TickDelta* pDelta = nullptr);
+
+    const char* Data() const { return m_buffer; }
+    size_t Size() const { return m_nSize; }
+
+    // 价格转换为定点整数，无效价格转换为 MD_BINARY_NULL_PRICE
+    static int64_t ScalePrice(double price);
+
+private:
+    size_t EncodeL1(const TickRecord& tick, uint32_t instrumentIndex);
+    size_t EncodeL5(const TickRecord& tick, uint32_t instrumentIndex);
+    size_t EncodeDelta(char* out, const TickDelta& delta, uint32_t instrumentIndex);
+
+    alignas(8) char m_buffer[sizeof(MdBinaryTickL5) + sizeof(MdBinaryTickDelta)];
+    size_t m_nSize;
+    int m_nDepth;
+    bool m_bTickDeltas;
+};
+
+#endif // MD_BINARY_ENCODER_H
@@ -0,0 +1,128 @@
+#ifndef MD_BINARY_FORMAT_H
+#define MD_BINARY_FORMAT_H
+
+// 行情二进制输出格式（--format=binary）
+// 本文件只依赖 <stdint.h>，可以被下游 C/C++ 程序直接包含。
+//
+// 流结构：
+//   MdBinaryStreamHeader                 流开始时输出一次
+//   MdBinaryInstrumentDef * N            合约编号与代码的对应关系
+//   MdBinaryTickL1 / MdBinaryTickL5 ...  行情，取决于输出深度
+//   MdBinaryTickDelta                    开启逐笔增量时紧跟在每条行情之后，同一合约相对上一条行情的增量
+//
+// 除流头外，每条消息都以 MdBinaryMsgHeader 开头，Length 为整条消息的字节数，
+// 读取方可以据此跳过不认识的消息类型。所有整数均为小端序，结构体紧凑排列（无填充），
+// 读到完整一条消息后即可直接按对应结构体解释。
+//
+// 价格以 int64 定点数表示：实际价格 = Price / MD_BINARY_PRICE_SCALE，
+// CTP 的无效价格（DBL_MAX）表示为 MD_BINARY_NULL_PRICE。
+// 时间均为 UTC 纪元以来的纳秒数；ExchangeTimeNs 由 ActionDay/UpdateTime/UpdateMillisec
+// 按北京时间（UTC+8）换算得到。
+
+#include <stdint.h>
+
+#define MD_BINARY_MAGIC             0x42505443u   /* "CTPB"（小端序） */
+#define MD_BINARY_VERSION           1
+#define MD_BINARY_PRICE_SCALE       10000
+#define MD_BINARY_NULL_PRICE        INT64_MIN
+#define MD_BINARY_INVALID_INDEX     0xFFFFFFFFu
+#define MD_BINARY_INSTRUMENT_ID_LEN 32
+
+// 消息类型
+#define MD_BINARY_MSG_INSTRUMENT_DEF 1
+#define MD_BINARY_MSG_TICK_L1        2
+#define MD_BINARY_MSG_TICK_L5        3
+#define MD_BINARY_MSG_TICK_DELTA     4
+
+// MdBinaryTickDelta.Kind
+#define MD_BINARY_DELTA_BASELINE     0   /* 合约的第一条行情、未注册合约或重连后累计量被重置，增量为 0 */
+#define MD_BINARY_DELTA_TICK         1   /* 与上一条行情的累计量之差 */
+#define MD_BINARY_DELTA_ROLLOVER     2   /* 交易日变化，成交量、成交额从 0 起算 */
+#define MD_BINARY_DELTA_GAP          3   /* 断线重连后的第一条行情，增量包含断线期间的成交 */
+#define MD_BINARY_DELTA_STALE        4   /* 累计成交量倒退的旧行情，增量为 0 */
+
+#pragma pack(push, 1)
+
+typedef struct MdBinaryStreamHeader
+{
+    uint32_t Magic;         // MD_BINARY_MAGIC
+    uint16_t Version;       // MD_BINARY_VERSION
+    uint16_t HeaderSize;    // sizeof(MdBinaryStreamHeader)
+    int64_t PriceScale;     // MD_BINARY_PRICE_SCALE
+} MdBinaryStreamHeader;
+
+typedef struct MdBinaryMsgHeader
+{
+    uint16_t Length;        // 整条消息的字节数（含本头部）
+    uint16_t Type;          // MD_BINARY_MSG_*
+} MdBinaryMsgHeader;
+
+// 合约定义：编号 -> 合约代码
+typedef struct MdBinaryInstrumentDef
+{
+    MdBinaryMsgHeader Header;
+    uint32_t InstrumentIndex;
+    char InstrumentID[MD_BINARY_INSTRUMENT_ID_LEN];   // 以 '\0' 填充
+} MdBinaryInstrumentDef;
+
+// 一档行情
+typedef struct MdBinaryTickL1
+{
+    MdBinaryMsgHeader Header;
+    uint32_t InstrumentIndex;
+    int64_t ExchangeTimeNs;
+    int64_t RecvTimeNs;
+    int64_t LastPrice;
+    int64_t BidPrice1;
+    int64_t AskPrice1;
+    int32_t Volume;
+    int32_t BidVolume1;
+    int32_t AskVolume1;
+    int32_t Reserved;
+} MdBinaryTickL1;
+
+// 五档行情
+typedef struct MdBinaryTickL5
+{
+    MdBinaryMsgHeader Header;
+    uint32_t InstrumentIndex;
+    int64_t ExchangeTimeNs;
+    int64_t RecvTimeNs;
+    int64_t LastPrice;
+    int64_t AveragePrice;
+    int64_t UpperLimitPrice;
+    int64_t LowerLimitPrice;
+    double Turnover;
+    double OpenInterest;
+    int32_t Volume;
+    int32_t Reserved;
+    int64_t BidPrice[5];
+    int64_t AskPrice[5];
+    int32_t BidVolume[5];
+    int32_t AskVolume[5];
+} MdBinaryTickL5;
+
+// 逐笔增量，InstrumentIndex 与其前一条行情消息相同
+typedef struct MdBinaryTickDelta
+{
+    MdBinaryMsgHeader Header;
+    uint32_t InstrumentIndex;
+    int32_t Volume;
+    uint32_t Kind;          // MD_BINARY_DELTA_*
+    double Turnover;
+    double OpenInterest;
+    int64_t TradePrice;     // 成交均价，无成交或合约乘数未知时为 MD_BINARY_NULL_PRICE
+} MdBinaryTickDelta;
+
+#pragma pack(pop)
+
+#ifdef __cplusplus
+static_assert(sizeof(MdBinaryStreamHeader) == 16, "MdBinaryStreamHeader layout changed");
+static_assert(sizeof(MdBinaryMsgHeader) == 4, "MdBinaryMsgHeader layout changed");
+static_assert(sizeof(MdBinaryInstrumentDef) == 40, "MdBinaryInstrumentDef layout changed");
+static_assert(sizeof(MdBinaryTickL1) == 64, "MdBinaryTickL1 layout changed");
+static_assert(sizeof(MdBinaryTickL5) == 200, "MdBinaryTickL5 layout changed");
+static_assert(sizeof(MdBinaryTickDelta) == 40, "MdBinaryTickDelta layout changed");
+#endif
+
+#endif // MD_BINARY_FORMAT_H
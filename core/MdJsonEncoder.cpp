@@ -0,0 +1,355 @@
+#include "MdJsonEncoder.h"
+#include "NumberFormat.h"
+#include "TickDeltaTracker.h"
+#include <cmath>
+#include <cstring>
+
+// 追加字符串字面量（长度在编译期确定，不含结尾的 '\0'）
+#define APPEND_LITERAL(s) AppendRaw(s, sizeof(s) - 1)
+
+MdJsonEncoder::MdJsonEncoder() : m_nSize(0), m_bNullInvalidPrices(false), m_bTickDeltas(false), m_nDepth(1),
+                                 m_pPrev(nullptr), m_pPrevDelta(nullptr), m_nFrameSeq(0) {
+    m_buffer[0] = '\0';
+}
+
+void MdJsonEncoder::SetDepth(int depth) {
+    m_nDepth = depth >= 5 ? 5 : 1;
+}
+
+size_t MdJsonEncoder::EncodeSse(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta) {
+    m_pPrev = nullptr;
+    m_pPrevDelta = nullptr;
+    m_nFrameSeq = 0;
+    return Encode(pData, pDelta);
+}
+
+size_t MdJsonEncoder::EncodeSseChanged(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta,
+                                       const CThostFtdcDepthMarketDataField* pPrev, const TickDelta* pPrevDelta,
+                                       uint64_t seq) {
+    m_pPrev = pPrev;
+    m_pPrevDelta = pPrevDelta;
+    m_nFrameSeq = seq;
+    return Encode(pData, pDelta);
+}
+
+size_t MdJsonEncoder::Encode(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta) {
+    m_nSize = 0;
+    if (!pData) return 0;
+    if (!m_bTickDeltas) pDelta = nullptr;
+
+    APPEND_LITERAL("data: ");
+    if (m_nDepth == 5) {
+        AppendL5(pData, pDelta);
+    } else {
+        AppendL1(pData, pDelta);
+    }
+    APPEND_LITERAL("\n\n");
+
+    return m_nSize;
+}
+
+// 变化字段编码时与上一条行情相同的字段不输出
+#define UNCHANGED(field) (m_pPrev && pData->field == m_pPrev->field)
+#define UNCHANGED_STRING(field) (m_pPrev && strncmp(pData->field, m_pPrev->field, sizeof(pData->field)) == 0)
+
+// 每个字段都以 ',' 开头，最后把第一个字段前的 ',' 改为 '{'（InstrumentID 总是输出，至少有一个字段）
+void MdJsonEncoder::AppendL1(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta) {
+    // 键的顺序与 nlohmann::json 默认的 std::map 排序保持一致
+    size_t open = m_nSize;
+    if (!UNCHANGED(AskPrice1)) {
+        APPEND_LITERAL(",\"AskPrice1\":");
+        AppendPrice(pData->AskPrice1);
+    }
+    if (!UNCHANGED(AskVolume1)) {
+        APPEND_LITERAL(",\"AskVolume1\":");
+        AppendInt(pData->AskVolume1);
+    }
+    if (!UNCHANGED(BidPrice1)) {
+        APPEND_LITERAL(",\"BidPrice1\":");
+        AppendPrice(pData->BidPrice1);
+    }
+    if (!UNCHANGED(BidVolume1)) {
+        APPEND_LITERAL(",\"BidVolume1\":");
+        AppendInt(pData->BidVolume1);
+    }
+    AppendDeltas(pDelta);
+    if (m_nFrameSeq != 0 && !m_pPrev) APPEND_LITERAL(",\"Full\":true");
+    APPEND_LITERAL(",\"InstrumentID\":");
+    AppendString(pData->InstrumentID, sizeof(pData->InstrumentID));
+    if (!UNCHANGED(LastPrice)) {
+        APPEND_LITERAL(",\"LastPrice\":");
+        AppendPrice(pData->LastPrice);
+    }
+    AppendSeq();
+    AppendTradePrice(pDelta);
+    if (!UNCHANGED(UpdateMillisec)) {
+        APPEND_LITERAL(",\"UpdateMillisec\":");
+        AppendInt(pData->UpdateMillisec);
+    }
+    if (!UNCHANGED_STRING(UpdateTime)) {
+        APPEND_LITERAL(",\"UpdateTime\":");
+        AppendString(pData->UpdateTime, sizeof(pData->UpdateTime));
+    }
+    if (!UNCHANGED(Volume)) {
+        APPEND_LITERAL(",\"Volume\":");
+        AppendInt(pData->Volume);
+    }
+    m_buffer[open] = '{';
+    APPEND_LITERAL("}");
+}
+
+// 五档模式：盘口以 [[价格,数量],...] 数组输出，键同样按字典序排列；变化字段编码时一侧盘口任一档变化即整侧输出
+static void LoadLevels(const CThostFtdcDepthMarketDataField& f, double* askPrices, int* askVolumes, double* bidPrices,
+                       int* bidVolumes) {
+    const double asks[5] = {f.AskPrice1, f.AskPrice2, f.AskPrice3, f.AskPrice4, f.AskPrice5};
+    const int askQty[5] = {f.AskVolume1, f.AskVolume2, f.AskVolume3, f.AskVolume4, f.AskVolume5};
+    const double bids[5] = {f.BidPrice1, f.BidPrice2, f.BidPrice3, f.BidPrice4, f.BidPrice5};
+    const int bidQty[5] = {f.BidVolume1, f.BidVolume2, f.BidVolume3, f.BidVolume4, f.BidVolume5};
+    memcpy(askPrices, asks, sizeof(asks));
+    memcpy(askVolumes, askQty, sizeof(askQty));
+    memcpy(bidPrices, bids, sizeof(bids));
+    memcpy(bidVolumes, bidQty, sizeof(bidQty));
+}
+
+void MdJsonEncoder::AppendL5(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta) {
+    double askPrices[5], bidPrices[5], prevAskPrices[5], prevBidPrices[5];
+    int askVolumes[5], bidVolumes[5], prevAskVolumes[5], prevBidVolumes[5];
+    LoadLevels(*pData, askPrices, askVolumes, bidPrices, bidVolumes);
+    if (m_pPrev) LoadLevels(*m_pPrev, prevAskPrices, prevAskVolumes, prevBidPrices, prevBidVolumes);
+
+    size_t open = m_nSize;
+    if (!UNCHANGED_STRING(ActionDay)) {
+        APPEND_LITERAL(",\"ActionDay\":");
+        AppendString(pData->ActionDay, sizeof(pData->ActionDay));
+    }
+    AppendSide(true, askPrices, askVolumes, m_pPrev ? prevAskPrices : nullptr, prevAskVolumes);
+    if (!UNCHANGED(AveragePrice)) {
+        APPEND_LITERAL(",\"AveragePrice\":");
+        AppendPrice(pData->AveragePrice);
+    }
+    AppendSide(false, bidPrices, bidVolumes, m_pPrev ? prevBidPrices : nullptr, prevBidVolumes);
+    AppendDeltas(pDelta);
+    if (m_nFrameSeq != 0 && !m_pPrev) APPEND_LITERAL(",\"Full\":true");
+    APPEND_LITERAL(",\"InstrumentID\":");
+    AppendString(pData->InstrumentID, sizeof(pData->InstrumentID));
+    if (!UNCHANGED(LastPrice)) {
+        APPEND_LITERAL(",\"LastPrice\":");
+        AppendPrice(pData->LastPrice);
+    }
+    if (!UNCHANGED(LowerLimitPrice)) {
+        APPEND_LITERAL(",\"LowerLimitPrice\":");
+        AppendPrice(pData->LowerLimitPrice);
+    }
+    if (!UNCHANGED(OpenInterest)) {
+        APPEND_LITERAL(",\"OpenInterest\":");
+        AppendDouble(pData->OpenInterest);
+    }
+    AppendSeq();
+    AppendTradePrice(pDelta);
+    if (!UNCHANGED(Turnover)) {
+        APPEND_LITERAL(",\"Turnover\":");
+        AppendDouble(pData->Turnover);
+    }
+    if (!UNCHANGED(UpdateMillisec)) {
+        APPEND_LITERAL(",\"UpdateMillisec\":");
+        AppendInt(pData->UpdateMillisec);
+    }
+    if (!UNCHANGED_STRING(UpdateTime)) {
+        APPEND_LITERAL(",\"UpdateTime\":");
+        AppendString(pData->UpdateTime, sizeof(pData->UpdateTime));
+    }
+    if (!UNCHANGED(UpperLimitPrice)) {
+        APPEND_LITERAL(",\"UpperLimitPrice\":");
+        AppendPrice(pData->UpperLimitPrice);
+    }
+    if (!UNCHANGED(Volume)) {
+        APPEND_LITERAL(",\"Volume\":");
+        AppendInt(pData->Volume);
+    }
+    m_buffer[open] = '{';
+    APPEND_LITERAL("}");
+}
+
+#undef UNCHANGED
+#undef UNCHANGED_STRING
+
+// 增量字段紧跟在 B 开头的键之后、InstrumentID 之前；变化字段编码时与上一条行情的增量比较
+void MdJsonEncoder::AppendDeltas(const TickDelta* pDelta) {
+    if (!pDelta) return;
+    const TickDelta* pPrev = m_pPrev ? m_pPrevDelta : nullptr;
+    if (!pPrev || pDelta->Type != pPrev->Type) {
+        APPEND_LITERAL(",\"DeltaKind\":\"");
+        const char* kind = TickDelta::KindName(pDelta->Type);
+        AppendRaw(kind, strlen(kind));
+        APPEND_LITERAL("\"");
+    }
+    if (!pPrev || pDelta->OpenInterest != pPrev->OpenInterest) {
+        APPEND_LITERAL(",\"DeltaOpenInterest\":");
+        AppendDouble(pDelta->OpenInterest);
+    }
+    if (!pPrev || pDelta->Turnover != pPrev->Turnover) {
+        APPEND_LITERAL(",\"DeltaTurnover\":");
+        AppendDouble(pDelta->Turnover);
+    }
+    if (!pPrev || pDelta->Volume != pPrev->Volume) {
+        APPEND_LITERAL(",\"DeltaVolume\":");
+        AppendInt(pDelta->Volume);
+    }
+}
+
+void MdJsonEncoder::AppendTradePrice(const TickDelta* pDelta) {
+    if (!pDelta) return;
+    if (m_pPrev && m_pPrevDelta && pDelta->TradePrice == m_pPrevDelta->TradePrice) return;
+    APPEND_LITERAL(",\"TradePrice\":");
+    AppendPrice(pDelta->TradePrice);
+}
+
+void MdJsonEncoder::AppendSeq() {
+    if (m_nFrameSeq == 0) return;
+    APPEND_LITERAL(",\"Seq\":");
+    m_nSize = NumberFormat::FormatUInt(m_buffer + m_nSize, m_nFrameSeq) - m_buffer;
+}
+
+// 档位从一档开始连续排列，遇到第一个空档（数量为 0 或价格无效）即停止
+// 有效档位数：遇到数量为 0 或无效价格的档位为止
+static int LevelCount(const double* prices, const int* volumes) {
+    int count = 0;
+    while (count < 5 && volumes[count] != 0 && !NumberFormat::IsInvalidPrice(prices[count])) ++count;
+    return count;
+}
+
+// 一侧盘口。变化字段编码时，档位数与上一条行情相同且只有部分档位变化的，只输出变化的档位
+// "AskLevels":[[档位,价格,数量],...]（档位从 0 起），读取方按档位替换；价格变动使盘口整体移位时另加
+// "AskShift":k，表示先把新的第 i 档取为上一条行情的第 i+k 档，再应用 AskLevels。其余情况输出整侧 "Asks"
+void MdJsonEncoder::AppendSide(bool ask, const double* prices, const int* volumes, const double* prevPrices,
+                               const int* prevVolumes) {
+    if (prevPrices) {
+        int count = LevelCount(prices, volumes);
+        int prevCount = LevelCount(prevPrices, prevVolumes);
+        // 选择未变档位最多的移位，相同时优先不移位
+        int shift = 0;
+        int changed = count + 1;
+        for (int k = 0; k < 9 && count == prevCount; ++k) {
+            int candidate = k % 2 == 0 ? k / 2 : -(k + 1) / 2;
+            int n = 0;
+            for (int i = 0; i < count; ++i) {
+                int j = i + candidate;
+                if (j < 0 || j >= prevCount || prices[i] != prevPrices[j] || volumes[i] != prevVolumes[j]) ++n;
+            }
+            if (n < changed) {
+                shift = candidate;
+                changed = n;
+            }
+        }
+        if (changed == 0 && shift == 0) return;
+        if (changed < count) {
+            if (changed > 0) {
+                if (ask) {
+                    APPEND_LITERAL(",\"AskLevels\":[");
+                } else {
+                    APPEND_LITERAL(",\"BidLevels\":[");
+                }
+                bool first = true;
+                for (int i = 0; i < count; ++i) {
+                    int j = i + shift;
+                    if (j >= 0 && j < prevCount && prices[i] == prevPrices[j] && volumes[i] == prevVolumes[j]) continue;
+                    if (!first) APPEND_LITERAL(",");
+                    first = false;
+                    APPEND_LITERAL("[");
+                    AppendInt(i);
+                    APPEND_LITERAL(",");
+                    AppendDouble(prices[i]);
+                    APPEND_LITERAL(",");
+                    AppendInt(volumes[i]);
+                    APPEND_LITERAL("]");
+                }
+                APPEND_LITERAL("]");
+            }
+            if (shift != 0) {
+                if (ask) {
+                    APPEND_LITERAL(",\"AskShift\":");
+                } else {
+                    APPEND_LITERAL(",\"BidShift\":");
+                }
+                AppendInt(shift);
+            }
+            return;
+        }
+    }
+    if (ask) {
+        APPEND_LITERAL(",\"Asks\":");
+    } else {
+        APPEND_LITERAL(",\"Bids\":");
+    }
+    AppendLevels(prices, volumes);
+}
+
+void MdJsonEncoder::AppendLevels(const double* prices, const int* volumes) {
+    APPEND_LITERAL("[");
+    for (int i = 0; i < 5; ++i) {
+        if (volumes[i] == 0 || NumberFormat::IsInvalidPrice(prices[i])) break;
+        if (i > 0) APPEND_LITERAL(",");
+        APPEND_LITERAL("[");
+        AppendDouble(prices[i]);
+        APPEND_LITERAL(",");
+        AppendInt(volumes[i]);
+        APPEND_LITERAL("]");
+    }
+    APPEND_LITERAL("]");
+}
+
+void MdJsonEncoder::AppendRaw(const char* str, size_t len) {
+    memcpy(m_buffer + m_nSize, str, len);
+    m_nSize += len;
+}
+
+// 按 JSON 规则转义字符串，CTP 的字符数组不一定以 '\0' 结尾，因此以 maxLen 为界
+void MdJsonEncoder::AppendString(const char* str, size_t maxLen) {
+    static const char HEX[] = "0123456789abcdef";
+    char* out = m_buffer + m_nSize;
+    *out++ = '"';
+    for (size_t i = 0; i < maxLen && str[i] != '\0'; ++i) {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        switch (c) {
+            case '\b': *out++ = '\\'; *out++ = 'b'; break;
+            case '\t': *out++ = '\\'; *out++ = 't'; break;
+            case '\n': *out++ = '\\'; *out++ = 'n'; break;
+            case '\f': *out++ = '\\'; *out++ = 'f'; break;
+            case '\r': *out++ = '\\'; *out++ = 'r'; break;
+            case '"':  *out++ = '\\'; *out++ = '"'; break;
+            case '\\': *out++ = '\\'; *out++ = '\\'; break;
+            default:
+                if (c <= 0x1F) {
+                    *out++ = '\\'; *out++ = 'u'; *out++ = '0'; *out++ = '0';
+                    *out++ = HEX[c >> 4];
+                    *out++ = HEX[c & 0x0F];
+                } else {
+                    *out++ = static_cast<char>(c);
+                }
+                break;
+        }
+    }
+    *out++ = '"';
+    m_nSize = out - m_buffer;
+}
+
+// NaN/Inf 与 nlohmann::json 一致输出为 null
+void MdJsonEncoder::AppendDouble(double value) {
+    if (!std::isfinite(value)) {
+        APPEND_LITERAL("null");
+        return;
+    }
+    m_nSize = NumberFormat::FormatDouble(m_buffer + m_nSize, value) - m_buffer;
+}
+
+void MdJsonEncoder::AppendPrice(double value) {
+    if (m_bNullInvalidPrices && NumberFormat::IsInvalidPrice(value)) {
+        APPEND_LITERAL("null");
+        return;
+    }
+    AppendDouble(value);
+}
+
+void MdJsonEncoder::AppendInt(int value) {
+    m_nSize = NumberFormat::FormatInt(m_buffer + m_nSize, value) - m_buffer;
+}
@@ -0,0 +1,79 @@
+#ifndef MD_JSON_ENCODER_H
+#define MD_JSON_ENCODER_H
+
+#include <ThostFtdcUserApiStruct.h>
+
+#include <cstddef>
+#include <cstdint>
+
+struct TickDelta;
+
+// 深度行情 JSON 编码器
+// 直接从 CThostFtdcDepthMarketDataField 生成 SSE 帧（"data: {...}\n\n"），
+// 写入对象内部的固定缓冲区，编码过程不做任何堆分配。
+// 一档模式的输出格式与 nlohmann::json::dump(-1) 一致（键按字典序排列），
+// 五档模式额外输出完整盘口与持仓量、成交额等字段；开启逐笔增量时两种模式都加上
+// DeltaKind、DeltaOpenInterest、DeltaTurnover、DeltaVolume 和 TradePrice（仍按字典序插入）；
+// 浮点数使用 NumberFormat 输出最短可往返表示，数值与 dump() 相同，
+// 但少数 Grisu2 不是最短的数值字面不同（见 NumberFormat::FormatDouble），不能逐字节比较。
+// 非线程安全：每个回调线程应持有自己的编码器实例。
+class MdJsonEncoder
+{
+public:
+    static const size_t BUFFER_SIZE = 4096;
+
+    MdJsonEncoder();
+
+    // 编码一条行情，返回帧长度；帧内容通过 Data() 获取，在下一次编码前有效
+    // pDelta 为空或未开启逐笔增量时不输出增量字段
+    size_t EncodeSse(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta = nullptr);
+
+    // 变化字段编码：只输出与同一合约上一条行情 pPrev（及其增量 pPrevDelta）不同的字段，InstrumentID 总是输出，
+    // 另加合约内递增的序号 "Seq"；pPrev 为空时输出全部字段并加上 "Full":true。
+    // 五档盘口只有部分档位变化时输出 "AskLevels"/"BidLevels":[[档位,价格,数量],...]，价格变动导致整体移位时
+    // 另加 "AskShift"/"BidShift"（见 AppendSide），否则输出整侧 "Asks"/"Bids"。
+    // 读取方按合约把各帧的字段合并到上一状态即得到完整行情，Seq 不连续时等待下一个完整帧
+    size_t EncodeSseChanged(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta,
+                            const CThostFtdcDepthMarketDataField* pPrev, const TickDelta* pPrevDelta, uint64_t seq);
+
+    // 开启后，CTP 的无效价格（DBL_MAX）输出为 null 而不是 1.7976931348623157e+308
+    void SetNullInvalidPrices(bool enable) { m_bNullInvalidPrices = enable; }
+
+    // 输出逐笔增量字段（见 TickDeltaTracker）
+    void SetTickDeltas(bool enable) { m_bTickDeltas = enable; }
+
+    // 盘口深度：1 为一档（默认，兼容原有格式），5 为五档
+    void SetDepth(int depth);
+
+    const char* Data() const { return m_buffer; }
+    size_t Size() const { return m_nSize; }
+
+private:
+    size_t Encode(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta);
+    void AppendL1(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta);
+    void AppendL5(const CThostFtdcDepthMarketDataField* pData, const TickDelta* pDelta);
+    void AppendDeltas(const TickDelta* pDelta);
+    void AppendTradePrice(const TickDelta* pDelta);
+    void AppendSeq();
+    void AppendSide(bool ask, const double* prices, const int* volumes, const double* prevPrices, const int* prevVolumes);
+    void AppendLevels(const double* prices, const int* volumes);
+
+    void AppendRaw(const char* str, size_t len);
+    void AppendString(const char* str, size_t maxLen);
+    void AppendDouble(double value);
+    void AppendPrice(double value);
+    void AppendInt(int value);
+
+    char m_buffer[BUFFER_SIZE];
+    size_t m_nSize;
+    bool m_bNullInvalidPrices;
+    bool m_bTickDeltas;
+    int m_nDepth;
+
+    // 当前这一帧的变化字段编码参数，m_pPrev 为空时输出全部字段，m_nFrameSeq 为 0 时不输出 Seq
+    const CThostFtdcDepthMarketDataField* m_pPrev;
+    const TickDelta* m_pPrevDelta;
+    uint64_t m_nFrameSeq;
+};
+
+#endif // MD_JSON_ENCODER_H
@@ -0,0 +1,269 @@
+#ifndef MD_SHM_FORMAT_H
+#define MD_SHM_FORMAT_H
+
+// 共享内存行情广播环（--shm=NAME）的内存布局与只读客户端
+// 下游 C++ 程序包含本文件即可挂载到 /dev/shm/NAME 读取行情，无需链接其他代码。
+//
+// 布局（各段起始位置按 4096 对齐）：
+//   MdShmHeader
+//   MdBinaryInstrumentDef[InstrumentCapacity]   合约编号 -> 合约代码
+//   MdShmSlot[SlotCount]                        行情环形缓冲区
+//   MdShmSlot[InstrumentCapacity]               合约编号 -> 该合约的最新一条行情
+//
+// 发布端是唯一的写者，为每条行情分配从 1 开始的递增序号 seq，写入 slot[seq % SlotCount]：
+//   slot.Seq = 0 -> 写入记录 -> slot.Seq = seq -> Header.WriteSeq = seq
+// 读取方各自维护游标，读取前后两次检查 slot.Seq 是否等于游标（seqlock），
+// 不一致说明该槽位已被覆盖，即读取方落后超过一整圈（overrun）。
+// 每条行情同时按同样的方式写入所属合约的最新值槽位（Seq 为该行情的序号）。
+// 开启合并模式的读取方在 overrun 后，先从最新值表中取回丢失区间内各合约的最新一条，
+// 再继续读取环，慢读取方丢失的只是被更新行情取代的中间状态。
+
+#include "MdBinaryFormat.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define MD_SHM_MAGIC     0x53505443u   /* "CTPS"（小端序） */
+#define MD_SHM_VERSION   2
+#define MD_SHM_SLOT_SIZE 256
+#define MD_SHM_ALIGN     4096
+
+struct MdShmHeader
+{
+    uint32_t Magic;                 // MD_SHM_MAGIC，发布端初始化完成后最后写入
+    uint16_t Version;               // MD_SHM_VERSION
+    uint16_t HeaderSize;            // sizeof(MdShmHeader)
+    uint32_t SlotSize;              // sizeof(MdShmSlot)
+    uint32_t SlotCount;             // 槽位数，2 的幂
+    uint32_t InstrumentCapacity;    // 合约表容量
+    uint32_t Reserved;
+    uint64_t InstrumentTableOffset; // 合约表相对映射起始位置的偏移
+    uint64_t SlotsOffset;           // 槽位数组相对映射起始位置的偏移
+    uint64_t LatestOffset;          // 最新值表相对映射起始位置的偏移
+    uint64_t TotalSize;             // 整个共享内存对象的大小
+    int64_t PriceScale;             // MD_BINARY_PRICE_SCALE
+    int64_t CreateTimeNs;           // 发布端创建时间，读取方可据此发现发布端已重启
+
+    alignas(64) std::atomic<uint32_t> InstrumentCount;  // 合约表中已发布的条目数
+    alignas(64) std::atomic<uint64_t> WriteSeq;         // 最近发布的行情序号，0 表示尚无数据
+};
+
+struct MdShmSlot
+{
+    std::atomic<uint64_t> Seq;      // 槽位中记录的序号，写入过程中为 0
+    MdBinaryTickL5 Tick;
+    char Padding[MD_SHM_SLOT_SIZE - sizeof(std::atomic<uint64_t>) - sizeof(MdBinaryTickL5)];
+};
+
+static_assert(sizeof(MdShmSlot) == MD_SHM_SLOT_SIZE, "MdShmSlot layout changed");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+
+inline uint64_t MdShmAlign(uint64_t n) {
+    return (n + MD_SHM_ALIGN - 1) / MD_SHM_ALIGN * MD_SHM_ALIGN;
+}
+
+// 只读客户端：任意数量的进程可同时挂载，各自持有独立的游标
+class MdShmReader
+{
+public:
+    enum ReadResult
+    {
+        READ_OK,        // 读到一条行情
+        READ_EMPTY,     // 没有新行情
+        READ_OVERRUN    // 落后超过一整圈，游标已跳到较新的位置，丢失条数见 Lost()
+    };
+
+    MdShmReader() : m_pBase(nullptr), m_nSize(0), m_pHeader(nullptr), m_pSlots(nullptr), m_pLatest(nullptr),
+                    m_nMask(0), m_nCursor(1), m_nLost(0), m_nOverruns(0), m_bConflate(false),
+                    m_pReading(nullptr), m_nReadingSeq(0), m_nRecovered(0) {}
+    ~MdShmReader() { Close(); }
+
+    MdShmReader(const MdShmReader&) = delete;
+    MdShmReader& operator=(const MdShmReader&) = delete;
+
+    // 以只读方式挂载，游标定位到最新位置（只读取之后发布的行情）
+    bool Open(const char* name) {
+        Close();
+        int fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(MdShmHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+
+        const MdShmHeader* header = static_cast<const MdShmHeader*>(p);
+        if (header->Magic != MD_SHM_MAGIC || header->Version != MD_SHM_VERSION ||
+            header->SlotSize != MD_SHM_SLOT_SIZE || header->TotalSize > static_cast<uint64_t>(st.st_size)) {
+            munmap(p, st.st_size);
+            return false;
+        }
+        m_pBase = static_cast<const char*>(p);
+        m_nSize = st.st_size;
+        m_pHeader = header;
+        m_pSlots = reinterpret_cast<const MdShmSlot*>(m_pBase + header->SlotsOffset);
+        m_pLatest = reinterpret_cast<const MdShmSlot*>(m_pBase + header->LatestOffset);
+        m_nMask = header->SlotCount - 1;
+        SeekToLatest();
+        return true;
+    }
+
+    void Close() {
+        if (m_pBase) munmap(const_cast<char*>(m_pBase), m_nSize);
+        m_pBase = nullptr;
+        m_pHeader = nullptr;
+        m_pSlots = nullptr;
+        m_pLatest = nullptr;
+        m_pending.clear();
+    }
+
+    bool IsOpen() const { return m_pBase != nullptr; }
+    const MdShmHeader* Header() const { return m_pHeader; }
+
+    // 合并模式：overrun 后不直接丢弃，而是先补发丢失区间内各合约的最新一条行情
+    void SetConflate(bool enable) { m_bConflate = enable; }
+
+    // 游标定位到最新位置
+    void SeekToLatest() { m_nCursor = m_pHeader->WriteSeq.load(std::memory_order_acquire) + 1; }
+
+    // 游标定位到环中仍保留的最早一条行情
+    void SeekToOldest() {
+        uint64_t w = m_pHeader->WriteSeq.load(std::memory_order_acquire);
+        m_nCursor = w > m_nMask ? w - m_nMask : 1;
+    }
+
+    // 零拷贝读取：返回指向共享内存槽位的指针，使用完毕后必须调用 EndRead() 校验
+    ReadResult BeginRead(const MdBinaryTickL5*& tick) {
+        // 补发的最新值早于游标，先于环中的行情交付；已被更新到游标之后的合约会在环中读到，跳过
+        while (!m_pending.empty()) {
+            const MdShmSlot& latest = m_pLatest[m_pending.back()];
+            uint64_t seq = latest.Seq.load(std::memory_order_acquire);
+            if (seq != 0 && seq < m_nCursor) {
+                m_pReading = &latest;
+                m_nReadingSeq = seq;
+                tick = &latest.Tick;
+                return READ_OK;
+            }
+            m_pending.pop_back();
+        }
+
+        uint64_t w = m_pHeader->WriteSeq.load(std::memory_order_acquire);
+        if (m_nCursor > w) return READ_EMPTY;
+        if (w - m_nCursor > m_nMask) {
+            Resync(w);
+            return READ_OVERRUN;
+        }
+        const MdShmSlot& slot = m_pSlots[m_nCursor & m_nMask];
+        if (slot.Seq.load(std::memory_order_acquire) != m_nCursor) {
+            Resync(w);
+            return READ_OVERRUN;
+        }
+        m_pReading = &slot;
+        m_nReadingSeq = m_nCursor;
+        tick = &slot.Tick;
+        return READ_OK;
+    }
+
+    // 返回 true 表示 BeginRead() 取得的数据在读取期间未被覆盖，游标前进；
+    // 返回 false 表示数据已失效（overrun），游标已重新定位，应丢弃刚才读到的内容
+    bool EndRead() {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool valid = m_pReading->Seq.load(std::memory_order_relaxed) == m_nReadingSeq;
+        if (!m_pending.empty()) {
+            // 读取期间最新值被改写：新行情的序号必然不小于游标，之后会在环中读到
+            m_pending.pop_back();
+            if (valid) ++m_nRecovered;
+            return valid;
+        }
+        if (!valid) {
+            Resync(m_pHeader->WriteSeq.load(std::memory_order_acquire));
+            return false;
+        }
+        ++m_nCursor;
+        return true;
+    }
+
+    // 拷贝读取
+    ReadResult Read(MdBinaryTickL5& out) {
+        const MdBinaryTickL5* tick = nullptr;
+        ReadResult ret = BeginRead(tick);
+        if (ret != READ_OK) return ret;
+        memcpy(&out, tick, sizeof(out));
+        return EndRead() ? READ_OK : READ_OVERRUN;
+    }
+
+    // 拷贝某个合约的最新一条行情，该合约尚无行情时返回 false；可用于挂载后获取快照
+    bool ReadLatest(uint32_t index, MdBinaryTickL5& out) const {
+        if (index >= m_pHeader->InstrumentCapacity) return false;
+        const MdShmSlot& latest = m_pLatest[index];
+        // Seq 为 0 可能是从未写入，也可能是正在写入：短暂重试后仍为 0 则视为尚无行情
+        for (int spins = 0; spins < 1000; ++spins) {
+            uint64_t seq = latest.Seq.load(std::memory_order_acquire);
+            if (seq == 0) continue;
+            memcpy(&out, &latest.Tick, sizeof(out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (latest.Seq.load(std::memory_order_relaxed) == seq) return true;
+        }
+        return false;
+    }
+
+    // 合约编号对应的代码，编号尚未发布时返回 nullptr
+    const char* InstrumentID(uint32_t index) const {
+        if (index >= m_pHeader->InstrumentCount.load(std::memory_order_acquire)) return nullptr;
+        const MdBinaryInstrumentDef* table =
+            reinterpret_cast<const MdBinaryInstrumentDef*>(m_pBase + m_pHeader->InstrumentTableOffset);
+        return table[index].InstrumentID;
+    }
+
+    uint64_t Cursor() const { return m_nCursor; }
+    uint64_t Lost() const { return m_nLost; }
+    uint64_t Overruns() const { return m_nOverruns; }
+    // 合并模式下补发的最新值条数；合并率 = 1 - Recovered() / Lost()，即丢失的行情中被更新行情取代的比例
+    uint64_t Recovered() const { return m_nRecovered; }
+
+private:
+    // 跳过被覆盖的部分，留出半圈余量以免立刻再次被追上
+    void Resync(uint64_t writeSeq) {
+        uint64_t target = writeSeq > m_nMask / 2 ? writeSeq - m_nMask / 2 : 1;
+        if (target > m_nCursor) m_nLost += target - m_nCursor;
+        uint64_t from = m_nCursor;
+        m_nCursor = target > m_nCursor ? target : m_nCursor + 1;
+        ++m_nOverruns;
+
+        // 合并模式：记下最新一条落在丢失区间 [from, m_nCursor) 内的合约
+        if (!m_bConflate) return;
+        uint32_t count = m_pHeader->InstrumentCount.load(std::memory_order_acquire);
+        for (uint32_t i = count; i > 0; --i) {
+            uint64_t seq = m_pLatest[i - 1].Seq.load(std::memory_order_relaxed);
+            if (seq >= from && seq < m_nCursor) m_pending.push_back(i - 1);
+        }
+    }
+
+    const char* m_pBase;
+    size_t m_nSize;
+    const MdShmHeader* m_pHeader;
+    const MdShmSlot* m_pSlots;
+    const MdShmSlot* m_pLatest;
+    uint64_t m_nMask;
+    uint64_t m_nCursor;     // 下一条要读取的序号
+    uint64_t m_nLost;
+    uint64_t m_nOverruns;
+
+    bool m_bConflate;
+    std::vector<uint32_t> m_pending;    // 待补发最新值的合约编号
+    const MdShmSlot* m_pReading;        // BeginRead() 返回的槽位及其序号，供 EndRead() 校验
+    uint64_t m_nReadingSeq;
+    uint64_t m_nRecovered;
+};
+
+#endif // MD_SHM_FORMAT_H
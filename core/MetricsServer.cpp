@@ -0,0 +1,228 @@
+#include "MetricsServer.h"
+#include "MetricsWriter.h"
+#include "MyMdSpi.h"
+#include "TickRecord.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// HTTP 请求头的最大长度，超出后断开
+static const size_t MAX_REQUEST_SIZE = 8192;
+// 同时保持的连接数上限
+static const size_t MAX_CONNECTIONS = 16;
+// 连接后未在该时间内收完请求并写完响应时关闭，防止空连接占满 MAX_CONNECTIONS
+static const int64_t REQUEST_TIMEOUT_NS = 5 * 1000000000LL;
+// poll 的最长阻塞时间，用于检查超时的连接
+static const int POLL_TIMEOUT_MS = 1000;
+
+static const char NOT_FOUND_RESPONSE[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 10\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "Not Found\n";
+
+MetricsServer::MetricsServer()
+    : m_nListenFd(-1), m_nEventFd(-1), m_bRunning(false), m_pPipeline(nullptr) {}
+
+MetricsServer::~MetricsServer() {
+    Stop();
+}
+
+bool MetricsServer::Start(int port) {
+    m_nListenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_nListenFd < 0) {
+        std::cerr << "socket failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    int one = 1;
+    setsockopt(m_nListenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(m_nListenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(m_nListenFd, 16) != 0) {
+        std::cerr << "bind/listen on port " << port << " failed: " << strerror(errno) << std::endl;
+        close(m_nListenFd);
+        m_nListenFd = -1;
+        return false;
+    }
+    m_nEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_nEventFd < 0) {
+        std::cerr << "eventfd creation failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_bRunning = true;
+    m_thread = std::thread(&MetricsServer::Run, this);
+    std::cerr << "Metrics server listening on 0.0.0.0:" << port << "/metrics" << std::endl;
+    return true;
+}
+
+void MetricsServer::Stop() {
+    if (m_bRunning.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t ret = write(m_nEventFd, &one, sizeof(one));
+        (void)ret;
+        if (m_thread.joinable()) m_thread.join();
+    }
+    for (size_t i = 0; i < m_connections.size(); ++i) close(m_connections[i].Fd);
+    m_connections.clear();
+    if (m_nListenFd >= 0) close(m_nListenFd);
+    if (m_nEventFd >= 0) close(m_nEventFd);
+    m_nListenFd = m_nEventFd = -1;
+}
+
+std::string MetricsServer::Collect() const {
+    MetricsWriter out;
+
+    std::vector<MyMdSpi::Stats> stats;
+    std::vector<std::string> labels;
+    for (size_t i = 0; i < m_sessions.size(); ++i) {
+        stats.push_back(m_sessions[i]->GetStats());
+        labels.push_back(MetricsWriter::Label("session", std::to_string(m_sessions[i]->Session())));
+    }
+    out.Family("ctp_md_session_connected", "gauge", "Whether the session is connected to its front");
+    for (size_t i = 0; i < m_sessions.size(); ++i) {
+        out.Sample(labels[i], static_cast<uint64_t>(m_sessions[i]->m_bIsConnected.load()));
+    }
+    out.Family("ctp_md_session_logged_in", "gauge", "Whether the session is logged in");
+    for (size_t i = 0; i < m_sessions.size(); ++i) {
+        out.Sample(labels[i], static_cast<uint64_t>(m_sessions[i]->m_bIsLogin.load()));
+    }
+    out.Family("ctp_md_front_disconnects_total", "counter", "OnFrontDisconnected callbacks");
+    for (size_t i = 0; i < stats.size(); ++i) out.Sample(labels[i], stats[i].Disconnects);
+    out.Family("ctp_md_heartbeat_warnings_total", "counter", "OnHeartBeatWarning callbacks");
+    for (size_t i = 0; i < stats.size(); ++i) out.Sample(labels[i], stats[i].HeartBeatWarnings);
+    out.Family("ctp_md_subscribe_failures_total", "counter", "Failed OnRspSubMarketData responses");
+    for (size_t i = 0; i < stats.size(); ++i) out.Sample(labels[i], stats[i].SubscribeFailures);
+
+    if (m_pPipeline) m_pPipeline->WriteMetrics(out);
+    return out.Text();
+}
+
+void MetricsServer::Run() {
+    std::vector<struct pollfd> fds;
+
+    while (m_bRunning.load()) {
+        fds.clear();
+        fds.push_back({m_nEventFd, POLLIN, 0});
+        fds.push_back({m_nListenFd, POLLIN, 0});
+        for (size_t i = 0; i < m_connections.size(); ++i) {
+            fds.push_back({m_connections[i].Fd, static_cast<short>(m_connections[i].Out.empty() ? POLLIN : POLLOUT), 0});
+        }
+        int n = poll(fds.data(), fds.size(), m_connections.empty() ? -1 : POLL_TIMEOUT_MS);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "poll failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (fds[0].revents) break;
+
+        for (size_t i = 0; i < m_connections.size(); ++i) {
+            if (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) ReadConnection(m_connections[i]);
+            FlushConnection(m_connections[i]);
+        }
+        int64_t now = MonotonicNanos();
+        for (size_t i = 0; i < m_connections.size();) {
+            Connection& conn = m_connections[i];
+            if (conn.Fd < 0 || (conn.Responded && conn.Out.empty()) || now - conn.AcceptNs >= REQUEST_TIMEOUT_NS) {
+                if (conn.Fd >= 0) close(conn.Fd);
+                m_connections.erase(m_connections.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+        if (fds[1].revents & POLLIN) Accept();
+    }
+}
+
+void MetricsServer::Accept() {
+    while (true) {
+        int fd = accept4(m_nListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "accept failed: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        if (m_connections.size() >= MAX_CONNECTIONS) {
+            close(fd);
+            continue;
+        }
+        Connection conn;
+        conn.Fd = fd;
+        conn.Responded = false;
+        conn.AcceptNs = MonotonicNanos();
+        m_connections.push_back(conn);
+    }
+}
+
+// 收齐请求头后生成响应：只支持 GET /metrics，每个连接只处理一个请求
+void MetricsServer::ReadConnection(Connection& conn) {
+    char buf[4096];
+    bool closed = false;
+    while (true) {
+        ssize_t n = recv(conn.Fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            conn.In.append(buf, n);
+            if (conn.In.size() > MAX_REQUEST_SIZE) {
+                closed = true;
+                break;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) closed = true;
+        break;
+    }
+
+    if (!conn.Responded && conn.In.find("\r\n\r\n") != std::string::npos) {
+        conn.Responded = true;
+        bool isMetrics = conn.In.compare(0, 13, "GET /metrics ") == 0 || conn.In.compare(0, 13, "GET /metrics?") == 0;
+        if (isMetrics) {
+            std::string body = Collect();
+            conn.Out = "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/plain; version=0.0.4\r\n"
+                       "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                       "Connection: close\r\n"
+                       "\r\n";
+            conn.Out += body;
+        } else {
+            conn.Out.assign(NOT_FOUND_RESPONSE, sizeof(NOT_FOUND_RESPONSE) - 1);
+        }
+        conn.In.clear();
+    }
+    // 对端关闭写方向时已生成的响应仍然写出
+    if (closed && !conn.Responded) {
+        close(conn.Fd);
+        conn.Fd = -1;
+    }
+}
+
+void MetricsServer::FlushConnection(Connection& conn) {
+    while (conn.Fd >= 0 && !conn.Out.empty()) {
+        ssize_t n = send(conn.Fd, conn.Out.data(), conn.Out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.Out.erase(0, n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                close(conn.Fd);
+                conn.Fd = -1;
+            }
+            return;
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+class MyMdSpi;
+class TickPipeline;
+
+// Prometheus 抓取端点（--metrics-port=PORT），在独立线程中响应 GET /metrics。
+// 各计数器都由各自的写入线程独占（回调线程、流水线工作线程、SSE 服务器线程），
+// 只有抓取时才逐一读取汇总，行情路径上不增加任何共享写入或锁。
+// 指标：各队列的入队、丢弃、深度，逐合约行情数，各输出端字节数，各会话的断线、心跳超时、
+// 订阅失败次数，以及流水线各阶段的延迟直方图（见 TickPipeline.h）。
+// 例：curl -s http://127.0.0.1:9100/metrics
+class MetricsServer
+{
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    // 以下设置须在 Start() 之前调用
+    void SetPipeline(const TickPipeline* pPipeline) { m_pPipeline = pPipeline; }
+    void AddSession(const MyMdSpi* pSpi) { m_sessions.push_back(pSpi); }
+
+    // 监听 0.0.0.0:port 并启动服务线程，失败时返回 false 并在 stderr 输出原因
+    bool Start(int port);
+    void Stop();
+
+    // 生成一次完整的指标文本
+    std::string Collect() const;
+
+private:
+    struct Connection
+    {
+        int Fd;
+        std::string In;             // 尚未收完的请求头
+        std::string Out;            // 尚未写出的响应
+        bool Responded;             // 已生成响应，写完后关闭
+        int64_t AcceptNs;           // 建立连接的时间（单调时钟），超时据此判断
+    };
+
+    void Run();
+    void Accept();
+    void ReadConnection(Connection& conn);
+    void FlushConnection(Connection& conn);
+
+    int m_nListenFd;
+    int m_nEventFd;
+    std::thread m_thread;
+    std::atomic<bool> m_bRunning;
+    const TickPipeline* m_pPipeline;
+    std::vector<const MyMdSpi*> m_sessions;
+    std::vector<Connection> m_connections;      // 只在服务线程中访问
+};
+
+#endif // METRICS_SERVER_H
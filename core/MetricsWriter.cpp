@@ -0,0 +1,91 @@
+#include "MetricsWriter.h"
+#include <cstdio>
+
+// 直方图的 le 边界（纳秒）
+static const uint64_t HISTOGRAM_BOUNDS_NS[] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000,
+    1000000, 2000000, 5000000, 10000000, 20000000, 50000000, 100000000, 1000000000
+};
+
+void MetricsWriter::Family(const char* name, const char* type, const char* help) {
+    m_family = name;
+    m_text += "# HELP ";
+    m_text += name;
+    m_text += ' ';
+    m_text += help;
+    m_text += "\n# TYPE ";
+    m_text += name;
+    m_text += ' ';
+    m_text += type;
+    m_text += '\n';
+}
+
+void MetricsWriter::Sample(const std::string& labels, uint64_t value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value));
+    AppendSample("", labels, buf);
+}
+
+void MetricsWriter::Sample(const std::string& labels, double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+    AppendSample("", labels, buf);
+}
+
+void MetricsWriter::Histogram(const std::string& labels, const LatencyHistogram::Snapshot& snapshot,
+                              double nanosPerUnit) {
+    std::string prefix = labels.empty() ? std::string() : labels + ",";
+    char le[32];
+    char buf[32];
+    uint64_t cumulative = 0;
+    size_t bucket = 0;
+    for (size_t i = 0; i < sizeof(HISTOGRAM_BOUNDS_NS) / sizeof(HISTOGRAM_BOUNDS_NS[0]); ++i) {
+        // 上界不超过边界的桶全部计入
+        double limit = HISTOGRAM_BOUNDS_NS[i] / nanosPerUnit;
+        for (; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+            double upper = static_cast<double>(LatencyHistogram::BucketLow(bucket)) +
+                           static_cast<double>(LatencyHistogram::BucketWidth(bucket) - 1);
+            if (upper > limit) break;
+            cumulative += snapshot.Counts[bucket];
+        }
+        snprintf(le, sizeof(le), "%g", HISTOGRAM_BOUNDS_NS[i] / 1e9);
+        snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(cumulative));
+        AppendSample("_bucket", prefix + Label("le", le), buf);
+    }
+    snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(snapshot.Count));
+    AppendSample("_bucket", prefix + "le=\"+Inf\"", buf);
+    AppendSample("_count", labels, buf);
+    snprintf(buf, sizeof(buf), "%.9g", snapshot.Sum * nanosPerUnit / 1e9);
+    AppendSample("_sum", labels, buf);
+}
+
+std::string MetricsWriter::Label(const char* key, const std::string& value) {
+    std::string label = key;
+    label += "=\"";
+    for (size_t i = 0; i < value.size(); ++i) {
+        char c = value[i];
+        if (c == '\\' || c == '"') {
+            label += '\\';
+            label += c;
+        } else if (c == '\n') {
+            label += "\\n";
+        } else {
+            label += c;
+        }
+    }
+    label += '"';
+    return label;
+}
+
+void MetricsWriter::AppendSample(const char* suffix, const std::string& labels, const char* value) {
+    m_text += m_family;
+    m_text += suffix;
+    if (!labels.empty()) {
+        m_text += '{';
+        m_text += labels;
+        m_text += '}';
+    }
+    m_text += ' ';
+    m_text += value;
+    m_text += '\n';
+}
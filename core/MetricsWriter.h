@@ -0,0 +1,37 @@
+#ifndef METRICS_WRITER_H
+#define METRICS_WRITER_H
+
+#include "LatencyHistogram.h"
+
+#include <cstdint>
+#include <string>
+
+// Prometheus 文本格式（0.0.4）的生成器，供 /metrics 拼装响应体
+// 每个指标族先调用 Family() 输出 HELP 和 TYPE，随后的样本都属于该族，同一族只能出现一次。
+// labels 参数为花括号内的内容，例如 Label("lane", "0")，多个标签以逗号连接，空串表示没有标签。
+class MetricsWriter
+{
+public:
+    // type 为 counter、gauge 或 histogram
+    void Family(const char* name, const char* type, const char* help);
+
+    void Sample(const std::string& labels, uint64_t value);
+    void Sample(const std::string& labels, double value);
+
+    // 当前族的直方图样本：固定边界（1 微秒至 1 秒）上的累计计数、_sum（秒）和 _count；
+    // nanosPerUnit 为快照中每个计数单位对应的纳秒数。边界落在桶内部时按桶的上界计，误差不超过桶宽
+    void Histogram(const std::string& labels, const LatencyHistogram::Snapshot& snapshot, double nanosPerUnit);
+
+    // key="value"，对值中的反斜杠、双引号和换行转义
+    static std::string Label(const char* key, const std::string& value);
+
+    const std::string& Text() const { return m_text; }
+
+private:
+    void AppendSample(const char* suffix, const std::string& labels, const char* value);
+
+    std::string m_text;
+    std::string m_family;           // 当前族的名称
+};
+
+#endif // METRICS_WRITER_H
@@ -0,0 +1,441 @@
+#include "MockMdApi.h"
+#include "TickRecord.h"
+#include "config.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+// 模拟断线后重新连接的等待时间
+static const int64_t RECONNECT_DELAY_NS = 1000000000LL;
+// 断线原因：网络读失败，与真实前置断线时最常见的原因一致
+static const int DISCONNECT_REASON = 0x1001;
+// 不限速时每批生成的行情数，批间检查请求队列
+static const int UNPACED_BATCH = 256;
+// 限速时单次最多补发的行情数，避免长时间阻塞请求应答
+static const int MAX_BURST = 1024;
+// 价格以最小变动价位（0.2）的整数倍保存，输出时除以 TICKS_PER_UNIT，避免累加产生的浮点误差
+static const int TICKS_PER_UNIT = 5;
+static const int VOLUME_MULTIPLE = 10;
+
+// m_tradingDay、m_updateTime 按字段长度整体拷贝
+static_assert(sizeof(TThostFtdcDateType) == 9 && sizeof(TThostFtdcTimeType) == 9, "unexpected CTP field size");
+
+MockMdApi::Options MockMdApi::OptionsFromConfig() {
+    Options options;
+    options.TickRate = MOCK_TICK_RATE;
+    options.ResponseDelayMs = MOCK_RESPONSE_DELAY_MS;
+    options.DisconnectIntervalSec = MOCK_DISCONNECT_INTERVAL_SEC;
+    options.DurationSec = MOCK_DURATION_SEC;
+    return options;
+}
+
+MockMdApi::MockMdApi(const char* flowPath, const Options& options)
+    : m_flowPath(flowPath ? flowPath : ""), m_options(options), m_pSpi(nullptr), m_bStarted(false), m_bStop(false),
+      m_bFinished(false), m_bConnected(false), m_bLoggedIn(false), m_nCursor(0),
+      m_nRandom(0x9E3779B97F4A7C15ULL), m_nClockSecond(-1), m_nTicks(0) {
+    time_t now = time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    strftime(m_tradingDay, sizeof(m_tradingDay), "%Y%m%d", &local);
+    memset(m_updateTime, 0, sizeof(m_updateTime));
+}
+
+MockMdApi::~MockMdApi() {}
+
+void MockMdApi::Release() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+        m_bFinished = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+    delete this;
+}
+
+void MockMdApi::Init() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_bStarted) return;
+        m_bStarted = true;
+    }
+    std::cerr << "MockMdApi: simulating front " << (m_front.empty() ? "(none)" : m_front) << ", "
+              << (m_options.TickRate > 0 ? std::to_string(m_options.TickRate) + " ticks/s" : std::string("unpaced"))
+              << std::endl;
+    m_thread = std::thread(&MockMdApi::Run, this);
+}
+
+int MockMdApi::Join() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_bStarted) return -1;
+    m_cond.wait(lock, [this]() { return m_bFinished; });
+    return 0;
+}
+
+const char* MockMdApi::GetTradingDay() {
+    return m_tradingDay;
+}
+
+void MockMdApi::RegisterFront(char* pszFrontAddress) {
+    if (pszFrontAddress) m_front = pszFrontAddress;
+}
+
+void MockMdApi::RegisterNameServer(char* pszNsAddress) {
+    if (pszNsAddress) m_front = pszNsAddress;
+}
+
+void MockMdApi::RegisterFensUserInfo(CThostFtdcFensUserInfoField*) {}
+
+void MockMdApi::RegisterSpi(CThostFtdcMdSpi* pSpi) {
+    m_pSpi = pSpi;
+}
+
+int MockMdApi::SubscribeMarketData(char* ppInstrumentID[], int nCount) {
+    return Enqueue(RequestType::Subscribe, 0, ppInstrumentID, nCount);
+}
+
+int MockMdApi::UnSubscribeMarketData(char* ppInstrumentID[], int nCount) {
+    return Enqueue(RequestType::Unsubscribe, 0, ppInstrumentID, nCount);
+}
+
+int MockMdApi::SubscribeForQuoteRsp(char* ppInstrumentID[], int nCount) {
+    return Enqueue(RequestType::SubscribeQuote, 0, ppInstrumentID, nCount);
+}
+
+int MockMdApi::UnSubscribeForQuoteRsp(char* ppInstrumentID[], int nCount) {
+    return Enqueue(RequestType::UnsubscribeQuote, 0, ppInstrumentID, nCount);
+}
+
+int MockMdApi::ReqUserLogin(CThostFtdcReqUserLoginField* pReqUserLoginField, int nRequestID) {
+    if (!pReqUserLoginField) return -1;
+    Request request;
+    request.Type = RequestType::Login;
+    request.RequestID = nRequestID;
+    request.BrokerID = pReqUserLoginField->BrokerID;
+    request.UserID = pReqUserLoginField->UserID;
+    return Submit(request);
+}
+
+int MockMdApi::ReqUserLogout(CThostFtdcUserLogoutField*, int nRequestID) {
+    return Enqueue(RequestType::Logout, nRequestID, nullptr, 0);
+}
+
+int MockMdApi::ReqQryMulticastInstrument(CThostFtdcQryMulticastInstrumentField*, int nRequestID) {
+    return Enqueue(RequestType::QueryMulticast, nRequestID, nullptr, 0);
+}
+
+int MockMdApi::Enqueue(RequestType type, int requestID, char* ppInstrumentID[], int nCount) {
+    bool needInstruments = type != RequestType::Logout && type != RequestType::QueryMulticast;
+    if (needInstruments && (!ppInstrumentID || nCount <= 0)) return -1;
+
+    Request request;
+    request.Type = type;
+    request.RequestID = requestID;
+    for (int i = 0; needInstruments && i < nCount; ++i) {
+        if (ppInstrumentID[i]) request.Instruments.push_back(ppInstrumentID[i]);
+    }
+    return Submit(request);
+}
+
+// 请求只入队，由回调线程在 ResponseDelayMs 之后应答；回调线程未运行时与网络不通的真实 API 一样返回 -1
+int MockMdApi::Submit(Request& request) {
+    request.DueNs = MonotonicNanos() + m_options.ResponseDelayMs * 1000000LL;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_bStop || !m_bStarted) return -1;
+        m_requests.push_back(std::move(request));
+    }
+    m_cond.notify_all();
+    return 0;
+}
+
+void MockMdApi::Run() {
+    const int64_t startNs = MonotonicNanos();
+    const int64_t never = INT64_MAX;
+    const int64_t finishAt = m_options.DurationSec > 0 ? startNs + m_options.DurationSec * 1000000000LL : never;
+    const int64_t disconnectInterval = m_options.DisconnectIntervalSec * 1000000000LL;
+    int64_t connectAt = startNs;
+    int64_t disconnectAt = disconnectInterval > 0 ? startNs + disconnectInterval : never;
+    bool finished = false;
+
+    // 限速时第 n 条行情的计划时间为 tickBase + n / TickRate
+    int64_t tickBase = startNs;
+    uint64_t paced = 0;
+    std::vector<Request> due;
+
+    while (true) {
+        int64_t now = MonotonicNanos();
+        if (!finished && now >= finishAt) {
+            finished = true;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bFinished = true;
+            m_cond.notify_all();
+        }
+
+        if (!m_bConnected && now >= connectAt) {
+            m_bConnected = true;
+            if (m_pSpi) m_pSpi->OnFrontConnected();
+        } else if (m_bConnected && !finished && now >= disconnectAt) {
+            Disconnect();
+            connectAt = now + RECONNECT_DELAY_NS;
+            disconnectAt = now + disconnectInterval;
+        }
+
+        // 取出已到应答时间的请求，在锁外回调
+        int64_t wakeAt = m_bConnected ? disconnectAt : connectAt;
+        if (!finished) wakeAt = std::min(wakeAt, finishAt);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_bStop) break;
+            while (!m_requests.empty() && m_requests.front().DueNs <= now) {
+                due.push_back(std::move(m_requests.front()));
+                m_requests.pop_front();
+            }
+            if (!m_requests.empty()) wakeAt = std::min(wakeAt, m_requests.front().DueNs);
+        }
+        for (size_t i = 0; i < due.size(); ++i) Respond(due[i]);
+        bool responded = !due.empty();
+        due.clear();
+
+        if (!finished && m_bLoggedIn && !m_instruments.empty()) {
+            if (m_options.TickRate <= 0) {
+                for (int i = 0; i < UNPACED_BATCH; ++i) EmitTick();
+                continue;
+            }
+            // 落后超过一秒（如刚订阅完成）时不补发，从当前时刻重新计时
+            if (now - (tickBase + static_cast<int64_t>(paced * 1e9 / m_options.TickRate)) > 1000000000LL) {
+                tickBase = now;
+                paced = 0;
+            }
+            int burst = 0;
+            int64_t next;
+            while ((next = tickBase + static_cast<int64_t>(paced * 1e9 / m_options.TickRate)) <= now && burst < MAX_BURST) {
+                EmitTick();
+                ++paced;
+                ++burst;
+            }
+            wakeAt = std::min(wakeAt, next);
+        } else {
+            tickBase = now;
+            paced = 0;
+        }
+
+        if (responded) continue;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_bStop) break;
+        if (!m_requests.empty() && m_requests.front().DueNs < wakeAt) wakeAt = m_requests.front().DueNs;
+        now = MonotonicNanos();
+        wakeAt = std::min<int64_t>(wakeAt, now + 1000000000LL);
+        if (wakeAt > now) {
+            m_cond.wait_until(lock, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(wakeAt)));
+        }
+    }
+}
+
+void MockMdApi::Respond(const Request& request) {
+    // 断线期间的请求与真实前置一样丢失，由上层在重连后重发
+    if (!m_pSpi || !m_bConnected) return;
+
+    CThostFtdcRspInfoField rspInfo;
+    memset(&rspInfo, 0, sizeof(rspInfo));
+    strncpy(rspInfo.ErrorMsg, "CTP:No Error", sizeof(rspInfo.ErrorMsg) - 1);
+
+    switch (request.Type) {
+    case RequestType::Login: {
+        CThostFtdcRspUserLoginField login;
+        memset(&login, 0, sizeof(login));
+        UpdateClock();
+        memcpy(login.TradingDay, m_tradingDay, sizeof(login.TradingDay));
+        memcpy(login.LoginTime, m_updateTime, sizeof(login.LoginTime));
+        strncpy(login.BrokerID, request.BrokerID.c_str(), sizeof(login.BrokerID) - 1);
+        strncpy(login.UserID, request.UserID.c_str(), sizeof(login.UserID) - 1);
+        strncpy(login.SystemName, "MockMdApi", sizeof(login.SystemName) - 1);
+        login.FrontID = 1;
+        login.SessionID = static_cast<int>(NextRandom() & 0x7FFFFFFF);
+        m_bLoggedIn = true;
+        m_pSpi->OnRspUserLogin(&login, &rspInfo, request.RequestID, true);
+        break;
+    }
+    case RequestType::Logout: {
+        CThostFtdcUserLogoutField logout;
+        memset(&logout, 0, sizeof(logout));
+        m_bLoggedIn = false;
+        m_instruments.clear();
+        m_instrumentIndex.clear();
+        m_pSpi->OnRspUserLogout(&logout, &rspInfo, request.RequestID, true);
+        break;
+    }
+    case RequestType::Subscribe:
+    case RequestType::Unsubscribe:
+    case RequestType::SubscribeQuote:
+    case RequestType::UnsubscribeQuote:
+        for (size_t i = 0; i < request.Instruments.size(); ++i) {
+            CThostFtdcSpecificInstrumentField specific;
+            memset(&specific, 0, sizeof(specific));
+            strncpy(specific.InstrumentID, request.Instruments[i].c_str(), sizeof(specific.InstrumentID) - 1);
+            bool last = i + 1 == request.Instruments.size();
+            if (request.Type == RequestType::Subscribe) {
+                AddInstrument(request.Instruments[i]);
+                m_pSpi->OnRspSubMarketData(&specific, &rspInfo, request.RequestID, last);
+            } else if (request.Type == RequestType::Unsubscribe) {
+                RemoveInstrument(request.Instruments[i]);
+                m_pSpi->OnRspUnSubMarketData(&specific, &rspInfo, request.RequestID, last);
+            } else if (request.Type == RequestType::SubscribeQuote) {
+                m_pSpi->OnRspSubForQuoteRsp(&specific, &rspInfo, request.RequestID, last);
+            } else {
+                m_pSpi->OnRspUnSubForQuoteRsp(&specific, &rspInfo, request.RequestID, last);
+            }
+        }
+        break;
+    case RequestType::QueryMulticast:
+        m_pSpi->OnRspQryMulticastInstrument(nullptr, &rspInfo, request.RequestID, true);
+        break;
+    }
+}
+
+// 与真实前置断线一样：登录状态和订阅全部失效，尚未应答的请求丢失
+void MockMdApi::Disconnect() {
+    m_bConnected = false;
+    m_bLoggedIn = false;
+    m_instruments.clear();
+    m_instrumentIndex.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.clear();
+    }
+    if (m_pSpi) m_pSpi->OnFrontDisconnected(DISCONNECT_REASON);
+}
+
+// 行情时间取本地时钟，每秒格式化一次
+void MockMdApi::UpdateClock() {
+    int64_t second = WallClockNanos() / 1000000000LL;
+    if (second == m_nClockSecond) return;
+    m_nClockSecond = second;
+    time_t t = static_cast<time_t>(second);
+    struct tm local;
+    localtime_r(&t, &local);
+    strftime(m_updateTime, sizeof(m_updateTime), "%H:%M:%S", &local);
+}
+
+void MockMdApi::AddInstrument(const std::string& id) {
+    if (m_instrumentIndex.count(id)) return;
+    // 初始价格由合约代码决定，同一合约每次运行相同
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < id.size(); ++i) hash = (hash ^ static_cast<unsigned char>(id[i])) * 16777619u;
+    Instrument instrument;
+    instrument.ID = id;
+    instrument.BaseTicks = 1000 * TICKS_PER_UNIT + static_cast<int>(hash % 20000);
+    instrument.PriceTicks = instrument.BaseTicks;
+    instrument.HighTicks = instrument.PriceTicks;
+    instrument.LowTicks = instrument.PriceTicks;
+    instrument.Volume = 0;
+    instrument.Turnover = 0;
+    instrument.PreOpenInterest = 10000 + hash % 90000;
+    instrument.OpenInterest = instrument.PreOpenInterest;
+    for (int level = 0; level < 5; ++level) {
+        instrument.BidVolumes[level] = 1 + static_cast<int>((hash >> (level * 3)) % 100);
+        instrument.AskVolumes[level] = 1 + static_cast<int>((hash >> (level * 3 + 15)) % 100);
+    }
+    m_instrumentIndex[id] = m_instruments.size();
+    m_instruments.push_back(instrument);
+}
+
+// 与末尾交换后删除，保持数组紧凑
+void MockMdApi::RemoveInstrument(const std::string& id) {
+    auto it = m_instrumentIndex.find(id);
+    if (it == m_instrumentIndex.end()) return;
+    size_t index = it->second;
+    m_instrumentIndex.erase(it);
+    if (index + 1 != m_instruments.size()) {
+        m_instruments[index] = std::move(m_instruments.back());
+        m_instrumentIndex[m_instruments[index].ID] = index;
+    }
+    m_instruments.pop_back();
+}
+
+void MockMdApi::EmitTick() {
+    if (m_nCursor >= m_instruments.size()) m_nCursor = 0;
+    Instrument& inst = m_instruments[m_nCursor++];
+
+    uint64_t r = NextRandom();
+    // 三分之一的行情价格变动一个价位
+    int step = static_cast<int>(r % 6) < 2 ? static_cast<int>(r % 6) * 2 - 1 : 0;
+    inst.PriceTicks = std::max(TICKS_PER_UNIT, inst.PriceTicks + step);
+    inst.HighTicks = std::max(inst.HighTicks, inst.PriceTicks);
+    inst.LowTicks = std::min(inst.LowTicks, inst.PriceTicks);
+    double price = inst.PriceTicks / static_cast<double>(TICKS_PER_UNIT);
+    double basePrice = inst.BaseTicks / static_cast<double>(TICKS_PER_UNIT);
+    int traded = 1 + static_cast<int>((r >> 8) % 20);
+    inst.Volume += traded;
+    inst.Turnover += traded * price * VOLUME_MULTIPLE;
+    inst.OpenInterest += static_cast<int>((r >> 16) % 5) - 2;
+
+    CThostFtdcDepthMarketDataField field;
+    memset(&field, 0, sizeof(field));
+    UpdateClock();
+    memcpy(field.TradingDay, m_tradingDay, sizeof(field.TradingDay));
+    memcpy(field.ActionDay, m_tradingDay, sizeof(field.ActionDay));
+    strncpy(field.InstrumentID, inst.ID.c_str(), sizeof(field.InstrumentID) - 1);
+    memcpy(field.UpdateTime, m_updateTime, sizeof(field.UpdateTime));
+    field.UpdateMillisec = static_cast<int>(WallClockNanos() / 1000000 % 1000);
+    field.LastPrice = price;
+    field.PreSettlementPrice = basePrice;
+    field.PreClosePrice = basePrice;
+    field.PreOpenInterest = inst.PreOpenInterest;
+    field.OpenPrice = basePrice;
+    field.HighestPrice = inst.HighTicks / static_cast<double>(TICKS_PER_UNIT);
+    field.LowestPrice = inst.LowTicks / static_cast<double>(TICKS_PER_UNIT);
+    field.Volume = inst.Volume;
+    field.Turnover = inst.Turnover;
+    field.OpenInterest = inst.OpenInterest;
+    // 盘中的收盘价、结算价和 Delta 与真实行情一样为无效值
+    field.ClosePrice = DBL_MAX;
+    field.SettlementPrice = DBL_MAX;
+    field.PreDelta = DBL_MAX;
+    field.CurrDelta = DBL_MAX;
+    field.UpperLimitPrice = (inst.BaseTicks + inst.BaseTicks / 10) / static_cast<double>(TICKS_PER_UNIT);
+    field.LowerLimitPrice = (inst.BaseTicks - inst.BaseTicks / 10) / static_cast<double>(TICKS_PER_UNIT);
+    field.BandingUpperPrice = DBL_MAX;
+    field.BandingLowerPrice = DBL_MAX;
+    field.AveragePrice = inst.Turnover / inst.Volume;  // 与 CTP 一样含合约乘数
+
+    double* bidPrices[] = {&field.BidPrice1, &field.BidPrice2, &field.BidPrice3, &field.BidPrice4, &field.BidPrice5};
+    double* askPrices[] = {&field.AskPrice1, &field.AskPrice2, &field.AskPrice3, &field.AskPrice4, &field.AskPrice5};
+    int* bidVolumes[] = {&field.BidVolume1, &field.BidVolume2, &field.BidVolume3, &field.BidVolume4, &field.BidVolume5};
+    int* askVolumes[] = {&field.AskVolume1, &field.AskVolume2, &field.AskVolume3, &field.AskVolume4, &field.AskVolume5};
+    // 价格上涨时卖一被吃掉、买方新增一档，下跌时相反；随后各改动一档的挂单量
+    int fresh = 1 + static_cast<int>((r >> 24) % 100);
+    if (step > 0) {
+        std::copy(inst.AskVolumes + 1, inst.AskVolumes + 5, inst.AskVolumes);
+        inst.AskVolumes[4] = fresh;
+        std::copy_backward(inst.BidVolumes, inst.BidVolumes + 4, inst.BidVolumes + 5);
+        inst.BidVolumes[0] = fresh;
+    } else if (step < 0) {
+        std::copy(inst.BidVolumes + 1, inst.BidVolumes + 5, inst.BidVolumes);
+        inst.BidVolumes[4] = fresh;
+        std::copy_backward(inst.AskVolumes, inst.AskVolumes + 4, inst.AskVolumes + 5);
+        inst.AskVolumes[0] = fresh;
+    }
+    inst.BidVolumes[(r >> 32) % 5] = 1 + static_cast<int>((r >> 36) % 100);
+    inst.AskVolumes[(r >> 44) % 5] = 1 + static_cast<int>((r >> 48) % 100);
+    for (int level = 0; level < 5; ++level) {
+        *bidPrices[level] = (inst.PriceTicks - level - 1) / static_cast<double>(TICKS_PER_UNIT);
+        *askPrices[level] = (inst.PriceTicks + level + 1) / static_cast<double>(TICKS_PER_UNIT);
+        *bidVolumes[level] = inst.BidVolumes[level];
+        *askVolumes[level] = inst.AskVolumes[level];
+    }
+
+    m_nTicks.store(m_nTicks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_pSpi->OnRtnDepthMarketData(&field);
+}
+
+// xorshift64*
+uint64_t MockMdApi::NextRandom() {
+    m_nRandom ^= m_nRandom >> 12;
+    m_nRandom ^= m_nRandom << 25;
+    m_nRandom ^= m_nRandom >> 27;
+    return m_nRandom * 0x2545F4914F6CDD1DULL;
+}
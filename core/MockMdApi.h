@@ -0,0 +1,141 @@
+#ifndef MOCK_MD_API_H
+#define MOCK_MD_API_H
+
+#include <ThostFtdcMdApi.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 进程内模拟的行情前置，实现 CThostFtdcMdApi 接口，用于离线测试和基准测试。
+// 选择方式：
+//   启动时：--mock 时 main 直接创建 MockMdApi，不调用 CreateFtdcMdApi；
+//   链接时：make mock 以 MockMdApiFactory.cpp 代替 libthostmduserapi_se，CreateFtdcMdApi 返回 MockMdApi。
+//
+// 与真实 API 一样，所有回调都在 Init() 启动的单个回调线程中发生：
+// Init() 后回调 OnFrontConnected，登录、订阅、退订请求在任意线程调用时只入队，由回调线程依次应答；
+// 已订阅的合约轮流生成合成行情（价格随机游走，成交量、成交额单调增长），总速率为 TickRate 条/秒；
+// 五档挂单在两次行情之间保持，每条行情只改动少数几档，价格变动时整档移位，与真实盘口的变化方式相近。
+// 运行时长到达后停止生成行情，Join() 返回，回调线程继续应答请求（退订、登出）直到 Release()。
+// DisconnectIntervalSec 不为 0 时定期模拟断线：回调 OnFrontDisconnected，清空登录状态和订阅，
+// 稍后重新回调 OnFrontConnected，由上层重新登录和订阅。
+class MockMdApi final : public CThostFtdcMdApi
+{
+public:
+    struct Options
+    {
+        int TickRate;               // 每秒生成的行情数（所有合约合计），0 表示不限速
+        int ResponseDelayMs;        // 请求到应答的延迟（毫秒）
+        int DisconnectIntervalSec;  // 模拟断线的间隔（秒），0 表示不断线
+        int DurationSec;            // 运行时长（秒），到时停止生成行情、Join() 返回；0 表示直到 Release()
+    };
+
+    // 由配置项 MOCK_* 构造的选项
+    static Options OptionsFromConfig();
+
+    MockMdApi(const char* flowPath, const Options& options);
+
+    virtual void Release() override;
+    virtual void Init() override;
+    virtual int Join() override;
+    virtual const char* GetTradingDay() override;
+    virtual void RegisterFront(char* pszFrontAddress) override;
+    virtual void RegisterNameServer(char* pszNsAddress) override;
+    virtual void RegisterFensUserInfo(CThostFtdcFensUserInfoField* pFensUserInfo) override;
+    virtual void RegisterSpi(CThostFtdcMdSpi* pSpi) override;
+    virtual int SubscribeMarketData(char* ppInstrumentID[], int nCount) override;
+    virtual int UnSubscribeMarketData(char* ppInstrumentID[], int nCount) override;
+    virtual int SubscribeForQuoteRsp(char* ppInstrumentID[], int nCount) override;
+    virtual int UnSubscribeForQuoteRsp(char* ppInstrumentID[], int nCount) override;
+    virtual int ReqUserLogin(CThostFtdcReqUserLoginField* pReqUserLoginField, int nRequestID) override;
+    virtual int ReqUserLogout(CThostFtdcUserLogoutField* pUserLogout, int nRequestID) override;
+    virtual int ReqQryMulticastInstrument(CThostFtdcQryMulticastInstrumentField* pQryMulticastInstrument,
+                                          int nRequestID) override;
+
+    uint64_t TicksGenerated() const { return m_nTicks.load(std::memory_order_relaxed); }
+
+private:
+    // 与真实 API 一样只能通过 Release() 销毁
+    ~MockMdApi();
+
+    enum class RequestType
+    {
+        Login,
+        Logout,
+        Subscribe,
+        Unsubscribe,
+        SubscribeQuote,
+        UnsubscribeQuote,
+        QueryMulticast
+    };
+
+    struct Request
+    {
+        RequestType Type;
+        int RequestID;
+        int64_t DueNs;                      // 应答时间
+        std::vector<std::string> Instruments;
+        std::string BrokerID;               // 登录请求
+        std::string UserID;
+    };
+
+    // 已订阅合约的合成行情状态
+    struct Instrument
+    {
+        std::string ID;
+        int BaseTicks;              // 价格均以最小变动价位计
+        int PriceTicks;
+        int HighTicks;
+        int LowTicks;
+        int Volume;
+        double Turnover;
+        double PreOpenInterest;
+        double OpenInterest;
+        int BidVolumes[5];          // 五档挂单量，价格随 PriceTicks 逐档排列
+        int AskVolumes[5];
+    };
+
+    int Enqueue(RequestType type, int requestID, char* ppInstrumentID[], int nCount);
+    int Submit(Request& request);
+    void Run();
+    void Respond(const Request& request);
+    void Disconnect();
+    void UpdateClock();
+    void AddInstrument(const std::string& id);
+    void RemoveInstrument(const std::string& id);
+    void EmitTick();
+    uint64_t NextRandom();
+
+    std::string m_flowPath;
+    std::string m_front;
+    Options m_options;
+    CThostFtdcMdSpi* m_pSpi;
+    char m_tradingDay[9];
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Request> m_requests;     // 受 m_mutex 保护
+    bool m_bStarted;                    // 受 m_mutex 保护，Init() 时置位
+    bool m_bStop;                       // 受 m_mutex 保护，Release() 时置位
+    bool m_bFinished;                   // 受 m_mutex 保护，运行时长已到或已停止，Join() 返回
+    std::thread m_thread;
+
+    // 以下只在回调线程中访问
+    bool m_bConnected;
+    bool m_bLoggedIn;
+    std::vector<Instrument> m_instruments;
+    std::unordered_map<std::string, size_t> m_instrumentIndex;
+    size_t m_nCursor;                   // 下一条行情的合约
+    uint64_t m_nRandom;
+    int64_t m_nClockSecond;             // m_updateTime 对应的纪元秒
+    char m_updateTime[9];
+    std::atomic<uint64_t> m_nTicks;
+};
+
+#endif // MOCK_MD_API_H
@@ -0,0 +1,10 @@
+// 链接时替换 libthostmduserapi_se：CreateFtdcMdApi 返回模拟前置（make mock）
+#include "MockMdApi.h"
+
+CThostFtdcMdApi* CThostFtdcMdApi::CreateFtdcMdApi(const char* pszFlowPath, const bool, const bool, bool) {
+    return new MockMdApi(pszFlowPath, MockMdApi::OptionsFromConfig());
+}
+
+const char* CThostFtdcMdApi::GetApiVersion() {
+    return "MockMdApi";
+}
@@ -5,41 +5,36 @@
 #include <vector>
 #include <cstring>
 #include <iconv.h>
-#include <json.hpp>
 
-// 为了方便，使用 nlohmann::json 的别名
-using json = nlohmann::json;
-
-// 定义一个命名空间来包含我们的数据结构，这有助于避免全局命名冲突
-namespace MarketData
-{
-    struct DepthMarketData
-    {
-        std::string InstrumentID;
-        double LastPrice;
-        int Volume;
-        double BidPrice1;
-        int BidVolume1;
-        double AskPrice1;
-        int AskVolume1;
-        std::string UpdateTime;
-        int UpdateMillisec;
-    };
-
-    // 使用 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE 宏来自动生成 to_json 和 from_json 函数
-    // 这个宏必须放在结构体所在的命名空间内（或者全局命名空间）
-    // 第一个参数是结构体名称，后续参数是结构体的成员名称
-    NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(DepthMarketData, InstrumentID, LastPrice, Volume,
-                                       BidPrice1, BidVolume1, AskPrice1, AskVolume1,
-                                       UpdateTime, UpdateMillisec)
-} // namespace MarketData
-
-MyMdSpi::MyMdSpi() : m_pMdApi(nullptr), m_nRequestID(0), m_bIsLogin(false), m_bIsConnected(false) {}
+MyMdSpi::MyMdSpi() : m_pMdApi(nullptr), m_nRequestID(0), m_bIsLogin(false), m_bIsConnected(false),
+      m_nDisconnects(0), m_nHeartBeatWarnings(0), m_nSubscribeFailures(0), m_pPipeline(nullptr),
+      m_pSubscriptions(nullptr), m_nSession(0) {}
 
 void MyMdSpi::SetMdApi(CThostFtdcMdApi* pMdApi) {
     m_pMdApi = pMdApi;
 }
 
+void MyMdSpi::SetPipeline(TickPipeline* pPipeline) {
+    m_pPipeline = pPipeline;
+}
+
+void MyMdSpi::SetSession(uint32_t session) {
+    m_nSession = session;
+    m_sessionTag = " (session " + std::to_string(session) + ")";
+}
+
+void MyMdSpi::SetSubscriptions(SubscriptionManager* pSubscriptions) {
+    m_pSubscriptions = pSubscriptions;
+}
+
+MyMdSpi::Stats MyMdSpi::GetStats() const {
+    Stats stats;
+    stats.Disconnects = m_nDisconnects.load(std::memory_order_relaxed);
+    stats.HeartBeatWarnings = m_nHeartBeatWarnings.load(std::memory_order_relaxed);
+    stats.SubscribeFailures = m_nSubscribeFailures.load(std::memory_order_relaxed);
+    return stats;
+}
+
 // 辅助函数：将 GBK 编码转换为 UTF-8
 std::string MyMdSpi::ConvertGBKToUTF8(const char* gbkStr) {
     if (!gbkStr || strlen(gbkStr) == 0) return "";
@@ -73,7 +68,7 @@ std::string MyMdSpi::ConvertGBKToUTF8(const char* gbkStr) {
 
 ///当客户端与交易后台建立起通信连接时（还未登录前），该方法被调用。
 void MyMdSpi::OnFrontConnected() {
-    std::cerr << "=== OnFrontConnected ===" << std::endl;
+    std::cerr << "=== OnFrontConnected" << m_sessionTag << " ===" << std::endl;
     m_bIsConnected = true;
     // 连接成功后，发送登录请求
     ReqUserLogin();
@@ -81,20 +76,24 @@ void MyMdSpi::OnFrontConnected() {
 
 ///当客户端与交易后台通信连接断开时，该方法被调用。
 void MyMdSpi::OnFrontDisconnected(int nReason) {
-    std::cerr << "=== OnFrontDisconnected, Reason: " << std::hex << nReason << std::dec << " ===" << std::endl;
+    std::cerr << "=== OnFrontDisconnected" << m_sessionTag << ", Reason: " << std::hex << nReason << std::dec << " ===" << std::endl;
     m_bIsConnected = false;
     m_bIsLogin = false;
-    // 在实际应用中，这里可能需要实现自动重连逻辑
+    m_nDisconnects.store(m_nDisconnects.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (m_pPipeline) m_pPipeline->MarkDisconnected(m_nSession);
+    // CTP 会自动重连，重新登录后再次分批订阅
+    if (m_pSubscriptions) m_pSubscriptions->Reset();
 }
 
 ///心跳超时警告
 void MyMdSpi::OnHeartBeatWarning(int nTimeLapse) {
+    m_nHeartBeatWarnings.store(m_nHeartBeatWarnings.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
     std::cerr << "=== OnHeartBeatWarning, TimeLapse: " << nTimeLapse << " ===" << std::endl;
 }
 
 ///登录请求响应
 void MyMdSpi::OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
-    std::cerr << "=== OnRspUserLogin ===" << std::endl;
+    std::cerr << "=== OnRspUserLogin" << m_sessionTag << " ===" << std::endl;
     if (pRspInfo && pRspInfo->ErrorID == 0) {
         std::cerr << "Login successful!" << std::endl;
         std::cerr << "BrokerID: " << pRspUserLogin->BrokerID << std::endl;
@@ -144,11 +143,14 @@ void MyMdSpi::OnRspError(CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool
 
 ///订阅行情应答
 void MyMdSpi::OnRspSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
-    std::lock_guard<std::mutex> lock(m_coutMutex);
-    std::cerr << "=== OnRspSubMarketData ===" << std::endl;
-    if (pRspInfo && pRspInfo->ErrorID == 0) {
-        std::cerr << "Subscribe market data successful for instrument: " << (pSpecificInstrument ? pSpecificInstrument->InstrumentID : "N/A") << std::endl;
-    } else {
+    // 每个合约一条应答，合约数上千时只输出失败的应答，订阅完成后由 SubscriptionManager 输出汇总
+    int errorID = pRspInfo ? pRspInfo->ErrorID : 0;
+    if (pSpecificInstrument && m_pSubscriptions) {
+        m_pSubscriptions->OnSubscribeResponse(pSpecificInstrument->InstrumentID, errorID);
+    }
+    if (errorID != 0) {
+        m_nSubscribeFailures.store(m_nSubscribeFailures.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(m_coutMutex);
         std::string utf8Msg = ConvertGBKToUTF8(pRspInfo ? pRspInfo->ErrorMsg : "Unknown error");
         std::cerr << "Subscribe market data failed! Instrument: " << (pSpecificInstrument ? pSpecificInstrument->InstrumentID : "N/A")
                   << ", ErrorID: " << (pRspInfo ? pRspInfo->ErrorID : -1)
@@ -179,32 +181,8 @@ void MyMdSpi::OnRspUnSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificI
 void MyMdSpi::OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *pDepthMarketData) {
     if (!pDepthMarketData) return;
 
-    // 创建 DepthMarketData 实例并填充数据
-    MarketData::DepthMarketData marketDataInstance;
-    marketDataInstance.InstrumentID = pDepthMarketData->InstrumentID;
-    marketDataInstance.LastPrice = pDepthMarketData->LastPrice;
-    marketDataInstance.Volume = pDepthMarketData->Volume;
-    marketDataInstance.BidPrice1 = pDepthMarketData->BidPrice1;
-    marketDataInstance.BidVolume1 = pDepthMarketData->BidVolume1;
-    marketDataInstance.AskPrice1 = pDepthMarketData->AskPrice1;
-    marketDataInstance.AskVolume1 = pDepthMarketData->AskVolume1;
-    marketDataInstance.UpdateTime = pDepthMarketData->UpdateTime;
-    marketDataInstance.UpdateMillisec = pDepthMarketData->UpdateMillisec;
-
-    // 将结构体转换为 JSON
-    json j_marketData = marketDataInstance;
-    std::string json_string = j_marketData.dump(-1);
-
-    // 构造完整的 SSE 格式字符串
-    std::string output = "data: " + json_string + "\n\n";
-
-    // 一次性输出
-    {
-        std::lock_guard<std::mutex> lock(m_coutMutex);
-        std::cout << output;
-        // 确保输出立即刷新
-        std::cout.flush();
-    }
+    // 回调线程只做拷贝和入队，编码与输出由流水线的工作线程完成
+    if (m_pPipeline) m_pPipeline->Capture(pDepthMarketData, m_nSession);
 }
 
 // --- 辅助方法 ---
@@ -215,9 +193,9 @@ void MyMdSpi::ReqUserLogin() {
     CThostFtdcReqUserLoginField req;
     memset(&req, 0, sizeof(req)); // 清空结构体
     // 填充登录请求字段
-    strncpy(req.BrokerID, BROKER_ID, sizeof(req.BrokerID) - 1);
-    strncpy(req.UserID, USER_ID, sizeof(req.UserID) - 1);
-    strncpy(req.Password, PASSWORD, sizeof(req.Password) - 1);
+    strncpy(req.BrokerID, BROKER_ID.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.UserID, USER_ID.c_str(), sizeof(req.UserID) - 1);
+    strncpy(req.Password, PASSWORD.c_str(), sizeof(req.Password) - 1);
 
     // 发送登录请求
     int ret = m_pMdApi->ReqUserLogin(&req, ++m_nRequestID);
@@ -232,8 +210,8 @@ void MyMdSpi::ReqUserLogout() {
 
     CThostFtdcUserLogoutField req;
     memset(&req, 0, sizeof(req));
-    strncpy(req.BrokerID, BROKER_ID, sizeof(req.BrokerID) - 1);
-    strncpy(req.UserID, USER_ID, sizeof(req.UserID) - 1);
+    strncpy(req.BrokerID, BROKER_ID.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.UserID, USER_ID.c_str(), sizeof(req.UserID) - 1);
 
     int ret = m_pMdApi->ReqUserLogout(&req, ++m_nRequestID);
     {
@@ -243,45 +221,14 @@ void MyMdSpi::ReqUserLogout() {
 }
 
 void MyMdSpi::SubscribeMarketData() {
-    if (!m_pMdApi || !m_bIsLogin) return;
-
-    // 将 const char* 数组转换为 char* 数组，因为API接口需要 char*[]
-    char** ppInstrumentID = new char*[INSTRUMENT_COUNT];
-    for (int i = 0; i < INSTRUMENT_COUNT; ++i) {
-        ppInstrumentID[i] = new char[strlen(INSTRUMENT_IDS[i]) + 1];
-        strcpy(ppInstrumentID[i], INSTRUMENT_IDS[i]);
-    }
+    if (!m_pMdApi || !m_bIsLogin || !m_pSubscriptions) return;
 
-    int ret = m_pMdApi->SubscribeMarketData(ppInstrumentID, INSTRUMENT_COUNT);
-    {
-        std::lock_guard<std::mutex> lock(m_coutMutex);
-        std::cerr << "Sending subscribe market data request... " << (ret == 0 ? "success" : "failed") << std::endl;
-    }
-
-    // 释放内存
-    for (int i = 0; i < INSTRUMENT_COUNT; ++i) {
-        delete[] ppInstrumentID[i];
-    }
-    delete[] ppInstrumentID;
+    // 由 SubscriptionManager 的线程分批发送，不阻塞回调线程
+    m_pSubscriptions->Subscribe(m_pMdApi);
 }
 
 void MyMdSpi::UnSubscribeMarketData() {
-    if (!m_pMdApi || !m_bIsLogin) return;
+    if (!m_pMdApi || !m_bIsLogin || !m_pSubscriptions) return;
 
-    char** ppInstrumentID = new char*[INSTRUMENT_COUNT];
-    for (int i = 0; i < INSTRUMENT_COUNT; ++i) {
-        ppInstrumentID[i] = new char[strlen(INSTRUMENT_IDS[i]) + 1];
-        strcpy(ppInstrumentID[i], INSTRUMENT_IDS[i]);
-    }
-
-    int ret = m_pMdApi->UnSubscribeMarketData(ppInstrumentID, INSTRUMENT_COUNT);
-    {
-        std::lock_guard<std::mutex> lock(m_coutMutex);
-        std::cerr << "Sending unsubscribe market data request... " << (ret == 0 ? "success" : "failed") << std::endl;
-    }
-
-    for (int i = 0; i < INSTRUMENT_COUNT; ++i) {
-        delete[] ppInstrumentID[i];
-    }
-    delete[] ppInstrumentID;
-}
\ No newline at end of file
+    m_pSubscriptions->Unsubscribe(m_pMdApi);
+}
@@ -3,7 +3,10 @@
 
 #include <ThostFtdcMdApi.h>
 #include <ThostFtdcUserApiStruct.h>
+#include "TickPipeline.h"
+#include "SubscriptionManager.h"
 
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -15,16 +18,41 @@ class MyMdSpi : public CThostFtdcMdSpi
 {
 public:
     CThostFtdcMdApi* m_pMdApi;
-    int m_nRequestID;          // 请求ID，用于匹配请求和响应
-    bool m_bIsLogin;           // 登录状态
-    bool m_bIsConnected;       // 连接状态
+    // 回调线程写入，主线程在退出时读取
+    std::atomic<int> m_nRequestID;      // 请求ID，用于匹配请求和响应
+    std::atomic<bool> m_bIsLogin;       // 登录状态
+    std::atomic<bool> m_bIsConnected;   // 连接状态
+
+    // 会话事件计数，只由本会话的回调线程写入，可在任意线程读取
+    struct Stats
+    {
+        uint64_t Disconnects;           // OnFrontDisconnected 次数
+        uint64_t HeartBeatWarnings;     // OnHeartBeatWarning 次数
+        uint64_t SubscribeFailures;     // OnRspSubMarketData 中 ErrorID 不为 0 的应答数
+    };
 
 private:
+    // 各会话的计数器独占缓存行，与其他会话的回调线程互不干扰
+    alignas(64) std::atomic<uint64_t> m_nDisconnects;
+    std::atomic<uint64_t> m_nHeartBeatWarnings;
+    std::atomic<uint64_t> m_nSubscribeFailures;
+
     std::mutex m_coutMutex;    // 用于保护 std::cout 的互斥锁
+    TickPipeline* m_pPipeline; // 行情处理流水线，回调线程只负责入队
+    SubscriptionManager* m_pSubscriptions; // 分批订阅
+    uint32_t m_nSession;       // 会话编号，也是写入流水线的队列编号
+    std::string m_sessionTag;  // 多会话时日志中的会话标识
 
 public:
     MyMdSpi();
     void SetMdApi(CThostFtdcMdApi* pMdApi);
+    void SetPipeline(TickPipeline* pPipeline);
+    // 多会话时设置会话编号（须小于流水线的队列数）
+    void SetSession(uint32_t session);
+    void SetSubscriptions(SubscriptionManager* pSubscriptions);
+
+    uint32_t Session() const { return m_nSession; }
+    Stats GetStats() const;
 
     // 辅助函数：将 GBK 编码转换为 UTF-8
     std::string ConvertGBKToUTF8(const char* gbkStr);
@@ -0,0 +1,200 @@
+#ifndef NUMBER_FORMAT_H
+#define NUMBER_FORMAT_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// 数值格式化工具，供所有输出编码器使用
+// 所有函数都直接写入调用方提供的缓冲区并返回写入结束位置，不分配内存、不追加 '\0'。
+
+namespace NumberFormat
+{
+    // FormatDouble 最多写入的字节数
+    const size_t MAX_DOUBLE_CHARS = 32;
+    // FormatInt 最多写入的字节数
+    const size_t MAX_INT_CHARS = 20;
+
+    // "00" ~ "99" 的查找表，每次处理两位数字
+    static const char DIGIT_PAIRS[201] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    inline char* FormatUInt(char* out, uint64_t value) {
+        char tmp[MAX_INT_CHARS];
+        char* p = tmp + sizeof(tmp);
+        while (value >= 100) {
+            const char* pair = DIGIT_PAIRS + (value % 100) * 2;
+            value /= 100;
+            *--p = pair[1];
+            *--p = pair[0];
+        }
+        if (value >= 10) {
+            const char* pair = DIGIT_PAIRS + value * 2;
+            *--p = pair[1];
+            *--p = pair[0];
+        } else {
+            *--p = static_cast<char>('0' + value);
+        }
+        size_t len = tmp + sizeof(tmp) - p;
+        memcpy(out, p, len);
+        return out + len;
+    }
+
+    inline char* FormatInt(char* out, int64_t value) {
+        // 使用无符号数处理 INT64_MIN
+        if (value < 0) {
+            *out++ = '-';
+            return FormatUInt(out, 0 - static_cast<uint64_t>(value));
+        }
+        return FormatUInt(out, static_cast<uint64_t>(value));
+    }
+
+    // CTP 用 DBL_MAX 表示无效价格（如空档位、未收盘的收盘价）
+    inline bool IsInvalidPrice(double value) {
+        return !(std::fabs(value) < 1e300);
+    }
+
+    // 快速路径：价格通常只有少量小数位。依次尝试 0 ~ 8 位小数，
+    // 若 r / 10^d 恰好还原出 value（整数除法结果经正确舍入），则该十进制串可往返，
+    // 且小数位数最少即为最短表示。有效数字限制在 15 位以内（DBL_DIG），
+    // 保证同样长度的可往返表示是唯一的。失败时返回 nullptr，由通用路径处理。
+    inline char* FormatFixedFast(char* out, double value) {
+        static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8};
+        static const uint64_t IPOW10[] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL,
+                                          100000ULL, 1000000ULL, 10000000ULL, 100000000ULL};
+        if (!(value >= 1e-3 && value < 1e15)) return nullptr;
+        for (int d = 0; d <= 8; ++d) {
+            double scaled = value * POW10[d];
+            if (scaled >= 1e15) return nullptr;
+            uint64_t r = static_cast<uint64_t>(scaled + 0.5);
+            if (static_cast<double>(r) / POW10[d] != value) continue;
+
+            out = FormatUInt(out, r / IPOW10[d]);
+            *out++ = '.';
+            if (d == 0) {
+                *out++ = '0';
+                return out;
+            }
+            // 小数部分补足前导零
+            uint64_t frac = r % IPOW10[d];
+            char* end = out + d;
+            for (char* p = end; p != out; ) {
+                *--p = static_cast<char>('0' + frac % 10);
+                frac /= 10;
+            }
+            return end;
+        }
+        return nullptr;
+    }
+
+    // 输出最短可往返的十进制表示（由 std::to_chars 生成），
+    // 排版规则与 nlohmann::json 一致：指数在 [-4, 15) 内使用定点表示，
+    // 整数值补 ".0"，其余使用 "d.ddde+XX" 形式。调用方需保证 value 为有限值。
+    // 数字本身与 nlohmann::json 不总是相同：它使用的 Grisu2 对部分数值给出的不是最短表示，
+    // 如运算得到的 7286.4000000000005（此处为 7286.400000000001）和 0.005192（nlohmann 为 0.0051919999999999996），
+    // 两者解析后是同一个 double，但逐字节比较会不同。小数位不超过 3 位、有效数字不超过 7 位的价格两者一致。
+    inline char* FormatDouble(char* out, double value) {
+        if (std::signbit(value)) {
+            *out++ = '-';
+            value = -value;
+        }
+        if (value == 0) {
+            memcpy(out, "0.0", 3);
+            return out + 3;
+        }
+
+        char* fast = FormatFixedFast(out, value);
+        if (fast) return fast;
+
+        // 科学计数法形式："d[.ddd]e[+-]XX"
+        char sci[MAX_DOUBLE_CHARS];
+        char* sciEnd = std::to_chars(sci, sci + sizeof(sci), value, std::chars_format::scientific).ptr;
+
+        // 提取有效数字与十进制指数
+        char digits[MAX_DOUBLE_CHARS];
+        int k = 0;
+        const char* p = sci;
+        while (*p != 'e') {
+            if (*p != '.') digits[k++] = *p;
+            ++p;
+        }
+        ++p;
+        bool negExp = (*p == '-');
+        ++p;
+        int exp = 0;
+        while (p < sciEnd) exp = exp * 10 + (*p++ - '0');
+        if (negExp) exp = -exp;
+
+        // 小数点相对于数字串起始位置的偏移
+        const int n = exp + 1;
+        const int MIN_EXP = -4;
+        const int MAX_EXP = 15;
+
+        if (k <= n && n <= MAX_EXP) {
+            // digits[000].0
+            memcpy(out, digits, k);
+            memset(out + k, '0', n - k);
+            out += n;
+            *out++ = '.';
+            *out++ = '0';
+            return out;
+        }
+        if (0 < n && n <= MAX_EXP) {
+            // dig.its
+            memcpy(out, digits, n);
+            out[n] = '.';
+            memcpy(out + n + 1, digits + n, k - n);
+            return out + k + 1;
+        }
+        if (MIN_EXP < n && n <= 0) {
+            // 0.[000]digits
+            *out++ = '0';
+            *out++ = '.';
+            memset(out, '0', -n);
+            out += -n;
+            memcpy(out, digits, k);
+            return out + k;
+        }
+
+        // d[.igits]e+XX，指数至少两位
+        *out++ = digits[0];
+        if (k > 1) {
+            *out++ = '.';
+            memcpy(out, digits + 1, k - 1);
+            out += k - 1;
+        }
+        *out++ = 'e';
+        int e = n - 1;
+        if (e < 0) {
+            *out++ = '-';
+            e = -e;
+        } else {
+            *out++ = '+';
+        }
+        if (e < 10) {
+            *out++ = '0';
+            *out++ = static_cast<char>('0' + e);
+        } else if (e < 100) {
+            *out++ = DIGIT_PAIRS[e * 2];
+            *out++ = DIGIT_PAIRS[e * 2 + 1];
+        } else {
+            *out++ = static_cast<char>('0' + e / 100);
+            e %= 100;
+            *out++ = DIGIT_PAIRS[e * 2];
+            *out++ = DIGIT_PAIRS[e * 2 + 1];
+        }
+        return out;
+    }
+} // namespace NumberFormat
+
+#endif // NUMBER_FORMAT_H
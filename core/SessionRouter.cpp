@@ -0,0 +1,31 @@
+#include "SessionRouter.h"
+#include <iostream>
+
+SessionRouter::SessionRouter(uint32_t sessionCount, const std::vector<std::vector<std::string>>& groups)
+    : m_nSessionCount(sessionCount > 0 ? sessionCount : 1) {
+    for (size_t g = 0; g < groups.size(); ++g) {
+        uint32_t session = static_cast<uint32_t>(g % m_nSessionCount);
+        for (size_t i = 0; i < groups[g].size(); ++i) {
+            auto result = m_explicit.emplace(groups[g][i], session);
+            if (!result.second && result.first->second != session) {
+                std::cerr << "Session groups: " << groups[g][i] << " listed in more than one group, keeping session "
+                          << result.first->second << std::endl;
+            }
+        }
+    }
+}
+
+uint32_t SessionRouter::Route(const char* instrumentID) const {
+    if (m_nSessionCount == 1) return 0;
+    if (!m_explicit.empty()) {
+        auto it = m_explicit.find(instrumentID);
+        if (it != m_explicit.end()) return it->second;
+    }
+    // FNV-1a，结果与平台和运行次数无关
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (const char* p = instrumentID; *p; ++p) {
+        h ^= static_cast<unsigned char>(*p);
+        h *= 0x100000001B3ULL;
+    }
+    return static_cast<uint32_t>(h % m_nSessionCount);
+}
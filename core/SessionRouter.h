@@ -0,0 +1,28 @@
+#ifndef SESSION_ROUTER_H
+#define SESSION_ROUTER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 多会话（MD_SESSIONS > 1）时决定每个合约由哪个 CThostFtdcMdApi 会话订阅。
+// 显式分组中的合约固定分配到第 g 组对应的会话（g 超出会话数时取模），其余合约按代码的哈希值分配。
+// 分配结果只取决于合约代码，运行中新增的合约与启动时的合约使用同一规则；
+// 每个合约只属于一个会话，其行情只经过一个回调线程，合并后仍保持各合约内部的先后顺序。
+class SessionRouter
+{
+public:
+    SessionRouter(uint32_t sessionCount, const std::vector<std::vector<std::string>>& groups);
+
+    uint32_t SessionCount() const { return m_nSessionCount; }
+
+    // 合约所属的会话编号，范围 [0, SessionCount())
+    uint32_t Route(const char* instrumentID) const;
+
+private:
+    uint32_t m_nSessionCount;
+    std::unordered_map<std::string, uint32_t> m_explicit;   // 显式分组的合约 -> 会话编号
+};
+
+#endif // SESSION_ROUTER_H
@@ -0,0 +1,149 @@
+#include "ShmPublisher.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+ShmPublisher::ShmPublisher()
+    : m_pRegistry(nullptr), m_pBase(nullptr), m_nSize(0), m_pHeader(nullptr), m_pInstruments(nullptr), m_pSlots(nullptr),
+      m_pLatest(nullptr), m_nMask(0), m_nSeq(0), m_nPublished(0) {
+    m_encoder.SetDepth(5);
+}
+
+ShmPublisher::~ShmPublisher() {
+    Close();
+}
+
+bool ShmPublisher::Open(const char* name, size_t slotCount, uint32_t instrumentCapacity, const InstrumentRegistry& registry) {
+    Close();
+
+    size_t slots = 1;
+    while (slots < slotCount) slots <<= 1;
+    if (instrumentCapacity < registry.Capacity()) instrumentCapacity = registry.Capacity();
+
+    uint64_t tableOffset = MdShmAlign(sizeof(MdShmHeader));
+    uint64_t slotsOffset = MdShmAlign(tableOffset + sizeof(MdBinaryInstrumentDef) * instrumentCapacity);
+    uint64_t latestOffset = MdShmAlign(slotsOffset + sizeof(MdShmSlot) * slots);
+    uint64_t totalSize = MdShmAlign(latestOffset + sizeof(MdShmSlot) * instrumentCapacity);
+
+    // 先删除旧对象：仍挂载着旧映射的读取方不受影响，重新 Open 后即可看到新的环
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "shm_open " << name << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, totalSize) != 0) {
+        std::cerr << "ftruncate " << name << " failed: " << strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(name);
+        return false;
+    }
+    void* p = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::cerr << "mmap " << name << " failed: " << strerror(errno) << std::endl;
+        shm_unlink(name);
+        return false;
+    }
+
+    // 预先写满整个映射，避免在行情路径上触发缺页
+    memset(p, 0, totalSize);
+
+    m_name = name;
+    m_pRegistry = &registry;
+    m_pBase = static_cast<char*>(p);
+    m_nSize = totalSize;
+    m_pHeader = new (m_pBase) MdShmHeader();
+    m_pInstruments = reinterpret_cast<MdBinaryInstrumentDef*>(m_pBase + tableOffset);
+    m_pSlots = reinterpret_cast<MdShmSlot*>(m_pBase + slotsOffset);
+    m_pLatest = reinterpret_cast<MdShmSlot*>(m_pBase + latestOffset);
+    m_nMask = slots - 1;
+    m_nSeq = 0;
+
+    m_pHeader->Version = MD_SHM_VERSION;
+    m_pHeader->HeaderSize = sizeof(MdShmHeader);
+    m_pHeader->SlotSize = sizeof(MdShmSlot);
+    m_pHeader->SlotCount = static_cast<uint32_t>(slots);
+    m_pHeader->InstrumentCapacity = instrumentCapacity;
+    m_pHeader->InstrumentTableOffset = tableOffset;
+    m_pHeader->SlotsOffset = slotsOffset;
+    m_pHeader->LatestOffset = latestOffset;
+    m_pHeader->TotalSize = totalSize;
+    m_pHeader->PriceScale = MD_BINARY_PRICE_SCALE;
+    m_pHeader->CreateTimeNs = WallClockNanos();
+    m_pHeader->InstrumentCount.store(0, std::memory_order_relaxed);
+    m_pHeader->WriteSeq.store(0, std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < registry.Size(); ++i) {
+        PublishInstrument(i, registry.Name(i).c_str());
+    }
+
+    // Magic 最后写入，读取方看到 Magic 时其余字段均已就绪
+    std::atomic_thread_fence(std::memory_order_release);
+    m_pHeader->Magic = MD_SHM_MAGIC;
+
+    std::cerr << "Shared-memory ring /dev/shm" << (name[0] == '/' ? "" : "/") << name
+              << " ready: " << slots << " slots, " << totalSize << " bytes" << std::endl;
+    return true;
+}
+
+void ShmPublisher::Close() {
+    if (!m_pBase) return;
+    munmap(m_pBase, m_nSize);
+    m_pBase = nullptr;
+    m_pHeader = nullptr;
+    m_pInstruments = nullptr;
+    m_pSlots = nullptr;
+    m_pLatest = nullptr;
+}
+
+void ShmPublisher::PublishInstrument(uint32_t index, const char* instrumentID) {
+    if (!m_pHeader || index >= m_pHeader->InstrumentCapacity) return;
+    size_t len = m_encoder.EncodeInstrumentDef(index, instrumentID);
+    memcpy(&m_pInstruments[index], m_encoder.Data(), len);
+    uint32_t count = m_pHeader->InstrumentCount.load(std::memory_order_relaxed);
+    if (index + 1 > count) m_pHeader->InstrumentCount.store(index + 1, std::memory_order_release);
+}
+
+void ShmPublisher::OnTick(TickContext& ctx) {
+    if (!m_pSlots) return;
+
+    // 运行中新增的合约：先发布合约定义，读取方看到行情时总能查到合约代码
+    uint32_t index = ctx.InstrumentIndex();
+    if (index != InstrumentRegistry::INVALID_INDEX &&
+        index >= m_pHeader->InstrumentCount.load(std::memory_order_relaxed)) {
+        uint32_t size = m_pRegistry->Size();
+        for (uint32_t i = m_pHeader->InstrumentCount.load(std::memory_order_relaxed); i < size; ++i) {
+            PublishInstrument(i, m_pRegistry->Name(i).c_str());
+        }
+    }
+
+    m_encoder.EncodeTick(ctx.Tick(), ctx.InstrumentIndex());
+
+    uint64_t seq = ++m_nSeq;
+    MdShmSlot& slot = m_pSlots[seq & m_nMask];
+    slot.Seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&slot.Tick, m_encoder.Data(), sizeof(slot.Tick));
+    slot.Seq.store(seq, std::memory_order_release);
+
+    if (index < m_pHeader->InstrumentCapacity) {
+        MdShmSlot& latest = m_pLatest[index];
+        latest.Seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&latest.Tick, m_encoder.Data(), sizeof(latest.Tick));
+        latest.Seq.store(seq, std::memory_order_release);
+    }
+    m_pHeader->WriteSeq.store(seq, std::memory_order_release);
+
+    m_nPublished.store(seq, std::memory_order_relaxed);
+}
+
+void ShmPublisher::ReportStats() {
+    if (!m_pHeader) return;
+    std::cerr << "=== ShmPublisher: name=" << m_name
+              << ", published=" << Published()
+              << ", slots=" << m_pHeader->SlotCount
+              << " ===" << std::endl;
+}
@@ -0,0 +1,53 @@
+#ifndef SHM_PUBLISHER_H
+#define SHM_PUBLISHER_H
+
+#include "TickSink.h"
+#include "MdShmFormat.h"
+#include "MdBinaryEncoder.h"
+#include "InstrumentRegistry.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// 共享内存广播环发布端，布局见 MdShmFormat.h
+// 作为流水线的输出端运行在工作线程中，每条行情编码为五档二进制记录写入环形缓冲区，
+// 同时更新所属合约的最新值槽位；本地任意数量的进程可以只读挂载、各自按游标读取。
+class ShmPublisher : public TickSink
+{
+public:
+    ShmPublisher();
+    ~ShmPublisher();
+
+    // 创建（或重建）/dev/shm/<name>，slotCount 向上取整为 2 的幂；合约表容量不小于注册表的预留容量，
+    // 已注册的合约写入合约表，运行中新增的合约在其第一条行情之前补发。失败时返回 false 并在 stderr 输出原因
+    bool Open(const char* name, size_t slotCount, uint32_t instrumentCapacity, const InstrumentRegistry& registry);
+    void Close();
+
+    // 发布合约定义，编号必须按顺序递增
+    void PublishInstrument(uint32_t index, const char* instrumentID);
+
+    virtual void OnTick(TickContext& ctx) override;
+    virtual void ReportStats() override;
+    virtual const char* Name() const override { return "shm"; }
+    virtual uint64_t BytesOut() const override { return Published() * sizeof(MdShmSlot); }
+
+    uint64_t Published() const { return m_nPublished.load(std::memory_order_relaxed); }
+
+private:
+    std::string m_name;
+    const InstrumentRegistry* m_pRegistry;
+    char* m_pBase;
+    size_t m_nSize;
+    MdShmHeader* m_pHeader;
+    MdBinaryInstrumentDef* m_pInstruments;
+    MdShmSlot* m_pSlots;
+    MdShmSlot* m_pLatest;
+    uint64_t m_nMask;
+    uint64_t m_nSeq;
+
+    MdBinaryEncoder m_encoder;
+    std::atomic<uint64_t> m_nPublished;
+};
+
+#endif // SHM_PUBLISHER_H
@@ -0,0 +1,88 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// 单生产者/单消费者无锁环形队列
+// 容量在构造时向上取整为 2 的幂并一次性分配，运行期间不再分配内存。
+// 生产者通过 BeginPush()/CommitPush() 直接在槽位上写入数据，
+// 消费者通过 Front()/Pop() 原地读取，避免额外拷贝。
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(size_t capacity)
+        : m_nMask(RoundUpPow2(capacity) - 1), m_slots(m_nMask + 1),
+          m_head(0), m_cachedTail(0), m_tail(0), m_cachedHead(0) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t Capacity() const { return m_nMask + 1; }
+
+    // 当前占用量，任意线程可调用（结果为近似值）。先读消费位置再读生产位置，两次读取之间出队不会使结果回绕；
+    // 两次读取之间的入队可能使差值超过容量，因此限制在容量以内
+    size_t Size() const {
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t size = head > tail ? head - tail : 0;
+        return size < Capacity() ? size : Capacity();
+    }
+
+    // --- 生产者接口 ---
+
+    // 获取下一个可写槽位，队列已满时返回 nullptr
+    T* BeginPush() {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail > m_nMask) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail > m_nMask) return nullptr;
+        }
+        return &m_slots[head & m_nMask];
+    }
+
+    // 发布 BeginPush() 返回的槽位，返回发布后占用量的上界（基于缓存的消费位置）
+    size_t CommitPush() {
+        size_t head = m_head.load(std::memory_order_relaxed) + 1;
+        m_head.store(head, std::memory_order_release);
+        return head - m_cachedTail;
+    }
+
+    // --- 消费者接口 ---
+
+    // 获取队首元素，队列为空时返回 nullptr
+    T* Front() {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead) return nullptr;
+        }
+        return &m_slots[tail & m_nMask];
+    }
+
+    // 释放 Front() 返回的槽位
+    void Pop() {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    static size_t RoundUpPow2(size_t n) {
+        size_t v = 1;
+        while (v < n) v <<= 1;
+        return v;
+    }
+
+    const size_t m_nMask;
+    std::vector<T> m_slots;
+
+    // 生产者与消费者各自的索引放在不同的缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> m_head;   // 生产者写入
+    size_t m_cachedTail;                      // 生产者缓存的消费位置
+    alignas(64) std::atomic<size_t> m_tail;   // 消费者写入
+    size_t m_cachedHead;                      // 消费者缓存的生产位置
+    char m_padding[64 - sizeof(size_t) * 2];
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,744 @@
+#include "SseServer.h"
+#include "config.h"
+#include "InstrumentRegistry.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// epoll_wait 的最长阻塞时间，用于检查停止标志和发送保活注释
+static const int EPOLL_TIMEOUT_MS = 1000;
+// 空闲超过该时间时向所有客户端发送保活注释，防止代理断开连接
+static const int64_t KEEPALIVE_NS = 15 * 1000000000LL;
+// HTTP 请求头的最大长度
+static const size_t MAX_REQUEST_SIZE = 8192;
+// 连接后未在该时间内进入推送状态（请求不完整或错误响应未写完）时关闭，防止空连接占满 SSE_MAX_CLIENTS
+static const int64_t REQUEST_TIMEOUT_NS = 5 * 1000000000LL;
+// 合并模式客户端的套接字发送缓冲区：内核中积压的旧帧无法再被合并，因此尽量缩小
+static const int CONFLATE_SNDBUF_BYTES = 64 * 1024;
+// 单次 sendmsg 最多携带的字节数
+static const size_t MAX_SEND_BYTES = 256 * 1024;
+// epoll 事件数据中监听套接字与 eventfd 的标记，客户端直接使用文件描述符
+static const uint64_t LISTEN_TAG = 0xFFFFFFFF00000001ULL;
+static const uint64_t EVENT_TAG = 0xFFFFFFFF00000002ULL;
+
+static const char SSE_RESPONSE_HEADER[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "\r\n";
+
+static const char NOT_FOUND_RESPONSE[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 10\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "Not Found\n";
+
+static const char KEEPALIVE_FRAME[] = ": keepalive\n\n";
+
+static double ConflationRatio(uint64_t conflated, uint64_t sent) {
+    return conflated + sent > 0 ? static_cast<double>(conflated) / (conflated + sent) : 0.0;
+}
+
+static size_t RoundUpPow2(size_t n) {
+    size_t v = 1;
+    while (v < n) v <<= 1;
+    return v;
+}
+
+SseServer::SseServer()
+    : m_nListenFd(-1), m_nEpollFd(-1), m_nEventFd(-1), m_bRunning(false),
+      m_inbound(SSE_INBOUND_CAPACITY), m_bSignalPending(false), m_bSleeping(false),
+      m_nInboundDrops(0), m_bReportRequested(false), m_nBytesSent(0), m_pLastValues(nullptr),
+      m_pSnapshotSource(nullptr), m_bDeltaFrames(false), m_nChangedFrames(0), m_nChangedBytes(0),
+      m_nChangedFullBytes(0), m_log(SSE_LOG_BYTES), m_entries(RoundUpPow2(SSE_LOG_FRAMES)),
+      m_nHeadSeq(0), m_nTailSeq(0), m_nLogEnd(0), m_nLastSequence(0), m_nLastFrameNs(0),
+      m_nTotalAccepted(0), m_nRequestTimeouts(0), m_nTotalDrops(0), m_nTotalConflated(0), m_nTotalConflateSent(0),
+      m_nSnapshotFrames(0) {
+    m_snapshotEncoder.SetNullInvalidPrices(OUTPUT_NULL_INVALID_PRICE);
+    m_snapshotEncoder.SetDepth(OUTPUT_DEPTH);
+    MdJsonEncoder* encoders[] = {&m_fullEncoder, &m_changedEncoder};
+    for (MdJsonEncoder* encoder : encoders) {
+        encoder->SetNullInvalidPrices(OUTPUT_NULL_INVALID_PRICE);
+        encoder->SetDepth(OUTPUT_DEPTH);
+        encoder->SetTickDeltas(OUTPUT_TICK_DELTAS);
+    }
+}
+
+SseServer::~SseServer() {
+    Stop();
+}
+
+bool SseServer::Start(int port) {
+    // 每个客户端占用一个文件描述符，尽量提高上限
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    m_nListenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_nListenFd < 0) {
+        std::cerr << "socket failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    int one = 1;
+    setsockopt(m_nListenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(m_nListenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(m_nListenFd, SOMAXCONN) != 0) {
+        std::cerr << "bind/listen on port " << port << " failed: " << strerror(errno) << std::endl;
+        close(m_nListenFd);
+        m_nListenFd = -1;
+        return false;
+    }
+
+    m_nEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_nEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_nEpollFd < 0 || m_nEventFd < 0) {
+        std::cerr << "epoll/eventfd creation failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_TAG;
+    epoll_ctl(m_nEpollFd, EPOLL_CTL_ADD, m_nListenFd, &ev);
+    ev.events = EPOLLIN;
+    ev.data.u64 = EVENT_TAG;
+    epoll_ctl(m_nEpollFd, EPOLL_CTL_ADD, m_nEventFd, &ev);
+
+    m_nLastFrameNs = MonotonicNanos();
+    m_bRunning = true;
+    m_thread = std::thread(&SseServer::Run, this);
+    std::cerr << "SSE server" << (m_name.empty() ? "" : " (" + m_name + ")") << " listening on 0.0.0.0:" << port
+              << "/events" << std::endl;
+    return true;
+}
+
+void SseServer::Stop() {
+    if (m_bRunning.exchange(false)) {
+        Wake();
+        if (m_thread.joinable()) m_thread.join();
+    }
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) close(it->first);
+    m_clients.clear();
+    if (m_nListenFd >= 0) close(m_nListenFd);
+    if (m_nEpollFd >= 0) close(m_nEpollFd);
+    if (m_nEventFd >= 0) close(m_nEventFd);
+    m_nListenFd = m_nEpollFd = m_nEventFd = -1;
+}
+
+// --- 流水线工作线程 ---
+
+void SseServer::OnTick(TickContext& ctx) {
+    if (m_bDeltaFrames && ctx.InstrumentIndex() != InstrumentRegistry::INVALID_INDEX) {
+        PublishChanged(ctx);
+        return;
+    }
+    size_t len = 0;
+    const char* frame = ctx.JsonFrame(len);
+    Publish(frame, len, ctx.InstrumentIndex(), ctx.Sequence());
+}
+
+void SseServer::Publish(const char* frame, size_t len, uint32_t key, uint64_t sequence) {
+    PublishFrames(frame, len, nullptr, 0, key, sequence);
+}
+
+// 变化字段模式：完整帧总是编码（作为该合约的最新帧），距上一个完整帧不足 SSE_DELTA_REFRESH_FRAMES 帧时
+// 再编码变化帧进入日志。入队失败时下一帧改发完整帧，消费者据 Seq 的跳变发现缺失并等待这一帧
+void SseServer::PublishChanged(TickContext& ctx) {
+    uint32_t index = ctx.InstrumentIndex();
+    if (index >= m_deltaStates.size()) m_deltaStates.resize(index + 1, DeltaState());
+    DeltaState& state = m_deltaStates[index];
+    const CThostFtdcDepthMarketDataField& field = ctx.Tick().Field;
+    const TickDelta& delta = ctx.Delta();
+    uint64_t seq = state.Seq + 1;
+
+    size_t fullLen = m_fullEncoder.EncodeSseChanged(&field, &delta, nullptr, nullptr, seq);
+    size_t len = 0;
+    bool refresh = !state.Valid || state.SinceFull + 1 >= static_cast<uint32_t>(SSE_DELTA_REFRESH_FRAMES);
+    if (!refresh) {
+        len = m_changedEncoder.EncodeSseChanged(&field, &delta, &state.Field, &state.Delta, seq);
+        if (len + fullLen > sizeof(InboundFrame::Data)) refresh = true;
+    }
+
+    bool ok = refresh ? PublishFrames(m_fullEncoder.Data(), fullLen, nullptr, 0, index, ctx.Sequence())
+                      : PublishFrames(m_changedEncoder.Data(), len, m_fullEncoder.Data(), fullLen, index,
+                                      ctx.Sequence());
+    state.Seq = seq;
+    if (!ok) {
+        state.Valid = false;
+        return;
+    }
+    state.Valid = true;
+    state.SinceFull = refresh ? 0 : state.SinceFull + 1;
+    state.Field = field;
+    state.Delta = delta;
+    if (!refresh) {
+        m_nChangedFrames.store(m_nChangedFrames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_nChangedBytes.store(m_nChangedBytes.load(std::memory_order_relaxed) + len, std::memory_order_relaxed);
+        m_nChangedFullBytes.store(m_nChangedFullBytes.load(std::memory_order_relaxed) + fullLen,
+                                  std::memory_order_relaxed);
+    }
+}
+
+bool SseServer::PublishFrames(const char* frame, size_t len, const char* full, size_t fullLen, uint32_t key,
+                              uint64_t sequence) {
+    InboundFrame* slot = len + fullLen <= sizeof(slot->Data) ? m_inbound.BeginPush() : nullptr;
+    if (!slot) {
+        m_nInboundDrops.store(m_nInboundDrops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+    slot->Sequence = sequence;
+    slot->Length = static_cast<uint32_t>(len);
+    slot->FullLength = static_cast<uint32_t>(fullLen);
+    slot->Instrument = key;
+    memcpy(slot->Data, frame, len);
+    if (fullLen > 0) memcpy(slot->Data + len, full, fullLen);
+    m_inbound.CommitPush();
+    m_bSignalPending = true;
+
+    // 服务器线程正在等待时立即唤醒，否则它会在处理完当前事件后自行取走。
+    // CommitPush() 只是 release 写入，与 Run() 中一样用 seq_cst 栅栏隔开入队和读取休眠标志，避免丢失唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_bSleeping.load()) {
+        Wake();
+        m_bSignalPending = false;
+    }
+    return true;
+}
+
+void SseServer::OnIdle() {
+    if (m_bSignalPending) {
+        Wake();
+        m_bSignalPending = false;
+    }
+}
+
+void SseServer::OnStop() {
+    OnIdle();
+}
+
+void SseServer::ReportStats() {
+    // 客户端列表只在服务器线程中访问，由它输出统计
+    m_bReportRequested = true;
+    Wake();
+}
+
+void SseServer::Wake() {
+    uint64_t one = 1;
+    ssize_t ret = write(m_nEventFd, &one, sizeof(one));
+    (void)ret;
+}
+
+// --- 服务器线程 ---
+
+void SseServer::Run() {
+    std::vector<struct epoll_event> events(1024);
+
+    while (m_bRunning.load()) {
+        // 先声明等待再复查队列，与 PublishFrames() 中的唤醒判断配合（两侧各有一个 seq_cst 栅栏）
+        m_bSleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int timeout = m_inbound.Front() ? 0 : EPOLL_TIMEOUT_MS;
+        int n = epoll_wait(m_nEpollFd, events.data(), static_cast<int>(events.size()), timeout);
+        m_bSleeping.store(false);
+        if (n < 0 && errno != EINTR) {
+            std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == LISTEN_TAG) {
+                AcceptClients();
+                continue;
+            }
+            if (tag == EVENT_TAG) {
+                uint64_t value;
+                ssize_t ret = read(m_nEventFd, &value, sizeof(value));
+                (void)ret;
+                continue;
+            }
+            int fd = static_cast<int>(tag);
+            auto it = m_clients.find(fd);
+            if (it == m_clients.end()) continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                CloseClient(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) it->second.Writable = true;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+                HandleReadable(it->second);
+                it = m_clients.find(fd);
+                if (it == m_clients.end()) continue;
+            }
+            FlushClient(it->second);
+        }
+
+        DrainInbound();
+
+        int64_t now = MonotonicNanos();
+        if (now - m_nLastFrameNs >= KEEPALIVE_NS) {
+            AppendToLog(KEEPALIVE_FRAME, sizeof(KEEPALIVE_FRAME) - 1, InstrumentRegistry::INVALID_INDEX);
+        }
+
+        // 向所有有新数据且可写的客户端推送；FlushClient 可能关闭客户端，先收集描述符。
+        // 握手超时的客户端同样先收集，遍历结束后再关闭
+        std::vector<int> fds;
+        std::vector<int> expired;
+        fds.reserve(m_clients.size());
+        for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+            Client& c = it->second;
+            if (!c.Streaming && now - c.AcceptNs >= REQUEST_TIMEOUT_NS) {
+                expired.push_back(it->first);
+                continue;
+            }
+            TrimClient(c);
+            if (c.Writable && (!c.Pending.empty() || !c.Dirty.empty() || (c.Streaming && c.Cursor < m_nHeadSeq))) {
+                fds.push_back(it->first);
+            }
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            // 客户端很多时一轮推送耗时较长，期间定期取走入站帧，避免流水线侧队列溢出
+            if (i % 64 == 63) DrainInbound();
+            auto it = m_clients.find(fds[i]);
+            if (it != m_clients.end()) FlushClient(it->second);
+        }
+        for (size_t i = 0; i < expired.size(); ++i) {
+            CloseClient(expired[i]);
+            ++m_nRequestTimeouts;
+        }
+
+        if (m_bReportRequested.exchange(false)) PrintStats();
+    }
+}
+
+void SseServer::AcceptClients() {
+    while (true) {
+        struct sockaddr_in addr;
+        socklen_t addrLen = sizeof(addr);
+        int fd = accept4(m_nListenFd, reinterpret_cast<struct sockaddr*>(&addr), &addrLen,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "accept failed: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        if (static_cast<int>(m_clients.size()) >= SSE_MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.u64 = static_cast<uint64_t>(fd);
+        if (epoll_ctl(m_nEpollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+
+        char ip[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        Client& client = m_clients[fd];
+        client.Fd = fd;
+        client.Peer = std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+        client.Streaming = false;
+        client.Writable = true;
+        client.CloseAfterWrite = false;
+        client.AcceptNs = MonotonicNanos();
+        client.Cursor = m_nHeadSeq;
+        client.Drops = 0;
+        client.BytesSent = 0;
+        client.FramesSent = 0;
+        client.Conflate = false;
+        client.Conflated = 0;
+        ++m_nTotalAccepted;
+    }
+}
+
+void SseServer::HandleReadable(Client& client) {
+    char buf[4096];
+    while (true) {
+        ssize_t n = recv(client.Fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            // 握手完成后客户端发来的数据一律忽略
+            if (client.Streaming || client.CloseAfterWrite) continue;
+            client.Request.append(buf, n);
+            if (client.Request.find("\r\n\r\n") != std::string::npos) {
+                HandleRequest(client);
+            } else if (client.Request.size() > MAX_REQUEST_SIZE) {
+                CloseClient(client.Fd);
+                return;
+            }
+            continue;
+        }
+        if (n == 0) {
+            CloseClient(client.Fd);
+            return;
+        }
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) CloseClient(client.Fd);
+        return;
+    }
+}
+
+void SseServer::HandleRequest(Client& client) {
+    // 只支持 GET /events，查询参数 conflate=1 开启合并模式
+    const std::string& req = client.Request;
+    bool isEvents = req.compare(0, 12, "GET /events ") == 0 || req.compare(0, 12, "GET /events?") == 0;
+    if (isEvents) {
+        std::string target = req.substr(4, req.find(' ', 4) - 4);
+        size_t query = target.find('?');
+        client.Conflate = query != std::string::npos && target.find("conflate=1", query) != std::string::npos;
+        if (client.Conflate) {
+            int sndbuf = CONFLATE_SNDBUF_BYTES;
+            setsockopt(client.Fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        }
+        client.Pending.assign(SSE_RESPONSE_HEADER, sizeof(SSE_RESPONSE_HEADER) - 1);
+        client.Streaming = true;
+        client.Cursor = m_nHeadSeq;
+        AppendSnapshot(client);
+    } else {
+        client.Pending.assign(NOT_FOUND_RESPONSE, sizeof(NOT_FOUND_RESPONSE) - 1);
+        client.CloseAfterWrite = true;
+    }
+    client.Request.clear();
+    client.Request.shrink_to_fit();
+}
+
+// 快照与实时流的衔接：日志已包含序号不超过 m_nLastSequence 的全部行情，客户端从日志头部开始接收。
+// 缓存中序号不超过它的条目作为快照发送；更新的条目对应的帧还在入站队列中，随后会经日志送达，
+// 因此跳过，既不重复也不遗漏。
+// 变化字段模式下日志中的帧以上一帧为基准，快照改用各合约的最新完整帧，保证与日志头部衔接
+void SseServer::AppendSnapshot(Client& client) {
+    if (m_pSnapshotSource) {
+        m_nSnapshotFrames += m_pSnapshotSource->AppendSnapshot(client.Pending, m_nLastSequence);
+        return;
+    }
+    if (m_bDeltaFrames) {
+        for (uint32_t i = 0; i < m_latest.size(); ++i) {
+            if (m_latest[i].Frame.empty()) continue;
+            client.Pending.append(m_latest[i].Frame);
+            ++m_nSnapshotFrames;
+        }
+        return;
+    }
+    if (!m_pLastValues) return;
+    TickRecord tick;
+    uint64_t sequence = 0;
+    for (uint32_t i = 0; i < m_pLastValues->Capacity(); ++i) {
+        if (!m_pLastValues->Read(i, tick, sequence) || sequence > m_nLastSequence) continue;
+        size_t len = m_snapshotEncoder.EncodeSse(&tick.Field);
+        client.Pending.append(m_snapshotEncoder.Data(), len);
+        ++m_nSnapshotFrames;
+    }
+}
+
+void SseServer::DrainInbound() {
+    InboundFrame* frame;
+    while ((frame = m_inbound.Front()) != nullptr) {
+        uint32_t instrument = frame->Instrument;
+        if (instrument != InstrumentRegistry::INVALID_INDEX) {
+            if (instrument >= m_latest.size()) m_latest.resize(instrument + 1);
+            m_latest[instrument].Seq = m_nHeadSeq;
+            // 变化字段模式下最新帧保存完整帧，用于快照和合并补发
+            if (frame->FullLength > 0) {
+                m_latest[instrument].Frame.assign(frame->Data + frame->Length, frame->FullLength);
+            } else {
+                m_latest[instrument].Frame.assign(frame->Data, frame->Length);
+            }
+        }
+        AppendToLog(frame->Data, frame->Length, instrument);
+        m_nLastSequence = frame->Sequence;
+        m_inbound.Pop();
+    }
+}
+
+void SseServer::AppendToLog(const char* data, size_t len, uint32_t instrument) {
+    const uint64_t capacity = m_log.size();
+    if (len > capacity) return;
+
+    // 帧在物理上保持连续：放不下时跳到日志开头
+    uint64_t offset = m_nLogEnd;
+    uint64_t physical = offset % capacity;
+    if (physical + len > capacity) offset += capacity - physical;
+    uint64_t end = offset + len;
+
+    // 淘汰将被覆盖的旧帧以及超出索引容量的旧帧
+    const uint64_t maxFrames = m_entries.size();
+    while (m_nTailSeq < m_nHeadSeq &&
+           (m_entries[m_nTailSeq & (maxFrames - 1)].Offset + capacity < end ||
+            m_nHeadSeq - m_nTailSeq >= maxFrames)) {
+        ++m_nTailSeq;
+    }
+
+    memcpy(m_log.data() + offset % capacity, data, len);
+    LogEntry& entry = m_entries[m_nHeadSeq & (maxFrames - 1)];
+    entry.Offset = offset;
+    entry.Length = static_cast<uint32_t>(len);
+    entry.Instrument = instrument;
+    ++m_nHeadSeq;
+    m_nLogEnd = end;
+    m_nLastFrameNs = MonotonicNanos();
+}
+
+// 落后过多（超过积压上限或帧已被日志淘汰）：跳过最旧的帧；合并模式下改为按合约合并。
+// 变化字段模式下跳过变化帧会使客户端状态出错，普通客户端超过积压上限时同样按合约补发完整帧
+void SseServer::TrimClient(Client& client) {
+    if (!client.Streaming) return;
+    if (client.Conflate || m_bDeltaFrames) {
+        uint64_t lag = static_cast<uint64_t>(client.Conflate ? SSE_CONFLATE_LAG_FRAMES : SSE_CLIENT_MAX_QUEUE_FRAMES);
+        if (client.Cursor < m_nTailSeq || m_nHeadSeq - client.Cursor > lag) {
+            ConflateClient(client, m_nHeadSeq);
+        }
+        return;
+    }
+    uint64_t oldest = m_nTailSeq;
+    uint64_t limit = static_cast<uint64_t>(SSE_CLIENT_MAX_QUEUE_FRAMES);
+    if (m_nHeadSeq > limit && m_nHeadSeq - limit > oldest) oldest = m_nHeadSeq - limit;
+    if (client.Cursor < oldest) {
+        client.Drops += oldest - client.Cursor;
+        client.Cursor = oldest;
+    }
+}
+
+// 把游标跳到 newCursor，跳过的帧按合约记为待补发；每个合约只补发一次最新帧，其余计入合并数
+void SseServer::ConflateClient(Client& client, uint64_t newCursor) {
+    size_t dirtyBefore = client.Dirty.size();
+    uint64_t skipped = 0;
+    uint64_t seq = client.Cursor;
+    if (seq < m_nTailSeq) {
+        // 帧已被日志淘汰，无法得知所属合约：最新帧落在这一段中的合约全部补发
+        for (uint32_t i = 0; i < m_latest.size(); ++i) {
+            if (m_latest[i].Seq >= seq && m_latest[i].Seq < m_nTailSeq && !m_latest[i].Frame.empty() &&
+                (i >= client.SentSeq.size() || m_latest[i].Seq >= client.SentSeq[i])) {
+                MarkDirty(client, i);
+            }
+        }
+        skipped += m_nTailSeq - seq;
+        seq = m_nTailSeq;
+    }
+    const uint64_t mask = m_entries.size() - 1;
+    for (; seq < newCursor; ++seq) {
+        // 保活注释没有可合并的对象，直接跳过；已补发过更新帧的合约不再重复标记
+        uint32_t instrument = m_entries[seq & mask].Instrument;
+        if (instrument >= m_latest.size()) continue;
+        if (instrument >= client.SentSeq.size() || seq >= client.SentSeq[instrument]) MarkDirty(client, instrument);
+        ++skipped;
+    }
+    size_t added = client.Dirty.size() - dirtyBefore;
+    client.Conflated += skipped > added ? skipped - added : 0;
+    client.Cursor = newCursor;
+}
+
+void SseServer::MarkDirty(Client& client, uint32_t instrument) {
+    if (client.DirtyMark.size() < m_latest.size()) {
+        client.DirtyMark.resize(m_latest.size(), false);
+        client.SentSeq.resize(m_latest.size(), 0);
+    }
+    if (client.DirtyMark[instrument]) return;
+    client.DirtyMark[instrument] = true;
+    client.Dirty.push_back(instrument);
+}
+
+// 待补发的合约各取最新一帧放入 Pending；日志中更早的同合约帧随后会被跳过
+void SseServer::FlushDirty(Client& client) {
+    for (size_t i = 0; i < client.Dirty.size(); ++i) {
+        uint32_t instrument = client.Dirty[i];
+        const LatestFrame& latest = m_latest[instrument];
+        client.Pending.append(latest.Frame);
+        client.SentSeq[instrument] = latest.Seq + 1;
+        client.DirtyMark[instrument] = false;
+        ++client.FramesSent;
+    }
+    client.Dirty.clear();
+}
+
+void SseServer::FlushClient(Client& client) {
+    if (!client.Writable) return;
+    TrimClient(client);
+
+    while (true) {
+        // 组装向量：先是部分写出的剩余内容，再是日志中游标之后的连续帧
+        if (client.Pending.empty() && !client.Dirty.empty()) FlushDirty(client);
+        struct iovec iov[64];
+        int count = 0;
+        size_t total = 0;
+        if (!client.Pending.empty()) {
+            iov[count].iov_base = const_cast<char*>(client.Pending.data());
+            iov[count].iov_len = client.Pending.size();
+            total += client.Pending.size();
+            ++count;
+        }
+        // 有待补发的合约时先写完 Pending，补发之后才能继续发送日志中的帧
+        uint64_t seq = client.Cursor;
+        const uint64_t mask = m_entries.size() - 1;
+        if (client.Streaming && client.Dirty.empty()) {
+            while (seq < m_nHeadSeq && count < 64 && total < MAX_SEND_BYTES) {
+                const LogEntry& e = m_entries[seq & mask];
+                if (e.Instrument < client.SentSeq.size() && seq < client.SentSeq[e.Instrument]) {
+                    // 已补发过更新的帧：跳过；前面已组装的帧先写出，保证游标连续推进
+                    if (seq != client.Cursor) break;
+                    ++client.Cursor;
+                    ++client.Conflated;
+                    ++seq;
+                    continue;
+                }
+                char* p = m_log.data() + e.Offset % m_log.size();
+                // 与上一段物理相邻时合并
+                if (count > 0 && static_cast<char*>(iov[count - 1].iov_base) + iov[count - 1].iov_len == p) {
+                    iov[count - 1].iov_len += e.Length;
+                } else {
+                    iov[count].iov_base = p;
+                    iov[count].iov_len = e.Length;
+                    ++count;
+                }
+                total += e.Length;
+                ++seq;
+            }
+        }
+        if (count == 0) break;
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ssize_t n = sendmsg(client.Fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                client.Writable = false;
+                return;
+            }
+            CloseClient(client.Fd);
+            return;
+        }
+        client.BytesSent += n;
+        m_nBytesSent.store(m_nBytesSent.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+
+        // 按实际写出的字节数推进：先消耗 Pending，再逐帧推进游标
+        size_t written = static_cast<size_t>(n);
+        if (!client.Pending.empty()) {
+            size_t used = written < client.Pending.size() ? written : client.Pending.size();
+            client.Pending.erase(0, used);
+            written -= used;
+        }
+        while (written > 0) {
+            const LogEntry& e = m_entries[client.Cursor & mask];
+            ++client.Cursor;
+            if (written < e.Length) {
+                // 帧只写出了一部分：剩余内容转存到 Pending，日志中的帧可以随时被淘汰
+                client.Pending.assign(m_log.data() + e.Offset % m_log.size() + written, e.Length - written);
+                written = 0;
+            } else {
+                written -= e.Length;
+            }
+            ++client.FramesSent;
+        }
+        if (static_cast<size_t>(n) < total) {
+            client.Writable = false;
+            return;
+        }
+    }
+
+    if (client.CloseAfterWrite && client.Pending.empty()) CloseClient(client.Fd);
+}
+
+void SseServer::CloseClient(int fd) {
+    auto it = m_clients.find(fd);
+    if (it == m_clients.end()) return;
+    m_nTotalDrops += it->second.Drops;
+    if (it->second.Conflate || m_bDeltaFrames) {
+        m_nTotalConflated += it->second.Conflated;
+        m_nTotalConflateSent += it->second.FramesSent;
+    }
+    epoll_ctl(m_nEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    m_clients.erase(it);
+}
+
+void SseServer::PrintStats() {
+    uint64_t drops = m_nTotalDrops;
+    uint64_t conflated = m_nTotalConflated;
+    uint64_t conflateSent = m_nTotalConflateSent;
+    uint64_t maxDepth = 0;
+    size_t streaming = 0;
+    size_t conflating = 0;
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        const Client& c = it->second;
+        drops += c.Drops;
+        if (!c.Streaming) continue;
+        ++streaming;
+        if (c.Conflate || m_bDeltaFrames) {
+            ++conflating;
+            conflated += c.Conflated;
+            conflateSent += c.FramesSent;
+        }
+        uint64_t depth = m_nHeadSeq - c.Cursor;
+        if (depth > maxDepth) maxDepth = depth;
+    }
+    // 合并率：合并模式客户端应收的帧中被更新的帧取代的比例
+    std::cerr << "=== SseServer" << (m_name.empty() ? "" : " (" + m_name + ")") << ": clients=" << streaming
+              << ", conflating_clients=" << conflating
+              << ", accepted=" << m_nTotalAccepted
+              << ", request_timeouts=" << m_nRequestTimeouts
+              << ", frames=" << m_nHeadSeq
+              << ", inbound_drops=" << m_nInboundDrops.load(std::memory_order_relaxed)
+              << ", client_drops=" << drops
+              << ", max_queue_depth=" << maxDepth
+              << ", snapshot_frames=" << m_nSnapshotFrames
+              << ", conflated=" << conflated
+              << ", conflation_ratio=" << ConflationRatio(conflated, conflateSent);
+    if (m_bDeltaFrames) {
+        // 变化帧相对对应完整帧的字节比例
+        uint64_t changedFull = m_nChangedFullBytes.load(std::memory_order_relaxed);
+        std::cerr << ", delta_frames=" << m_nChangedFrames.load(std::memory_order_relaxed)
+                  << ", delta_bytes_ratio="
+                  << (changedFull > 0 ? static_cast<double>(m_nChangedBytes.load(std::memory_order_relaxed)) / changedFull
+                                      : 0.0);
+    }
+    std::cerr << " ===" << std::endl;
+
+    // 逐个客户端输出，数量过多时只输出有积压或丢弃的客户端
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        const Client& c = it->second;
+        if (!c.Streaming) continue;
+        uint64_t depth = m_nHeadSeq - c.Cursor;
+        if (m_clients.size() > 32 && depth == 0 && c.Drops == 0 && c.Conflated == 0) continue;
+        std::cerr << "    client " << c.Peer
+                  << ": queue_depth=" << depth
+                  << ", pending_bytes=" << c.Pending.size()
+                  << ", drops=" << c.Drops
+                  << ", frames_sent=" << c.FramesSent
+                  << ", bytes_sent=" << c.BytesSent;
+        if (c.Conflate || m_bDeltaFrames) {
+            std::cerr << ", dirty=" << c.Dirty.size()
+                      << ", conflated=" << c.Conflated
+                      << ", conflation_ratio=" << ConflationRatio(c.Conflated, c.FramesSent);
+        }
+        std::cerr << std::endl;
+    }
+}
@@ -0,0 +1,192 @@
+#ifndef SSE_SERVER_H
+#define SSE_SERVER_H
+
+#include "TickSink.h"
+#include "SpscRing.h"
+#include "LastValueCache.h"
+#include "MdJsonEncoder.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 新客户端握手时的快照来源（取代最新值缓存），在服务器线程中调用：
+// 向 out 追加序号不超过 lastSequence 的帧，返回帧数
+class SseSnapshotSource
+{
+public:
+    virtual ~SseSnapshotSource() {}
+    virtual size_t AppendSnapshot(std::string& out, uint64_t lastSequence) = 0;
+};
+
+// 内置的 SSE 服务器（--sse-port=PORT），直接向浏览器等客户端推送 /events，取代 wrapper.py
+// 单线程 epoll + 非阻塞套接字：
+//   - 流水线工作线程在 OnTick() 中把编码好的 SSE 帧拷贝进 SPSC 队列，不接触任何套接字；
+//   - 服务器线程把帧追加到共享的广播日志中，每个客户端只保存一个游标，
+//     有新数据时用一次 sendmsg 把游标之后的连续帧写出，帧数据不会为每个客户端复制。
+// 设置了最新值缓存时，新客户端先收到所有已缓存合约的快照，再从日志当前位置开始接收实时行情。
+// 客户端落后超过 SSE_CLIENT_MAX_QUEUE_FRAMES 帧（或帧已被日志淘汰）时跳过最旧的帧并计入丢弃数。
+// 以 /events?conflate=1 连接的客户端改为合并模式：积压超过 SSE_CONFLATE_LAG_FRAMES 帧时，
+// 跳过的帧按合约记为待发送，之后每个合约只发送最新的一帧，慢客户端看到的始终是一致的最新行情。
+//
+// 变化字段模式（SetDeltaFrames，配置项 sse_delta_frames）：每个合约的第一帧和每隔 SSE_DELTA_REFRESH_FRAMES 帧
+// 输出完整帧，其余只含与上一条行情不同的字段（MdJsonEncoder::EncodeSseChanged），帧内带合约内递增的 Seq。
+// 工作线程按合约保存上一条行情，每条行情同时编码变化帧（进入广播日志）和完整帧（作为该合约的最新帧）；
+// 快照、合并补发以及落后过多的普通客户端都改用完整帧重新同步，因此客户端不会因为跳帧而得到错误的状态。
+class SseServer : public TickSink
+{
+public:
+    SseServer();
+    ~SseServer();
+
+    // 须在 Start() 之前调用；缓存由流水线写入，服务器线程在客户端握手时读取
+    void SetLastValueCache(const LastValueCache* pCache) { m_pLastValues = pCache; }
+    void SetSnapshotSource(SseSnapshotSource* pSource) { m_pSnapshotSource = pSource; }
+
+    // 日志和统计中的名称，同时运行多个服务器（如 K 线流）时用于区分，须在 Start() 之前调用
+    void SetName(const std::string& name) { m_name = name; }
+
+    // 开启变化字段模式，须在 Start() 之前调用；只作用于 OnTick() 推送的行情，不影响 Publish()
+    void SetDeltaFrames(bool enable) { m_bDeltaFrames = enable; }
+
+    // 监听 0.0.0.0:port 并启动服务器线程，失败时返回 false 并在 stderr 输出原因
+    bool Start(int port);
+    void Stop();
+
+    // 推送一帧，只能在流水线工作线程中调用（入站队列的唯一生产者）；
+    // key 为合并模式下的合并键（通常为合约编号），sequence 为与快照衔接的递增序号
+    void Publish(const char* frame, size_t len, uint32_t key, uint64_t sequence);
+
+    // --- TickSink 接口，在流水线工作线程中调用 ---
+    virtual void OnTick(TickContext& ctx) override;
+    virtual void OnIdle() override;
+    virtual void OnStop() override;
+    virtual void ReportStats() override;
+    virtual const char* Name() const override { return m_name.empty() ? "sse" : m_name.c_str(); }
+    virtual uint64_t BytesOut() const override { return m_nBytesSent.load(std::memory_order_relaxed); }
+
+private:
+    // 流水线 -> 服务器线程的定长帧槽位
+    struct InboundFrame
+    {
+        uint64_t Sequence;          // 流水线序号
+        uint32_t Length;            // 进入广播日志的帧
+        uint32_t FullLength;        // 变化字段模式下紧随其后的完整帧，0 表示日志中的帧本身就是完整帧
+        uint32_t Instrument;        // 合并键，即 Publish() 的 key（行情为合约编号）
+        char Data[1004];
+    };
+
+    // 变化字段模式下每个合约上一条已推送的行情，只在工作线程中访问
+    struct DeltaState
+    {
+        bool Valid;                 // 为 false 时下一帧输出完整帧
+        uint32_t SinceFull;         // 上一个完整帧之后的帧数
+        uint64_t Seq;               // 已推送的帧数，即上一帧的 Seq
+        CThostFtdcDepthMarketDataField Field;
+        TickDelta Delta;
+    };
+
+    // 广播日志中一帧的位置；Offset 为单调递增的虚拟偏移，物理位置为 Offset % 日志容量
+    struct LogEntry
+    {
+        uint64_t Offset;
+        uint32_t Length;
+        uint32_t Instrument;
+    };
+
+    // 每个合约最新一帧的副本，供合并模式的客户端补发
+    struct LatestFrame
+    {
+        uint64_t Seq;               // 该帧在日志中的序号
+        std::string Frame;
+    };
+
+    struct Client
+    {
+        int Fd;
+        std::string Peer;           // 对端地址
+        std::string Request;        // 尚未收完的 HTTP 请求
+        std::string Pending;        // 部分写出的帧剩余内容，优先于日志发送
+        bool Streaming;             // 已完成握手，开始推送
+        bool Writable;              // 套接字可写（边沿触发，遇到 EAGAIN 后等待 EPOLLOUT）
+        bool CloseAfterWrite;       // 写完 Pending 后关闭（错误响应）
+        int64_t AcceptNs;           // 建立连接的时间（单调时钟），握手超时据此判断
+        uint64_t Cursor;            // 下一帧的序号
+        uint64_t Drops;             // 因落后而跳过的帧数
+        uint64_t BytesSent;
+        uint64_t FramesSent;
+
+        // 合并模式
+        bool Conflate;
+        std::vector<uint32_t> Dirty;        // 待补发最新帧的合约
+        std::vector<uint64_t> SentSeq;      // 合约编号 -> 已补发的最新帧序号 + 1，日志中序号更小的帧跳过
+        std::vector<bool> DirtyMark;
+        uint64_t Conflated;                 // 被更新的帧取代而未发送的帧数
+    };
+
+    bool PublishFrames(const char* frame, size_t len, const char* full, size_t fullLen, uint32_t key,
+                       uint64_t sequence);
+    void PublishChanged(TickContext& ctx);
+    void Run();
+    void Wake();
+    void AcceptClients();
+    void HandleReadable(Client& client);
+    void HandleRequest(Client& client);
+    void AppendSnapshot(Client& client);
+    void DrainInbound();
+    void AppendToLog(const char* data, size_t len, uint32_t instrument);
+    void TrimClient(Client& client);
+    void ConflateClient(Client& client, uint64_t newCursor);
+    void MarkDirty(Client& client, uint32_t instrument);
+    void FlushDirty(Client& client);
+    void FlushClient(Client& client);
+    void CloseClient(int fd);
+    void PrintStats();
+
+    int m_nListenFd;
+    int m_nEpollFd;
+    int m_nEventFd;
+    std::thread m_thread;
+    std::atomic<bool> m_bRunning;
+
+    // 流水线侧
+    SpscRing<InboundFrame> m_inbound;
+    bool m_bSignalPending;              // 有帧入队但尚未唤醒服务器线程
+    alignas(64) std::atomic<bool> m_bSleeping;  // 服务器线程阻塞在 epoll_wait 中
+    std::atomic<uint64_t> m_nInboundDrops;
+    std::atomic<bool> m_bReportRequested;
+    std::atomic<uint64_t> m_nBytesSent;         // 所有客户端合计，只由服务器线程写入
+    const LastValueCache* m_pLastValues;
+    SseSnapshotSource* m_pSnapshotSource;
+    std::string m_name;                 // 为空时日志中不加名称
+    bool m_bDeltaFrames;
+    std::vector<DeltaState> m_deltaStates;      // 合约编号 -> 上一条行情，按需扩展
+    MdJsonEncoder m_fullEncoder;                // 变化字段模式的两个编码器，仅在工作线程中使用
+    MdJsonEncoder m_changedEncoder;
+    std::atomic<uint64_t> m_nChangedFrames;     // 以变化帧推送的行情数，只由工作线程写入
+    std::atomic<uint64_t> m_nChangedBytes;      // 变化帧的字节数及对应完整帧的字节数
+    std::atomic<uint64_t> m_nChangedFullBytes;
+
+    // 以下成员只在服务器线程中访问
+    std::vector<char> m_log;            // 广播日志数据
+    std::vector<LogEntry> m_entries;    // 帧序号 -> 日志位置（环形，按 2 的幂取模）
+    uint64_t m_nHeadSeq;                // 下一帧的序号
+    uint64_t m_nTailSeq;                // 日志中最旧一帧的序号
+    uint64_t m_nLogEnd;                 // 日志写入位置（虚拟偏移）
+    uint64_t m_nLastSequence;           // 已进入日志的最后一条行情的流水线序号
+    std::vector<LatestFrame> m_latest;  // 合约编号 -> 最新一帧
+    int64_t m_nLastFrameNs;             // 最近一次追加帧的时间，用于发送保活注释
+    std::unordered_map<int, Client> m_clients;
+    uint64_t m_nTotalAccepted;
+    uint64_t m_nRequestTimeouts;        // 握手超时而被关闭的连接数
+    uint64_t m_nTotalDrops;             // 已断开客户端的丢弃数累计
+    uint64_t m_nTotalConflated;         // 已断开客户端的合并帧数累计
+    uint64_t m_nTotalConflateSent;      // 已断开的合并模式客户端的发送帧数累计
+    uint64_t m_nSnapshotFrames;         // 已发出的快照帧数
+    MdJsonEncoder m_snapshotEncoder;    // 快照编码，仅在服务器线程中使用
+};
+
+#endif // SSE_SERVER_H
@@ -0,0 +1,436 @@
+#include "SubscriptionManager.h"
+#include "TickRecord.h"
+#include "config.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+SubscriptionManager::SubscriptionManager(InstrumentRegistry& registry, const SessionRouter* pRouter, uint32_t session)
+    : m_registry(registry), m_pRouter(pRouter), m_nSession(session), m_bRunning(true), m_pMdApi(nullptr), m_nGeneration(0), m_nStartNs(0),
+      m_nActive(0), m_nSubscribed(0), m_nFailed(0), m_nRequests(0), m_nRetries(0), m_nFullySubscribedNs(-1),
+      m_bCompleted(false) {
+    m_nChunkSize = static_cast<uint32_t>(std::max(1, SUBSCRIBE_CHUNK_SIZE));
+    if (pRouter && pRouter->SessionCount() > 1) m_label = "Session " + std::to_string(session) + ": ";
+    m_slots.reserve(registry.Capacity());
+    m_pointers.reserve(registry.Capacity());
+    m_states.reserve(registry.Capacity());
+    for (uint32_t i = 0; i < registry.Size(); ++i) {
+        if (!Owns(registry.Name(i).c_str())) continue;
+        AppendInstrument(i);
+        m_states.back() = STATE_PENDING;
+        ++m_nActive;
+    }
+    m_batch.reserve(m_nChunkSize);
+
+    m_thread = std::thread(&SubscriptionManager::Run, this);
+}
+
+SubscriptionManager::~SubscriptionManager() {
+    Stop();
+}
+
+void SubscriptionManager::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bRunning = false;
+        m_cond.notify_one();
+    }
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool SubscriptionManager::Owns(const char* instrumentID) const {
+    return !m_pRouter || m_pRouter->Route(instrumentID) == m_nSession;
+}
+
+// 为本会话新加入的合约分配槽位，追加指针和状态，按需扩展最后一批或新建一批
+void SubscriptionManager::AppendInstrument(uint32_t index) {
+    uint32_t slot = static_cast<uint32_t>(m_pointers.size());
+    if (index >= m_slots.size()) m_slots.resize(index + 1, InstrumentRegistry::INVALID_INDEX);
+    m_slots[index] = slot;
+    // CTP 的接口参数为 char*，但不会修改合约代码
+    m_pointers.push_back(const_cast<char*>(m_registry.Name(index).c_str()));
+    m_states.push_back(STATE_REMOVED);
+    if (m_chunks.empty() || m_chunks.back().End - m_chunks.back().Begin >= m_nChunkSize) {
+        Chunk chunk;
+        chunk.Begin = slot;
+        chunk.End = slot;
+        chunk.Remaining = 0;
+        chunk.Attempts = 0;
+        chunk.DeadlineNs = INT64_MAX;
+        chunk.Done = true;
+        m_chunks.push_back(chunk);
+    }
+    m_chunks.back().End = slot + 1;
+}
+
+void SubscriptionManager::Subscribe(CThostFtdcMdApi* pMdApi) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pMdApi = pMdApi;
+    ++m_nGeneration;
+    m_nStartNs = MonotonicNanos();
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        Chunk& chunk = m_chunks[i];
+        chunk.Remaining = 0;
+        for (uint32_t j = chunk.Begin; j < chunk.End; ++j) {
+            if (m_states[j] == STATE_REMOVED) continue;
+            m_states[j] = STATE_PENDING;
+            ++chunk.Remaining;
+        }
+        chunk.Attempts = 0;
+        chunk.DeadlineNs = 0;      // 立即发送
+        chunk.Done = chunk.Remaining == 0;
+    }
+    // 整体重新订阅已包含尚未发出的增删
+    m_addQueue.clear();
+    m_removeQueue.clear();
+    m_nSubscribed = 0;
+    m_nFailed = 0;
+    m_nRequests = 0;
+    m_nRetries = 0;
+    m_nFullySubscribedNs = -1;
+    m_bCompleted = false;
+    std::cerr << m_label << "Subscribing " << m_nActive << " instruments in " << m_chunks.size()
+              << " chunks of up to " << m_nChunkSize << std::endl;
+    m_cond.notify_one();
+}
+
+void SubscriptionManager::Reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pMdApi = nullptr;
+    ++m_nGeneration;
+}
+
+void SubscriptionManager::Unsubscribe(CThostFtdcMdApi* pMdApi) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pMdApi = nullptr;
+        ++m_nGeneration;
+    }
+    int failed = 0;
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        const Chunk& chunk = m_chunks[i];
+        if (pMdApi->UnSubscribeMarketData(&m_pointers[chunk.Begin], chunk.End - chunk.Begin) != 0) ++failed;
+    }
+    std::cerr << m_label << "Sending unsubscribe market data requests... " << m_chunks.size() - failed << "/"
+              << m_chunks.size() << " chunks sent" << std::endl;
+}
+
+// 合约（重新）加入订阅集合，所在批次重新打开，等待合并发送
+void SubscriptionManager::Activate(uint32_t slot, int64_t now) {
+    if (m_states[slot] == STATE_ABANDONED) {
+        --m_nFailed;
+    } else {
+        ++m_nActive;
+    }
+    m_states[slot] = STATE_PENDING;
+
+    Chunk& chunk = m_chunks[slot / m_nChunkSize];
+    if (chunk.Done) {
+        chunk.Attempts = 0;
+        chunk.DeadlineNs = INT64_MAX;
+        chunk.Done = false;
+    }
+    ++chunk.Remaining;
+    m_addQueue.push_back(slot);
+
+    if (m_bCompleted) {
+        m_bCompleted = false;
+        m_nStartNs = now;
+        m_nFullySubscribedNs = -1;
+    }
+}
+
+void SubscriptionManager::Deactivate(uint32_t slot) {
+    uint8_t& state = m_states[slot];
+    if (state == STATE_SUBSCRIBED) {
+        --m_nSubscribed;
+    } else if (state == STATE_ABANDONED) {
+        --m_nFailed;
+    } else {
+        Chunk& chunk = m_chunks[slot / m_nChunkSize];
+        if (--chunk.Remaining == 0) chunk.Done = true;
+    }
+    state = STATE_REMOVED;
+    --m_nActive;
+    m_removeQueue.push_back(slot);
+}
+
+static bool IsValidID(const std::string& id) {
+    return !id.empty() && id.size() < sizeof(TThostFtdcInstrumentIDType);
+}
+
+void SubscriptionManager::Apply(std::vector<Command>& commands) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t now = MonotonicNanos();
+
+    // 先登记新合约并重建查找表再发送订阅请求，新合约的第一条行情就能被识别；
+    // 重建失败时注册表保留原查找表，这些合约查不到编号，下面按拒绝处理
+    bool registered = false;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const Command& cmd = commands[i];
+        if (!cmd.Add || !IsValidID(cmd.InstrumentID) || !Owns(cmd.InstrumentID.c_str())) continue;
+        if (m_registry.Find(cmd.InstrumentID.c_str(), cmd.InstrumentID.size()) != InstrumentRegistry::INVALID_INDEX) {
+            continue;
+        }
+        if (m_registry.Add(cmd.InstrumentID.c_str()) != InstrumentRegistry::INVALID_INDEX) registered = true;
+    }
+    if (registered) m_registry.Build();
+
+    for (size_t i = 0; i < commands.size(); ++i) {
+        Command& cmd = commands[i];
+        const std::string& id = cmd.InstrumentID;
+        if (!IsValidID(id)) {
+            cmd.Result = CommandResult::Rejected;
+            continue;
+        }
+        if (!Owns(id.c_str())) continue;
+
+        // 冗余前置时其他会话可能已登记该合约，Find() 命中也要检查本会话是否已有槽位
+        uint32_t index = m_registry.Find(id.c_str(), id.size());
+        if (index == InstrumentRegistry::INVALID_INDEX) {
+            // 新合约没有查到：注册表已满或查找表重建失败
+            cmd.Result = cmd.Add ? CommandResult::Rejected : CommandResult::Unknown;
+            continue;
+        }
+        if (index >= m_slots.size() || m_slots[index] == InstrumentRegistry::INVALID_INDEX) {
+            if (!cmd.Add) {
+                cmd.Result = CommandResult::Unknown;
+                continue;
+            }
+            AppendInstrument(index);
+        }
+        uint32_t slot = m_slots[index];
+
+        uint8_t state = m_states[slot];
+        bool active = state != STATE_REMOVED;
+        if (cmd.Add == active && state != STATE_ABANDONED) {
+            cmd.Result = CommandResult::Unchanged;
+            continue;
+        }
+        if (cmd.Add) {
+            Activate(slot, now);
+        } else {
+            Deactivate(slot);
+        }
+        cmd.Result = CommandResult::Applied;
+    }
+
+    if (!m_addQueue.empty() || !m_removeQueue.empty()) m_cond.notify_one();
+}
+
+void SubscriptionManager::OnSubscribeResponse(const char* instrumentID, int errorID) {
+    uint32_t index = m_registry.Find(instrumentID, sizeof(TThostFtdcInstrumentIDType));
+    if (index == InstrumentRegistry::INVALID_INDEX) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_pMdApi || index >= m_slots.size() || m_slots[index] == InstrumentRegistry::INVALID_INDEX) return;
+    uint32_t slot = m_slots[index];
+    uint8_t& state = m_states[slot];
+    if (state == STATE_SUBSCRIBED || state == STATE_REMOVED) return;
+
+    int64_t now = MonotonicNanos();
+    if (state == STATE_ABANDONED) {
+        // 放弃后才到达的成功应答
+        if (errorID == 0) {
+            state = STATE_SUBSCRIBED;
+            --m_nFailed;
+            ++m_nSubscribed;
+            CheckCompleted(now);
+        }
+        return;
+    }
+
+    Chunk& chunk = m_chunks[slot / m_nChunkSize];
+    if (errorID == 0) {
+        state = STATE_SUBSCRIBED;
+        ++m_nSubscribed;
+        if (--chunk.Remaining == 0) chunk.Done = true;
+        CheckCompleted(now);
+    } else if (state != STATE_FAILED) {
+        // 同一批的失败合约在重试间隔后一起重发
+        state = STATE_FAILED;
+        chunk.DeadlineNs = std::min<int64_t>(chunk.DeadlineNs, now + SUBSCRIBE_RETRY_INTERVAL_MS * 1000000LL);
+        m_cond.notify_one();
+    }
+}
+
+const char* SubscriptionManager::StateName(uint8_t state) {
+    switch (state) {
+    case STATE_PENDING: return "pending";
+    case STATE_SENT: return "sent";
+    case STATE_SUBSCRIBED: return "subscribed";
+    case STATE_FAILED: return "failed";
+    case STATE_ABANDONED: return "abandoned";
+    default: return "removed";
+    }
+}
+
+void SubscriptionManager::List(std::string& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (uint32_t i = 0; i < m_states.size(); ++i) {
+        if (m_states[i] == STATE_REMOVED) continue;
+        out += m_pointers[i];
+        out += ' ';
+        out += StateName(m_states[i]);
+        out += '\n';
+    }
+}
+
+SubscriptionManager::Stats SubscriptionManager::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.Total = m_nActive;
+    stats.Subscribed = m_nSubscribed;
+    stats.Failed = m_nFailed;
+    stats.Requests = m_nRequests;
+    stats.Retries = m_nRetries;
+    stats.FullySubscribedNs = m_nFullySubscribedNs;
+    return stats;
+}
+
+// 发送线程：先合并发送运行中的增删，再依次发送到期的批次，全部发送完毕后休眠到最近的到期时间
+void SubscriptionManager::Run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_bRunning) {
+        int64_t now = MonotonicNanos();
+        int64_t next = INT64_MAX;
+        if (m_pMdApi) {
+            uint64_t generation = m_nGeneration;
+            if (!m_removeQueue.empty()) SendQueued(lock, false, now);
+            if (!m_addQueue.empty() && m_nGeneration == generation) SendQueued(lock, true, now);
+            for (size_t i = 0; i < m_chunks.size() && m_nGeneration == generation; ++i) {
+                Chunk& chunk = m_chunks[i];
+                if (chunk.Done) continue;
+                if (chunk.DeadlineNs <= now) SendChunk(lock, chunk, now);
+                if (!chunk.Done) next = std::min(next, chunk.DeadlineNs);
+            }
+            // 发送期间有新的命令或重新登录时立即再处理一轮
+            if (m_nGeneration != generation || !m_addQueue.empty() || !m_removeQueue.empty()) continue;
+            CheckCompleted(MonotonicNanos());
+        }
+
+        if (next == INT64_MAX) {
+            m_cond.wait(lock);
+        } else {
+            m_cond.wait_for(lock, std::chrono::nanoseconds(std::max<int64_t>(0, next - MonotonicNanos())));
+        }
+    }
+}
+
+// 发送一批中尚未确认的合约；首次发送直接使用预先构建的指针数组
+void SubscriptionManager::SendChunk(std::unique_lock<std::mutex>& lock, Chunk& chunk, int64_t now) {
+    if (chunk.Attempts >= SUBSCRIBE_MAX_ATTEMPTS) {
+        std::cerr << m_label << "Subscribe gave up on " << chunk.Remaining << " instruments after " << chunk.Attempts
+                  << " attempts" << std::endl;
+        for (uint32_t i = chunk.Begin; i < chunk.End; ++i) {
+            uint8_t state = m_states[i];
+            if (state == STATE_PENDING || state == STATE_SENT || state == STATE_FAILED) {
+                std::cerr << "  not subscribed: " << m_pointers[i] << std::endl;
+                m_states[i] = STATE_ABANDONED;
+            }
+        }
+        m_nFailed += chunk.Remaining;
+        chunk.Remaining = 0;
+        chunk.Done = true;
+        return;
+    }
+
+    char** ppInstrumentID = &m_pointers[chunk.Begin];
+    int count = static_cast<int>(chunk.End - chunk.Begin);
+    if (chunk.Remaining < chunk.End - chunk.Begin) {
+        m_batch.clear();
+        for (uint32_t i = chunk.Begin; i < chunk.End; ++i) {
+            uint8_t state = m_states[i];
+            if (state == STATE_PENDING || state == STATE_SENT || state == STATE_FAILED) m_batch.push_back(m_pointers[i]);
+        }
+        ppInstrumentID = m_batch.data();
+        count = static_cast<int>(m_batch.size());
+    }
+    for (uint32_t i = chunk.Begin; i < chunk.End; ++i) {
+        if (m_states[i] == STATE_PENDING || m_states[i] == STATE_FAILED) m_states[i] = STATE_SENT;
+    }
+    if (chunk.Attempts > 0) ++m_nRetries;
+    ++chunk.Attempts;
+    ++m_nRequests;
+
+    // 发送期间释放锁，应答回调可以并发更新状态；m_batch 只在本线程中使用
+    CThostFtdcMdApi* pMdApi = m_pMdApi;
+    uint64_t generation = m_nGeneration;
+    lock.unlock();
+    int ret = pMdApi->SubscribeMarketData(ppInstrumentID, count);
+    lock.lock();
+    if (m_nGeneration != generation) return;   // 期间断线或重新登录，状态已重置
+
+    // -2/-3 为请求队列满或超过每秒请求数，等待重试间隔后重发；其他情况等待应答超时
+    if (ret != 0) {
+        std::cerr << m_label << "SubscribeMarketData returned " << ret << " for " << count << " instruments, will retry" << std::endl;
+        chunk.DeadlineNs = now + SUBSCRIBE_RETRY_INTERVAL_MS * 1000000LL;
+    } else {
+        chunk.DeadlineNs = now + SUBSCRIBE_RESPONSE_TIMEOUT_MS * 1000000LL;
+    }
+}
+
+// 合并发送运行中累积的新增（或移除）合约，每次调用最多 SUBSCRIBE_CHUNK_SIZE 个；
+// 发送时按当前状态过滤，先加后删（或先删后加）的合约只按最终状态处理
+void SubscriptionManager::SendQueued(std::unique_lock<std::mutex>& lock, bool subscribe, int64_t now) {
+    m_sending.clear();
+    m_sending.swap(subscribe ? m_addQueue : m_removeQueue);
+
+    size_t pos = 0;
+    while (pos < m_sending.size()) {
+        size_t first = pos;
+        m_batch.clear();
+        for (; pos < m_sending.size() && m_batch.size() < m_nChunkSize; ++pos) {
+            uint32_t slot = m_sending[pos];
+            uint8_t state = m_states[slot];
+            if (subscribe ? state != STATE_PENDING : state != STATE_REMOVED) continue;
+            if (std::find(m_batch.begin(), m_batch.end(), m_pointers[slot]) != m_batch.end()) continue;
+            if (subscribe) {
+                m_states[slot] = STATE_SENT;
+                Chunk& chunk = m_chunks[slot / m_nChunkSize];
+                if (chunk.Attempts == 0) chunk.Attempts = 1;
+                chunk.DeadlineNs = std::min<int64_t>(chunk.DeadlineNs, now + SUBSCRIBE_RESPONSE_TIMEOUT_MS * 1000000LL);
+            }
+            m_batch.push_back(m_pointers[slot]);
+        }
+        if (m_batch.empty()) continue;
+
+        if (subscribe) ++m_nRequests;
+        CThostFtdcMdApi* pMdApi = m_pMdApi;
+        uint64_t generation = m_nGeneration;
+        int count = static_cast<int>(m_batch.size());
+        lock.unlock();
+        int ret = subscribe ? pMdApi->SubscribeMarketData(m_batch.data(), count)
+                            : pMdApi->UnSubscribeMarketData(m_batch.data(), count);
+        lock.lock();
+        std::cerr << m_label << (subscribe ? "Subscribe " : "Unsubscribe ") << count << " instruments at runtime... "
+                  << (ret == 0 ? "success" : "failed") << std::endl;
+        if (m_nGeneration != generation) return;
+
+        // 订阅请求被拒绝时由所在批次在重试间隔后重发
+        if (ret != 0 && subscribe) {
+            for (size_t i = first; i < pos; ++i) {
+                uint32_t slot = m_sending[i];
+                if (m_states[slot] != STATE_SENT) continue;
+                Chunk& chunk = m_chunks[slot / m_nChunkSize];
+                chunk.DeadlineNs = std::min<int64_t>(chunk.DeadlineNs, now + SUBSCRIBE_RETRY_INTERVAL_MS * 1000000LL);
+            }
+        }
+    }
+}
+
+void SubscriptionManager::CheckCompleted(int64_t now) {
+    if (m_bCompleted || m_nSubscribed + m_nFailed < m_nActive) return;
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        if (!m_chunks[i].Done) return;
+    }
+    m_bCompleted = true;
+    if (m_nFailed == 0) m_nFullySubscribedNs = now - m_nStartNs;
+    std::cerr << m_label << "=== Subscription complete: subscribed=" << m_nSubscribed << "/" << m_nActive
+              << ", failed=" << m_nFailed
+              << ", requests=" << m_nRequests
+              << ", retries=" << m_nRetries
+              << ", elapsed_ms=" << (now - m_nStartNs) / 1e6
+              << " ===" << std::endl;
+}
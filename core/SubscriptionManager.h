@@ -0,0 +1,144 @@
+#ifndef SUBSCRIPTION_MANAGER_H
+#define SUBSCRIPTION_MANAGER_H
+
+#include <ThostFtdcMdApi.h>
+#include "InstrumentRegistry.h"
+#include "SessionRouter.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 分批订阅管理
+// SubscribeMarketData 所需的 char* 数组直接指向注册表中的合约代码，只在合约登记时追加，
+// 断线重连后重新订阅不再分配内存（注册表须已调用 Reserve()，合约代码的地址不会变化）。
+// 登录后由内部线程按 SUBSCRIBE_CHUNK_SIZE 分批连续发送，不等待上一批的应答（流水线方式）；
+// 每批合约中订阅失败或超时未应答的部分按批重发，超过 SUBSCRIBE_MAX_ATTEMPTS 次后放弃。
+// 全部合约订阅完成时输出从发起订阅到最后一个成功应答的耗时。
+// 运行中可通过 Apply() 增删合约：同一次 Apply() 以及发送线程处理之前累积的全部变更
+// 合并为一次 SubscribeMarketData 和一次 UnSubscribeMarketData 调用，其他合约的行情不受影响。
+// 多会话时每个会话一个实例，只管理 SessionRouter 分配给本会话的合约，Apply() 忽略其他会话的命令。
+class SubscriptionManager
+{
+public:
+    struct Stats
+    {
+        uint32_t Total;             // 需要订阅的合约数
+        uint32_t Subscribed;        // 已确认订阅的合约数
+        uint32_t Failed;            // 放弃重试的合约数
+        uint64_t Requests;          // SubscribeMarketData 调用次数
+        uint64_t Retries;           // 其中的重发次数
+        int64_t FullySubscribedNs;  // 从发起订阅到全部确认的耗时，未完成时为 -1
+    };
+
+    // 运行中的增删命令；多个会话处理同一命令时取值较小（排在前面）的结果
+    enum class CommandResult
+    {
+        Applied,        // 已加入或移出订阅集合
+        Unchanged,      // 合约已在（或已不在）订阅集合中
+        Unknown,        // 移除未登记的合约
+        Rejected        // 合约代码为空或过长，注册表已满或查找表重建失败
+    };
+
+    struct Command
+    {
+        bool Add;
+        std::string InstrumentID;
+        CommandResult Result;
+    };
+
+    // pRouter 为空时管理注册表中的全部合约
+    explicit SubscriptionManager(InstrumentRegistry& registry, const SessionRouter* pRouter = nullptr,
+                                 uint32_t session = 0);
+    ~SubscriptionManager();
+
+    // 登录成功后调用：重置状态并开始分批订阅
+    void Subscribe(CThostFtdcMdApi* pMdApi);
+
+    // 连接断开时调用：停止发送，等待重新登录
+    void Reset();
+
+    // 分批取消订阅，同步发送
+    void Unsubscribe(CThostFtdcMdApi* pMdApi);
+
+    // 停止发送线程，之后不再调用 MdApi；在 Release() 之前调用
+    void Stop();
+
+    // 按顺序应用一批增删命令并填写每条命令的结果（不属于本会话的命令保持原样）；
+    // 新合约登记到注册表并重建查找表，实际的订阅请求由发送线程合并发出
+    void Apply(std::vector<Command>& commands);
+
+    // 由 OnRspSubMarketData 调用
+    void OnSubscribeResponse(const char* instrumentID, int errorID);
+
+    // 每个合约一行："合约代码 状态"
+    void List(std::string& out) const;
+
+    Stats GetStats() const;
+
+private:
+    enum InstrumentState : uint8_t
+    {
+        STATE_PENDING,      // 待发送
+        STATE_SENT,         // 已发送，等待应答
+        STATE_SUBSCRIBED,
+        STATE_FAILED,       // 应答失败，等待重发
+        STATE_ABANDONED,    // 超过重试次数，不再发送
+        STATE_REMOVED       // 已从订阅集合中移除
+    };
+
+    struct Chunk
+    {
+        uint32_t Begin;
+        uint32_t End;
+        uint32_t Remaining;         // 尚未确认且未放弃的合约数
+        int Attempts;
+        int64_t DeadlineNs;         // 到期后重发未确认的合约
+        bool Done;
+    };
+
+    void Run();
+    void SendChunk(std::unique_lock<std::mutex>& lock, Chunk& chunk, int64_t now);
+    void SendQueued(std::unique_lock<std::mutex>& lock, bool subscribe, int64_t now);
+    bool Owns(const char* instrumentID) const;
+    void AppendInstrument(uint32_t index);
+    void Activate(uint32_t slot, int64_t now);
+    void Deactivate(uint32_t slot);
+    void CheckCompleted(int64_t now);
+    static const char* StateName(uint8_t state);
+
+    // 以下按本会话的槽位编号（合约加入本会话的顺序）索引，单会话时与合约编号相同
+    InstrumentRegistry& m_registry;
+    const SessionRouter* m_pRouter;
+    uint32_t m_nSession;
+    std::string m_label;                    // 日志前缀，多会话时标明会话编号
+    std::vector<uint32_t> m_slots;          // 合约编号 -> 槽位，不属于本会话时为 INVALID_INDEX
+    std::vector<char*> m_pointers;          // 槽位 -> 注册表中的合约代码
+    std::vector<char*> m_batch;             // 重发和合并发送时的临时指针数组，预留好容量
+    std::vector<uint8_t> m_states;          // 槽位 -> InstrumentState
+    std::vector<Chunk> m_chunks;
+    uint32_t m_nChunkSize;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    bool m_bRunning;
+    CThostFtdcMdApi* m_pMdApi;              // 非空表示已登录，正在订阅
+    uint64_t m_nGeneration;                 // 每次登录加一，丢弃上一次登录的发送结果
+    std::vector<uint32_t> m_addQueue;       // 待合并发送的新增合约（槽位）
+    std::vector<uint32_t> m_removeQueue;    // 待合并发送的移除合约（槽位）
+    std::vector<uint32_t> m_sending;        // 发送线程正在处理的队列
+    int64_t m_nStartNs;
+    uint32_t m_nActive;                     // 需要订阅的合约数
+    uint32_t m_nSubscribed;
+    uint32_t m_nFailed;
+    uint64_t m_nRequests;
+    uint64_t m_nRetries;
+    int64_t m_nFullySubscribedNs;
+    bool m_bCompleted;
+};
+
+#endif // SUBSCRIPTION_MANAGER_H
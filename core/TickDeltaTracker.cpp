@@ -0,0 +1,94 @@
+#include "TickDeltaTracker.h"
+#include "NumberFormat.h"
+#include <cfloat>
+#include <cstring>
+#include <iostream>
+
+// 推断合约乘数时的候选值（国内期货、期权合约的交易单位）
+static const uint32_t MULTIPLE_CANDIDATES[] = {1, 2, 3, 5, 10, 15, 16, 20, 30, 50, 60, 100, 200, 300, 1000, 10000, 20000};
+
+TickDeltaTracker::TickDeltaTracker(uint32_t instrumentCapacity, size_t laneCount)
+    : m_states(instrumentCapacity), m_laneEpochs(laneCount, 0) {
+    memset(m_states.data(), 0, sizeof(InstrumentState) * m_states.size());
+    for (int i = 0; i < TickDelta::KIND_COUNT; ++i) m_counts[i].store(0, std::memory_order_relaxed);
+}
+
+void TickDeltaTracker::Observe(size_t lane, uint32_t epoch) {
+    if (epoch > m_laneEpochs[lane]) m_laneEpochs[lane] = epoch;
+}
+
+// 当日均价只有在唯一一个候选乘数下落在最低价和最高价之间时才采用，否则等待后续行情
+uint32_t TickDeltaTracker::InferMultiple(const CThostFtdcDepthMarketDataField& field) {
+    if (field.Volume <= 0 || !(field.Turnover > 0)) return 0;
+    if (NumberFormat::IsInvalidPrice(field.LowestPrice) || NumberFormat::IsInvalidPrice(field.HighestPrice)) return 0;
+    if (!(field.LowestPrice > 0) || field.HighestPrice < field.LowestPrice) return 0;
+
+    double perLot = field.Turnover / field.Volume;
+    double low = field.LowestPrice * (1 - 1e-9);
+    double high = field.HighestPrice * (1 + 1e-9);
+    uint32_t found = 0;
+    for (size_t i = 0; i < sizeof(MULTIPLE_CANDIDATES) / sizeof(MULTIPLE_CANDIDATES[0]); ++i) {
+        double average = perLot / MULTIPLE_CANDIDATES[i];
+        if (average < low || average > high) continue;
+        if (found != 0) return 0;
+        found = MULTIPLE_CANDIDATES[i];
+    }
+    return found;
+}
+
+void TickDeltaTracker::Compute(uint32_t index, size_t lane, uint32_t epoch,
+                               const CThostFtdcDepthMarketDataField& field, TickDelta& delta) {
+    delta.Type = TickDelta::KIND_BASELINE;
+    delta.Volume = 0;
+    delta.Turnover = 0;
+    delta.OpenInterest = 0;
+    delta.TradePrice = DBL_MAX;
+
+    if (index < m_states.size()) {
+        InstrumentState& state = m_states[index];
+        uint32_t day = ParseTradingDay(field.TradingDay);
+        if (day == 0) day = state.TradingDay;
+
+        bool reconnected = state.TradingDay != 0 && m_laneEpochs[state.Lane] != state.Epoch;
+        if (state.TradingDay == 0) {
+            // 第一条行情只建立基准
+        } else if (day < state.TradingDay) {
+            delta.Type = TickDelta::KIND_STALE;
+        } else if (day == state.TradingDay && field.Volume < state.Volume) {
+            // 重连后累计量变小说明上游重置了累计量（前置重启、换了前置），重新建立基准；否则是落后的旧行情
+            if (!reconnected) delta.Type = TickDelta::KIND_STALE;
+        } else {
+            // 交易日变化时累计量从 0 起算，优先于断线标记：此时增量总是覆盖当日开盘以来的全部成交
+            bool rollover = day != state.TradingDay;
+            delta.Type = rollover ? TickDelta::KIND_ROLLOVER : reconnected ? TickDelta::KIND_GAP : TickDelta::KIND_TICK;
+            delta.Volume = rollover ? field.Volume : field.Volume - state.Volume;
+            delta.Turnover = rollover ? field.Turnover : field.Turnover - state.Turnover;
+            delta.OpenInterest = field.OpenInterest - state.OpenInterest;
+        }
+
+        if (delta.Type != TickDelta::KIND_STALE) {
+            if (state.Multiple == 0) state.Multiple = InferMultiple(field);
+            if (delta.Volume > 0 && state.Multiple != 0) {
+                delta.TradePrice = delta.Turnover / delta.Volume / state.Multiple;
+            }
+            state.TradingDay = day != 0 ? day : 1;
+            state.Lane = static_cast<uint32_t>(lane);
+            state.Epoch = epoch;
+            state.Volume = field.Volume;
+            state.Turnover = field.Turnover;
+            state.OpenInterest = field.OpenInterest;
+        }
+    }
+
+    std::atomic<uint64_t>& count = m_counts[delta.Type];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void TickDeltaTracker::ReportStats() const {
+    std::cerr << "=== TickDeltas: baseline=" << Count(TickDelta::KIND_BASELINE)
+              << ", tick=" << Count(TickDelta::KIND_TICK)
+              << ", rollover=" << Count(TickDelta::KIND_ROLLOVER)
+              << ", gap=" << Count(TickDelta::KIND_GAP)
+              << ", stale=" << Count(TickDelta::KIND_STALE)
+              << " ===" << std::endl;
+}
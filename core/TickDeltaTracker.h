@@ -0,0 +1,82 @@
+#ifndef TICK_DELTA_TRACKER_H
+#define TICK_DELTA_TRACKER_H
+
+#include "TickRecord.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 一条行情相对同一合约上一条行情的增量
+struct TickDelta
+{
+    enum Kind
+    {
+        KIND_BASELINE,  // 未注册合约、合约的第一条行情或重连后累计量被重置：只建立基准，增量为 0
+        KIND_TICK,      // 与上一条行情的累计量之差
+        KIND_ROLLOVER,  // 交易日变化：成交量、成交额从 0 起算，持仓量仍与上一条行情比较
+        KIND_GAP,       // 上一条行情所在的会话此后断线重连过，增量包含断线期间未收到的成交
+        KIND_STALE,     // 同一交易日内累计成交量倒退（落后的前置、旧快照）：增量为 0，不更新基准
+        KIND_COUNT
+    };
+
+    Kind Type;
+    int Volume;
+    double Turnover;
+    double OpenInterest;
+    double TradePrice;      // 区间成交均价 Turnover / Volume / 合约乘数，无成交或乘数未知时为 DBL_MAX
+
+    static const char* KindName(Kind kind) {
+        static const char* const NAMES[KIND_COUNT] = {"baseline", "tick", "rollover", "gap", "stale"};
+        return NAMES[kind];
+    }
+};
+
+// 逐笔增量：CTP 行情中的 Volume、Turnover 是当日累计值，由工作线程按合约保存上一条行情的累计量，
+// 在分发前计算一次增量，所有输出端共享，下游不必各自维护同样的状态。
+//
+// 合约乘数不在行情中，由累计量推断：当日均价 Turnover / Volume / 乘数必然落在 [LowestPrice, HighestPrice] 内，
+// 在常见乘数中找到唯一满足的一个后固定下来；Turnover 不含乘数的交易所推断结果为 1。推断成功之前 TradePrice 无效。
+//
+// 断线检测：回调线程在断线时增加所在队列的纪元（TickPipeline::MarkDisconnected），每条行情带上入队时的纪元；
+// 上一条行情所在队列此后出现过更大的纪元时，本条行情标记为 KIND_GAP；此时同一交易日的累计量反而变小，
+// 说明上游重置了累计量，重新建立基准（KIND_BASELINE）而不是当作旧行情丢弃。
+// 只在流水线的工作线程中调用 Observe() 和 Compute()，统计可在任意线程读取。
+class TickDeltaTracker
+{
+public:
+    TickDeltaTracker(uint32_t instrumentCapacity, size_t laneCount);
+
+    // 每条出队的行情（含被仲裁丢弃的副本）都要调用，用于记录各队列的最新纪元
+    void Observe(size_t lane, uint32_t epoch);
+
+    // 计算增量并更新基准；index 超出容量（未注册合约）时返回 KIND_BASELINE
+    void Compute(uint32_t index, size_t lane, uint32_t epoch, const CThostFtdcDepthMarketDataField& field,
+                 TickDelta& delta);
+
+    uint64_t Count(TickDelta::Kind kind) const { return m_counts[kind].load(std::memory_order_relaxed); }
+
+    // 输出各类增量的行情数到 stderr
+    void ReportStats() const;
+
+private:
+    struct InstrumentState
+    {
+        uint32_t TradingDay;    // YYYYMMDD，0 表示尚无基准
+        uint32_t Lane;          // 上一条行情的来源队列及其纪元
+        uint32_t Epoch;
+        uint32_t Multiple;      // 推断出的合约乘数，0 表示尚未确定
+        int Volume;
+        double Turnover;
+        double OpenInterest;
+    };
+
+    static uint32_t InferMultiple(const CThostFtdcDepthMarketDataField& field);
+
+    std::vector<InstrumentState> m_states;      // 合约编号 -> 上一条行情的累计量
+    std::vector<uint32_t> m_laneEpochs;         // 队列编号 -> 已见的最新纪元
+    std::atomic<uint64_t> m_counts[TickDelta::KIND_COUNT];
+};
+
+#endif // TICK_DELTA_TRACKER_H
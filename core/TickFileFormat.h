@@ -0,0 +1,111 @@
+#ifndef TICK_FILE_FORMAT_H
+#define TICK_FILE_FORMAT_H
+
+// 行情录制文件（--record=DIR）的格式与只读访问
+// 每个交易日一组分段文件 DIR/<TradingDay>-<NNN>.ticks，NNN 从 000 递增（单段写满或进程重启时换新段）。
+//
+// 布局：
+//   TickFileHeader（占满前 4096 字节）
+//   TickRecord[Capacity]    接收时间加 CThostFtdcDepthMarketDataField 的原样拷贝
+//
+// 文件创建时按容量预分配并整体映射，写入方只做内存拷贝，然后以 release 语义更新 RecordCount；
+// 进程崩溃时已写入的页仍在页缓存中，由内核写回，RecordCount 之内的记录都是完整的。
+// 正常关闭时文件截断到实际长度。读取方可以在写入方运行时打开同一个文件，按 RecordCount 读取。
+// 记录是 CTP 结构体的原始内存布局，FieldSize 不一致（CTP 版本不同）的文件拒绝读取。
+
+#include "TickRecord.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TICK_FILE_MAGIC       0x4B434954505443ULL   /* "CTPTICK"（小端序） */
+#define TICK_FILE_VERSION     1
+#define TICK_FILE_HEADER_SIZE 4096
+
+struct TickFileHeader
+{
+    uint64_t Magic;                 // TICK_FILE_MAGIC
+    uint32_t Version;               // TICK_FILE_VERSION
+    uint32_t HeaderSize;            // TICK_FILE_HEADER_SIZE，记录从该偏移开始
+    uint32_t RecordSize;            // sizeof(TickRecord)
+    uint32_t FieldSize;             // sizeof(CThostFtdcDepthMarketDataField)
+    char TradingDay[16];            // 本段所属交易日
+    uint32_t SegmentIndex;          // 同一交易日内的分段序号
+    uint32_t Reserved;
+    int64_t CreateTimeNs;           // 创建时间（纪元纳秒）
+    uint64_t Capacity;              // 预分配的记录数
+
+    alignas(64) std::atomic<uint64_t> RecordCount;  // 已完整写入的记录数
+};
+
+static_assert(sizeof(TickFileHeader) <= TICK_FILE_HEADER_SIZE, "TickFileHeader too large");
+
+// 只读访问一个录制文件，可用于回放和离线分析
+class TickFileReader
+{
+public:
+    TickFileReader() : m_pBase(nullptr), m_nSize(0), m_pHeader(nullptr) {}
+    ~TickFileReader() { Close(); }
+
+    TickFileReader(const TickFileReader&) = delete;
+    TickFileReader& operator=(const TickFileReader&) = delete;
+
+    bool Open(const char* path) {
+        Close();
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < TICK_FILE_HEADER_SIZE) {
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+
+        const TickFileHeader* header = static_cast<const TickFileHeader*>(p);
+        if (header->Magic != TICK_FILE_MAGIC || header->Version != TICK_FILE_VERSION ||
+            header->HeaderSize != TICK_FILE_HEADER_SIZE || header->RecordSize != sizeof(TickRecord) ||
+            header->FieldSize != sizeof(CThostFtdcDepthMarketDataField)) {
+            munmap(p, st.st_size);
+            return false;
+        }
+        m_pBase = static_cast<const char*>(p);
+        m_nSize = st.st_size;
+        m_pHeader = header;
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void Close() {
+        if (m_pBase) munmap(const_cast<char*>(m_pBase), m_nSize);
+        m_pBase = nullptr;
+        m_pHeader = nullptr;
+    }
+
+    bool IsOpen() const { return m_pBase != nullptr; }
+    const TickFileHeader* Header() const { return m_pHeader; }
+
+    // 当前可读的记录数；写入方仍在运行时会增长，但不超过打开时映射的长度
+    uint64_t Count() const {
+        uint64_t count = m_pHeader->RecordCount.load(std::memory_order_acquire);
+        uint64_t mapped = (m_nSize - TICK_FILE_HEADER_SIZE) / sizeof(TickRecord);
+        return count < mapped ? count : mapped;
+    }
+
+    const TickRecord& Record(uint64_t i) const {
+        return reinterpret_cast<const TickRecord*>(m_pBase + TICK_FILE_HEADER_SIZE)[i];
+    }
+
+private:
+    const char* m_pBase;
+    size_t m_nSize;
+    const TickFileHeader* m_pHeader;
+};
+
+#endif // TICK_FILE_FORMAT_H
@@ -0,0 +1,402 @@
+#include "TickPipeline.h"
+#include "config.h"
+#include "Tsc.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+// 工作线程在进入休眠前空转轮询的次数
+static const int SPIN_BEFORE_SLEEP = 1000;
+
+// 工作线程空闲时单次休眠的最长时间
+static const int64_t MAX_SLEEP_NS = 100 * 1000000LL;
+
+static const char* const LATENCY_STAGE_NAMES[] = {"callback", "queue", "encode", "write", "sinks", "total"};
+
+TickPipeline::TickPipeline(size_t ringCapacity, const BatchWriter::Policy& outputPolicy, size_t laneCount)
+    : m_format(OutputFormat::Json), m_pRegistry(nullptr),
+      m_pLastValues(nullptr), m_pArbiter(nullptr), m_nSequence(0), m_nDefinedInstruments(0), m_writer(STDOUT_FILENO, outputPolicy),
+      m_nLastReportNs(MonotonicNanos()), m_lastOutputStats(m_writer.GetStats()),
+      m_bLatency(LATENCY_STATS), m_dTscNanos(1.0), m_nProcessed(0), m_nDuplicates(0), m_nInstrumentSlots(0),
+      m_bSleeping(false), m_bRunning(false) {
+    m_encoder.SetNullInvalidPrices(OUTPUT_NULL_INVALID_PRICE);
+    m_encoder.SetDepth(OUTPUT_DEPTH);
+    m_encoder.SetTickDeltas(OUTPUT_TICK_DELTAS);
+    m_binaryEncoder.SetDepth(OUTPUT_DEPTH);
+    m_binaryEncoder.SetTickDeltas(OUTPUT_TICK_DELTAS);
+    if (laneCount == 0) laneCount = 1;
+    for (size_t i = 0; i < laneCount; ++i) m_lanes.emplace_back(new Lane(i, ringCapacity));
+    if (m_bLatency) {
+        m_dTscNanos = TscNanosPerTick();
+        m_lastLatency.resize(STAGE_COUNT);
+        m_writer.SetLatencyHistograms(&m_latency[STAGE_WRITE], &m_latency[STAGE_TOTAL]);
+    }
+}
+
+TickPipeline::~TickPipeline() {
+    Stop();
+}
+
+void TickPipeline::Start() {
+    if (m_bRunning.exchange(true)) return;
+    if (m_pRegistry && !m_instrumentTicks) {
+        m_nInstrumentSlots = m_pRegistry->Capacity();
+        m_instrumentTicks.reset(new std::atomic<uint64_t>[m_nInstrumentSlots]);
+        for (uint32_t i = 0; i < m_nInstrumentSlots; ++i) m_instrumentTicks[i].store(0, std::memory_order_relaxed);
+    }
+    if (!m_pDeltas) m_pDeltas.reset(new TickDeltaTracker(m_pRegistry ? m_pRegistry->Capacity() : 0, m_lanes.size()));
+    m_worker = std::thread(&TickPipeline::Run, this);
+}
+
+void TickPipeline::Stop() {
+    if (!m_bRunning.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeCond.notify_one();
+    }
+    if (m_worker.joinable()) m_worker.join();
+    ReportStats();
+}
+
+void TickPipeline::Capture(const CThostFtdcDepthMarketDataField* pData, size_t lane) {
+    // MyMdSpi 收到行情后直接调用本函数，此处的时间戳即回调入口
+    uint64_t entryTsc = m_bLatency ? ReadTsc() : 0;
+    Lane& l = *m_lanes[lane];
+    CapturedTick* slot = l.Ring.BeginPush();
+    if (!slot) {
+        l.Dropped.store(l.Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    slot->Tick.RecvTimeNs = l.RecvTimeNs != 0 ? l.RecvTimeNs : WallClockNanos();
+    memcpy(&slot->Tick.Field, pData, sizeof(slot->Tick.Field));
+    slot->Epoch = l.Epoch;
+    slot->EntryTsc = entryTsc;
+    slot->EnqueueTsc = m_bLatency ? ReadTsc() : 0;
+    uint64_t enqueueTsc = slot->EnqueueTsc;     // 提交后槽位归消费者所有，不能再读
+    uint64_t occupancy = l.Ring.CommitPush();
+    if (m_bLatency) l.CallbackLatency.Record(TscElapsed(entryTsc, enqueueTsc));
+
+    l.Captured.store(l.Captured.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // CommitPush() 基于缓存的消费位置，结果偏大；只有可能刷新最大值时才读取真实占用量
+    if (occupancy > l.HighWaterMark.load(std::memory_order_relaxed)) {
+        occupancy = l.Ring.Size();
+        if (occupancy > l.HighWaterMark.load(std::memory_order_relaxed)) {
+            l.HighWaterMark.store(occupancy, std::memory_order_relaxed);
+        }
+    }
+
+    // 与 Run() 中的休眠判断配合：CommitPush() 只是 release 写入，其后的读取可能被提前到写入之前，
+    // 两侧各用一个 seq_cst 栅栏分隔“写入队列/读取休眠标志”与“写入休眠标志/复查队列”，保证不会丢失唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_bSleeping.load()) {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeCond.notify_one();
+    }
+}
+
+void TickPipeline::MarkDisconnected(size_t lane) {
+    ++m_lanes[lane]->Epoch;
+}
+
+TickPipeline::Stats TickPipeline::GetStats() const {
+    Stats stats = GetLaneStats(0);
+    for (size_t i = 1; i < m_lanes.size(); ++i) {
+        Stats lane = GetLaneStats(i);
+        stats.Captured += lane.Captured;
+        stats.Dropped += lane.Dropped;
+        if (lane.HighWaterMark > stats.HighWaterMark) stats.HighWaterMark = lane.HighWaterMark;
+    }
+    stats.Processed = m_nProcessed.load(std::memory_order_relaxed);
+    stats.Duplicates = m_nDuplicates.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Processed 和 Duplicates 只对整条流水线统计，按队列取时为 0
+TickPipeline::Stats TickPipeline::GetLaneStats(size_t lane) const {
+    const Lane& l = *m_lanes[lane];
+    Stats stats;
+    stats.Captured = l.Captured.load(std::memory_order_relaxed);
+    stats.Dropped = l.Dropped.load(std::memory_order_relaxed);
+    stats.Processed = 0;
+    stats.Duplicates = 0;
+    stats.HighWaterMark = l.HighWaterMark.load(std::memory_order_relaxed);
+    stats.Capacity = l.Ring.Capacity();
+    return stats;
+}
+
+// 队首接收时间最早的非空队列，全部为空时返回 nullptr
+TickPipeline::Lane* TickPipeline::NextLane() {
+    if (m_lanes.size() == 1) return m_lanes[0]->Ring.Front() ? m_lanes[0].get() : nullptr;
+    Lane* next = nullptr;
+    int64_t earliest = 0;
+    for (size_t i = 0; i < m_lanes.size(); ++i) {
+        CapturedTick* captured = m_lanes[i]->Ring.Front();
+        if (captured && (!next || captured->Tick.RecvTimeNs < earliest)) {
+            next = m_lanes[i].get();
+            earliest = captured->Tick.RecvTimeNs;
+        }
+    }
+    return next;
+}
+
+void TickPipeline::Run() {
+    if (m_format == OutputFormat::Binary) WriteBinaryPreamble();
+
+    int idleSpins = 0;
+    int64_t nextReport = MonotonicNanos() + STATS_INTERVAL_SEC * 1000000000LL;
+
+    while (true) {
+        Lane* lane = NextLane();
+        if (lane) {
+            Process(*lane->Ring.Front(), lane->Index);
+            lane->Ring.Pop();
+            m_nProcessed.store(m_nProcessed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            idleSpins = 0;
+            continue;
+        }
+
+        // 队列已空：收到停止请求后写出剩余数据并退出（此时生产者已不再写入）
+        if (!m_bRunning.load()) break;
+
+        if (idleSpins == 0) {
+            m_writer.OnIdle();
+            for (size_t i = 0; i < m_sinks.size(); ++i) m_sinks[i]->OnIdle();
+        }
+        int64_t now = MonotonicNanos();
+        m_writer.Poll(now);
+
+        if (STATS_INTERVAL_SEC > 0 && now >= nextReport) {
+            ReportStats();
+            nextReport += STATS_INTERVAL_SEC * 1000000000LL;
+        }
+
+        if (++idleSpins < SPIN_BEFORE_SLEEP) continue;
+
+        // 有暂存数据时，休眠时间不超过批量写出的延迟上限
+        int64_t sleepNs = m_writer.NanosUntilDeadline(now);
+        if (sleepNs < 0 || sleepNs > MAX_SLEEP_NS) sleepNs = MAX_SLEEP_NS;
+
+        // 先声明休眠再复查队列，避免与生产者的唤醒发生竞争
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_bSleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!NextLane() && m_bRunning.load()) {
+            m_wakeCond.wait_for(lock, std::chrono::nanoseconds(sleepNs));
+        }
+        m_bSleeping.store(false);
+        idleSpins = 0;
+    }
+
+    m_writer.Flush();
+    for (size_t i = 0; i < m_sinks.size(); ++i) m_sinks[i]->OnStop();
+}
+
+void TickPipeline::Process(const CapturedTick& captured, size_t lane) {
+    const TickRecord& tick = captured.Tick;
+    uint64_t dequeueTsc = 0;
+    if (m_bLatency) {
+        dequeueTsc = ReadTsc();
+        m_latency[STAGE_QUEUE].Record(TscElapsed(captured.EnqueueTsc, dequeueTsc));
+    }
+
+    uint32_t index = m_pRegistry ? m_pRegistry->Find(tick.Field.InstrumentID, sizeof(tick.Field.InstrumentID))
+                                 : InstrumentRegistry::INVALID_INDEX;
+    if (index < m_nInstrumentSlots) {
+        std::atomic<uint64_t>& count = m_instrumentTicks[index];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    m_pDeltas->Observe(lane, captured.Epoch);
+    if (m_pArbiter && !m_pArbiter->Accept(index, lane, tick)) {
+        m_nDuplicates.store(m_nDuplicates.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    // 只对放行的行情计算增量，冗余前置的副本不会改变基准
+    TickDelta delta;
+    m_pDeltas->Compute(index, lane, captured.Epoch, tick.Field, delta);
+    uint64_t sequence = ++m_nSequence;
+    TickContext ctx(tick, index, sequence, delta, m_encoder);
+
+    // 先更新缓存再分发：输出端看到序号为 N 的行情时，缓存中已包含 N 及之前的全部行情
+    if (m_pLastValues && index != InstrumentRegistry::INVALID_INDEX) {
+        m_pLastValues->Update(index, sequence, tick);
+    }
+
+    // 帧带上入口和编码完成的时间戳，由 BatchWriter 在写出后记入 write 和 total 阶段
+    if (m_format == OutputFormat::Binary) {
+        // 运行中新增的合约在其第一条行情之前补发定义
+        if (index != InstrumentRegistry::INVALID_INDEX && index >= m_nDefinedInstruments) WriteInstrumentDefs();
+        size_t len = m_binaryEncoder.EncodeTick(tick, index, &delta);
+        uint64_t encodedTsc = m_bLatency ? ReadTsc() : 0;
+        if (m_bLatency) m_latency[STAGE_ENCODE].Record(TscElapsed(dequeueTsc, encodedTsc));
+        m_writer.Append(m_binaryEncoder.Data(), len, captured.EntryTsc, encodedTsc);
+    } else if (m_format == OutputFormat::Json) {
+        size_t len = 0;
+        const char* frame = ctx.JsonFrame(len);
+        uint64_t encodedTsc = m_bLatency ? ReadTsc() : 0;
+        if (m_bLatency) m_latency[STAGE_ENCODE].Record(TscElapsed(dequeueTsc, encodedTsc));
+        m_writer.Append(frame, len, captured.EntryTsc, encodedTsc);
+    }
+
+    bool timeSinks = m_bLatency && (!m_sinks.empty() || m_format == OutputFormat::None);
+    uint64_t sinksTsc = timeSinks ? ReadTsc() : 0;
+    for (size_t i = 0; i < m_sinks.size(); ++i) m_sinks[i]->OnTick(ctx);
+    if (timeSinks) {
+        uint64_t doneTsc = ReadTsc();
+        if (!m_sinks.empty()) m_latency[STAGE_SINKS].Record(TscElapsed(sinksTsc, doneTsc));
+        if (m_format == OutputFormat::None) m_latency[STAGE_TOTAL].Record(TscElapsed(captured.EntryTsc, doneTsc));
+    }
+}
+
+// 二进制流开头：流头和全部合约定义
+void TickPipeline::WriteBinaryPreamble() {
+    size_t len = m_binaryEncoder.EncodeStreamHeader();
+    m_writer.Append(m_binaryEncoder.Data(), len);
+    WriteInstrumentDefs();
+    m_writer.Flush();
+}
+
+// 输出尚未定义过的合约
+void TickPipeline::WriteInstrumentDefs() {
+    if (!m_pRegistry) return;
+    uint32_t size = m_pRegistry->Size();
+    for (; m_nDefinedInstruments < size; ++m_nDefinedInstruments) {
+        size_t len = m_binaryEncoder.EncodeInstrumentDef(m_nDefinedInstruments,
+                                                         m_pRegistry->Name(m_nDefinedInstruments).c_str());
+        m_writer.Append(m_binaryEncoder.Data(), len);
+    }
+}
+
+void TickPipeline::ReportStats() {
+    Stats stats = GetStats();
+    std::cerr << "=== TickPipeline: captured=" << stats.Captured
+              << ", processed=" << stats.Processed
+              << ", dropped=" << stats.Dropped
+              << ", duplicates=" << stats.Duplicates
+              << ", high_water_mark=" << stats.HighWaterMark << "/" << stats.Capacity
+              << " ===" << std::endl;
+    for (size_t i = 0; m_lanes.size() > 1 && i < m_lanes.size(); ++i) {
+        Stats lane = GetLaneStats(i);
+        std::cerr << "    lane " << i << ": captured=" << lane.Captured
+                  << ", dropped=" << lane.Dropped
+                  << ", high_water_mark=" << lane.HighWaterMark << "/" << lane.Capacity << std::endl;
+    }
+
+    // 输出速率按两次统计之间的增量计算
+    int64_t now = MonotonicNanos();
+    BatchWriter::Stats output = m_writer.GetStats();
+    uint64_t syscalls = output.Syscalls - m_lastOutputStats.Syscalls;
+    uint64_t frames = output.Frames - m_lastOutputStats.Frames;
+    double seconds = (now - m_nLastReportNs) / 1e9;
+    std::cerr << "=== BatchWriter: syscalls=" << output.Syscalls
+              << ", frames=" << output.Frames
+              << ", bytes=" << output.Bytes
+              << ", errors=" << output.Errors
+              << ", syscalls_per_sec=" << (seconds > 0 ? syscalls / seconds : 0.0)
+              << ", frames_per_syscall=" << (syscalls > 0 ? static_cast<double>(frames) / syscalls : 0.0)
+              << " ===" << std::endl;
+    m_lastOutputStats = output;
+    m_nLastReportNs = now;
+
+    if (m_bLatency) ReportLatency();
+    if (m_pDeltas) m_pDeltas->ReportStats();
+    if (m_pArbiter) m_pArbiter->ReportStats();
+    for (size_t i = 0; i < m_sinks.size(); ++i) m_sinks[i]->ReportStats();
+}
+
+// 各阶段的累计快照，callback 阶段为各队列之和
+void TickPipeline::ReadLatency(std::vector<LatencyHistogram::Snapshot>& stages) const {
+    stages.resize(STAGE_COUNT);
+    LatencyHistogram::Snapshot lane;
+    for (size_t i = 0; i < m_lanes.size(); ++i) {
+        m_lanes[i]->CallbackLatency.Read(i == 0 ? stages[STAGE_CALLBACK] : lane);
+        if (i > 0) stages[STAGE_CALLBACK].Add(lane);
+    }
+    for (int stage = STAGE_QUEUE; stage < STAGE_COUNT; ++stage) m_latency[stage].Read(stages[stage]);
+}
+
+// 输出两次统计之间的延迟分布，没有行情的阶段不输出
+void TickPipeline::ReportLatency() {
+    std::vector<LatencyHistogram::Snapshot> stages;
+    ReadLatency(stages);
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        LatencyHistogram::Snapshot interval = stages[stage];
+        interval.Subtract(m_lastLatency[stage]);
+        if (interval.Count == 0) continue;
+        std::cerr << "=== Latency: stage=" << LATENCY_STAGE_NAMES[stage] << ", "
+                  << interval.Describe(m_dTscNanos) << " ===" << std::endl;
+    }
+    m_lastLatency.swap(stages);
+}
+
+std::string TickPipeline::DescribeLatency() const {
+    if (!m_bLatency) return std::string();
+    std::vector<LatencyHistogram::Snapshot> stages;
+    ReadLatency(stages);
+    std::ostringstream out;
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        out << "stage=" << LATENCY_STAGE_NAMES[stage] << ", " << stages[stage].Describe(m_dTscNanos) << "\n";
+    }
+    return out.str();
+}
+
+// 只读取各线程各自的计数器，不与行情路径共享任何写入位置
+void TickPipeline::WriteMetrics(MetricsWriter& out) const {
+    std::vector<std::string> lanes;
+    for (size_t i = 0; i < m_lanes.size(); ++i) lanes.push_back(MetricsWriter::Label("lane", std::to_string(i)));
+
+    out.Family("ctp_md_ticks_captured_total", "counter", "Ticks copied into the pipeline queue");
+    for (size_t i = 0; i < m_lanes.size(); ++i) out.Sample(lanes[i], m_lanes[i]->Captured.load(std::memory_order_relaxed));
+    out.Family("ctp_md_ticks_dropped_total", "counter", "Ticks dropped because the pipeline queue was full");
+    for (size_t i = 0; i < m_lanes.size(); ++i) out.Sample(lanes[i], m_lanes[i]->Dropped.load(std::memory_order_relaxed));
+    out.Family("ctp_md_queue_depth", "gauge", "Ticks waiting in the pipeline queue");
+    for (size_t i = 0; i < m_lanes.size(); ++i) out.Sample(lanes[i], static_cast<uint64_t>(m_lanes[i]->Ring.Size()));
+    out.Family("ctp_md_queue_high_water_mark", "gauge", "Highest pipeline queue depth seen");
+    for (size_t i = 0; i < m_lanes.size(); ++i) {
+        out.Sample(lanes[i], m_lanes[i]->HighWaterMark.load(std::memory_order_relaxed));
+    }
+    out.Family("ctp_md_queue_capacity", "gauge", "Pipeline queue capacity");
+    out.Sample("", static_cast<uint64_t>(m_lanes[0]->Ring.Capacity()));
+
+    out.Family("ctp_md_ticks_processed_total", "counter", "Ticks taken off the queues by the worker thread");
+    out.Sample("", m_nProcessed.load(std::memory_order_relaxed));
+    out.Family("ctp_md_ticks_duplicate_total", "counter", "Redundant-front copies discarded by arbitration");
+    out.Sample("", m_nDuplicates.load(std::memory_order_relaxed));
+    if (m_pDeltas) {
+        out.Family("ctp_md_tick_deltas_total", "counter", "Dispatched ticks by volume delta kind");
+        for (int kind = 0; kind < TickDelta::KIND_COUNT; ++kind) {
+            TickDelta::Kind k = static_cast<TickDelta::Kind>(kind);
+            out.Sample(MetricsWriter::Label("kind", TickDelta::KindName(k)), m_pDeltas->Count(k));
+        }
+    }
+
+    // 没有收到过行情的合约不输出
+    out.Family("ctp_md_instrument_ticks_total", "counter", "Ticks received per instrument");
+    uint32_t registered = m_pRegistry ? m_pRegistry->Size() : 0;
+    for (uint32_t i = 0; i < m_nInstrumentSlots && i < registered; ++i) {
+        uint64_t count = m_instrumentTicks[i].load(std::memory_order_relaxed);
+        if (count != 0) out.Sample(MetricsWriter::Label("instrument", m_pRegistry->Name(i)), count);
+    }
+
+    BatchWriter::Stats output = m_writer.GetStats();
+    out.Family("ctp_md_sink_bytes_total", "counter", "Bytes emitted per output sink");
+    if (m_format != OutputFormat::None) out.Sample(MetricsWriter::Label("sink", "stdout"), output.Bytes);
+    for (size_t i = 0; i < m_sinks.size(); ++i) {
+        out.Sample(MetricsWriter::Label("sink", m_sinks[i]->Name()), m_sinks[i]->BytesOut());
+    }
+    out.Family("ctp_md_stdout_frames_total", "counter", "Frames written to stdout");
+    out.Sample("", output.Frames);
+    out.Family("ctp_md_stdout_syscalls_total", "counter", "writev calls on stdout");
+    out.Sample("", output.Syscalls);
+    out.Family("ctp_md_stdout_errors_total", "counter", "Failed stdout batches");
+    out.Sample("", output.Errors);
+
+    if (!m_bLatency) return;
+    std::vector<LatencyHistogram::Snapshot> stages;
+    ReadLatency(stages);
+    out.Family("ctp_md_latency_seconds", "histogram", "Per-stage tick latency measured with the TSC");
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        out.Histogram(MetricsWriter::Label("stage", LATENCY_STAGE_NAMES[stage]), stages[stage], m_dTscNanos);
+    }
+}
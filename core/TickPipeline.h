@@ -0,0 +1,193 @@
+#ifndef TICK_PIPELINE_H
+#define TICK_PIPELINE_H
+
+#include "TickRecord.h"
+#include "SpscRing.h"
+#include "MdJsonEncoder.h"
+#include "MdBinaryEncoder.h"
+#include "BatchWriter.h"
+#include "InstrumentRegistry.h"
+#include "TickSink.h"
+#include "LastValueCache.h"
+#include "FrontArbiter.h"
+#include "TickDeltaTracker.h"
+#include "LatencyHistogram.h"
+#include "MetricsWriter.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 标准输出的行情格式
+enum class OutputFormat
+{
+    Json,       // SSE 帧包装的 JSON 文本（默认）
+    Binary,     // 定长二进制记录，见 MdBinaryFormat.h
+    None        // 不输出到标准输出（只使用其他输出端）
+};
+
+// 行情处理流水线
+// CTP 回调线程只调用 Capture()，把原始行情拷贝进预分配的 SPSC 环形队列；
+// 编码和输出全部由独立的工作线程完成，下游管道的阻塞不会拖慢 CTP 的接收线程。
+// 多会话时每个回调线程写入各自的队列（lane），工作线程每次取各队列队首中接收时间最早的一条，
+// 合并为一路输出；同一合约只经过一个队列，先后顺序不变。
+// 工作线程在分发前计算每条行情相对同一合约上一条行情的增量（TickDeltaTracker），经 TickContext::Delta() 提供给各输出端。
+//
+// 启用延迟统计（LATENCY_STATS）时，每条行情在以下各点读取一次 TSC，相邻两点之差记入对应阶段的直方图：
+//   callback  进入 Capture() -> 入队完成（CTP 回调线程，每个队列一个直方图）
+//   queue     入队完成 -> 工作线程取出
+//   encode    取出 -> 编码完成（含仲裁和最新值缓存）
+//   write     编码完成 -> 所在批次 writev 完成（含批量暂存的等待）
+//   sinks     其他输出端的 OnTick() 耗时合计
+//   total     进入 Capture() -> 写出到标准输出（不输出到标准输出时为各输出端处理完成）
+// 每个直方图只有一个写入线程，统计间隔到达时输出区间分布，也可随时通过 DescribeLatency() 读取累计分布。
+class TickPipeline
+{
+public:
+    // 流水线统计，各计数器只有一个写入线程，可在任意线程读取
+    struct Stats
+    {
+        uint64_t Captured;       // 成功写入队列的行情数
+        uint64_t Dropped;        // 队列满时丢弃的行情数
+        uint64_t Processed;      // 工作线程已处理的行情数
+        uint64_t Duplicates;     // 冗余前置仲裁丢弃的副本数
+        uint64_t HighWaterMark;  // 队列占用量的历史最大值（多个队列时取最大者）
+        uint64_t Capacity;       // 单个队列的容量
+    };
+
+    // laneCount 为生产者（CTP 回调线程）数，每个生产者一个容量为 ringCapacity 的队列
+    TickPipeline(size_t ringCapacity, const BatchWriter::Policy& outputPolicy, size_t laneCount = 1);
+    ~TickPipeline();
+
+    // 以下设置须在 Start() 之前调用
+    void SetOutputFormat(OutputFormat format) { m_format = format; }
+    void SetRegistry(const InstrumentRegistry* pRegistry) { m_pRegistry = pRegistry; }
+
+    // 每条已注册合约的行情在交给各输出端之前写入最新值缓存
+    void SetLastValueCache(LastValueCache* pCache) { m_pLastValues = pCache; }
+
+    // 冗余前置：各队列的行情先经仲裁，只有最先到达的一份进入缓存和各输出端
+    void SetFrontArbiter(FrontArbiter* pArbiter) { m_pArbiter = pArbiter; }
+
+    // 添加额外的输出端（标准输出之外），按添加顺序依次调用
+    void AddSink(TickSink* pSink) { m_sinks.push_back(pSink); }
+
+    // 启动工作线程
+    void Start();
+
+    // 处理完队列中剩余的行情后停止工作线程
+    void Stop();
+
+    // 由 CTP 回调线程调用：只做拷贝和入队，队列满时丢弃并计数；每个 lane 只能有一个调用线程
+    void Capture(const CThostFtdcDepthMarketDataField* pData, size_t lane = 0);
+
+    // 由 CTP 回调线程在 OnFrontDisconnected 中调用（与 Capture() 同一线程）：
+    // 此后入队的行情属于新的连接，重连后各合约的第一条行情增量标记为 KIND_GAP
+    void MarkDisconnected(size_t lane = 0);
+
+    // 回放时由调用 Capture() 的线程在每条行情之前调用：此后入队的行情以录制时的接收时间代替当前时间，
+    // K 线日期等依赖接收时间的结果与录制时一致；0 表示恢复使用当前时间
+    void SetRecvTime(int64_t recvTimeNs, size_t lane = 0) { m_lanes[lane]->RecvTimeNs = recvTimeNs; }
+
+    Stats GetStats() const;
+    Stats GetLaneStats(size_t lane) const;
+    size_t LaneCount() const { return m_lanes.size(); }
+    BatchWriter::Stats GetOutputStats() const { return m_writer.GetStats(); }
+
+    // 各阶段自启动以来的延迟分布，每个阶段一行 "stage=NAME, count=..., p50_us=..."；未启用时返回空串
+    std::string DescribeLatency() const;
+
+    // 队列、各输出端、逐合约行情数和延迟分布的 Prometheus 指标，可在任意线程调用（Start() 之后）
+    void WriteMetrics(MetricsWriter& out) const;
+
+private:
+    // 延迟统计的阶段，callback 阶段的直方图在各队列中
+    enum LatencyStage
+    {
+        STAGE_CALLBACK,
+        STAGE_QUEUE,
+        STAGE_ENCODE,
+        STAGE_WRITE,
+        STAGE_SINKS,
+        STAGE_TOTAL,
+        STAGE_COUNT
+    };
+
+    // 队列中的一条行情：原始行情、所在连接的纪元和回调线程中的两个 TSC 时间戳（未启用延迟统计时为 0）
+    struct CapturedTick
+    {
+        TickRecord Tick;
+        uint32_t Epoch;         // 入队时队列的断线次数
+        uint64_t EntryTsc;      // 进入 Capture()
+        uint64_t EnqueueTsc;    // 入队完成
+    };
+
+    // 一个生产者的队列和计数器，各自独占缓存行
+    struct Lane
+    {
+        Lane(size_t index, size_t capacity)
+            : Index(index), Ring(capacity), Captured(0), Dropped(0), HighWaterMark(0), Epoch(0), RecvTimeNs(0) {}
+
+        size_t Index;
+        SpscRing<CapturedTick> Ring;
+        alignas(64) std::atomic<uint64_t> Captured;
+        std::atomic<uint64_t> Dropped;
+        std::atomic<uint64_t> HighWaterMark;
+        uint32_t Epoch;                         // 断线次数，只由该队列的生产者访问
+        int64_t RecvTimeNs;                     // 非 0 时作为接收时间（回放），只由该队列的生产者访问
+        LatencyHistogram CallbackLatency;       // 只由该队列的生产者写入
+    };
+
+    Lane* NextLane();
+    void Run();
+    void Process(const CapturedTick& captured, size_t lane);
+    void WriteBinaryPreamble();
+    void WriteInstrumentDefs();
+    void ReportStats();
+    void ReadLatency(std::vector<LatencyHistogram::Snapshot>& stages) const;
+    void ReportLatency();
+
+    std::vector<std::unique_ptr<Lane>> m_lanes;
+    OutputFormat m_format;
+    const InstrumentRegistry* m_pRegistry;
+    LastValueCache* m_pLastValues;
+    FrontArbiter* m_pArbiter;
+    std::unique_ptr<TickDeltaTracker> m_pDeltas;   // Start() 时按注册表容量创建，仅在工作线程中使用
+    uint64_t m_nSequence;           // 已分发的行情数，即最近一条行情的序号
+    MdJsonEncoder m_encoder;        // 仅在工作线程中使用
+    MdBinaryEncoder m_binaryEncoder;
+    uint32_t m_nDefinedInstruments; // 二进制流中已输出定义的合约数
+    std::vector<TickSink*> m_sinks;
+    BatchWriter m_writer;           // 标准输出的批量写出器，仅在工作线程中使用
+
+    // 上一次输出统计时的快照，用于计算速率
+    int64_t m_nLastReportNs;
+    BatchWriter::Stats m_lastOutputStats;
+
+    // 延迟统计，除 callback 外的直方图只由工作线程写入
+    bool m_bLatency;
+    double m_dTscNanos;                         // 每个 TSC 周期的纳秒数
+    LatencyHistogram m_latency[STAGE_COUNT];   // 下标为 LatencyStage，STAGE_CALLBACK 不使用
+    std::vector<LatencyHistogram::Snapshot> m_lastLatency;     // 上一次输出时的快照
+
+    // 消费者侧计数器
+    alignas(64) std::atomic<uint64_t> m_nProcessed;
+    std::atomic<uint64_t> m_nDuplicates;
+    // 合约编号 -> 收到的行情数（含冗余前置的副本），Start() 时按注册表容量分配，只由工作线程写入
+    std::unique_ptr<std::atomic<uint64_t>[]> m_instrumentTicks;
+    uint32_t m_nInstrumentSlots;
+
+    // 工作线程空闲时在条件变量上休眠，生产者仅在其休眠时才去唤醒
+    alignas(64) std::atomic<bool> m_bSleeping;
+    std::atomic<bool> m_bRunning;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCond;
+    std::thread m_worker;
+};
+
+#endif // TICK_PIPELINE_H
@@ -0,0 +1,68 @@
+#ifndef TICK_RECORD_H
+#define TICK_RECORD_H
+
+#include <ThostFtdcUserApiStruct.h>
+
+#include <cstdint>
+#include <time.h>
+
+// 捕获的一条原始行情：CTP 行情结构体的完整拷贝加上本地接收时间
+struct TickRecord
+{
+    int64_t RecvTimeNs;                     // 本地接收时间（CLOCK_REALTIME，纳秒）
+    CThostFtdcDepthMarketDataField Field;   // 原始行情
+};
+
+// 当前墙上时间（纳秒），走 vDSO，不产生系统调用
+inline int64_t WallClockNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// 单调时钟（纳秒），用于计算时间间隔
+inline int64_t MonotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// 将 TradingDay（YYYYMMDD）解析为整数 20240102，可直接比较先后；格式不合法时返回 0
+inline uint32_t ParseTradingDay(const char* day) {
+    uint32_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (day[i] < '0' || day[i] > '9') return 0;
+        value = value * 10 + (day[i] - '0');
+    }
+    return value;
+}
+
+// 由 ActionDay（YYYYMMDD）、UpdateTime（HH:MM:SS）和 UpdateMillisec 计算交易所时间，
+// 按北京时间（UTC+8）换算为 UTC 纪元纳秒；ActionDay 为空时退回使用 TradingDay，
+// 日期格式不合法时返回 0
+inline int64_t ExchangeTimeNanos(const CThostFtdcDepthMarketDataField& field) {
+    const char* day = field.ActionDay[0] ? field.ActionDay : field.TradingDay;
+    const char* t = field.UpdateTime;
+    for (int i = 0; i < 8; ++i) {
+        if (day[i] < '0' || day[i] > '9') return 0;
+    }
+    int y = (day[0] - '0') * 1000 + (day[1] - '0') * 100 + (day[2] - '0') * 10 + (day[3] - '0');
+    int m = (day[4] - '0') * 10 + (day[5] - '0');
+    int d = (day[6] - '0') * 10 + (day[7] - '0');
+    int hh = (t[0] - '0') * 10 + (t[1] - '0');
+    int mm = (t[3] - '0') * 10 + (t[4] - '0');
+    int ss = (t[6] - '0') * 10 + (t[7] - '0');
+
+    // 公历日期 -> 纪元天数（Howard Hinnant 的 days_from_civil）
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = static_cast<int64_t>(era) * 146097 + doe - 719468;
+
+    int64_t seconds = days * 86400 + hh * 3600 + mm * 60 + ss - 8 * 3600;
+    return (seconds * 1000 + field.UpdateMillisec) * 1000000LL;
+}
+
+#endif // TICK_RECORD_H
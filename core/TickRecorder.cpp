@@ -0,0 +1,169 @@
+#include "TickRecorder.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+// 空闲时预先触碰的范围（写入位置之后）
+static const size_t PREFAULT_BYTES = 8 * 1024 * 1024;
+static const size_t PAGE_BYTES = 4096;
+
+TickRecorder::TickRecorder()
+    : m_nSegmentBytes(0), m_nSegmentIndex(0), m_bFailed(false), m_pBase(nullptr), m_nMapped(0),
+      m_pHeader(nullptr), m_pRecords(nullptr), m_nCount(0), m_nCapacity(0), m_nPrefaulted(0),
+      m_nTicks(0), m_nBytes(0), m_nSegments(0), m_nFailedTicks(0) {}
+
+TickRecorder::~TickRecorder() {
+    Close();
+}
+
+bool TickRecorder::Open(const char* dir, uint64_t segmentBytes) {
+    Close();
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        std::cerr << "mkdir " << dir << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        std::cerr << "Record directory " << dir << " is not a directory" << std::endl;
+        return false;
+    }
+    m_dir = dir;
+    if (!m_dir.empty() && m_dir.back() == '/') m_dir.pop_back();
+    // 至少容纳一条记录
+    m_nSegmentBytes = std::max<uint64_t>(segmentBytes, TICK_FILE_HEADER_SIZE + sizeof(TickRecord));
+    std::cerr << "Recording ticks to " << dir << " in segments of " << m_nSegmentBytes << " bytes" << std::endl;
+    return true;
+}
+
+void TickRecorder::Close() {
+    CloseSegment();
+    m_dir.clear();
+}
+
+// 新建 <dir>/<TradingDay>-<NNN>.ticks，已存在的段（如进程重启前写的）不覆盖
+bool TickRecorder::OpenSegment(const char* tradingDay) {
+    if (m_tradingDay != tradingDay) {
+        m_tradingDay = tradingDay;
+        m_nSegmentIndex = 0;
+    }
+
+    int fd = -1;
+    char path[4096];
+    for (; fd < 0; ++m_nSegmentIndex) {
+        snprintf(path, sizeof(path), "%s/%s-%03u.ticks", m_dir.c_str(), tradingDay, m_nSegmentIndex);
+        fd = ::open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0 && errno != EEXIST) {
+            std::cerr << "open " << path << " failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    // 预分配磁盘空间：映射写入时空间不足会触发 SIGBUS，必须在这里失败
+    int ret = posix_fallocate(fd, 0, m_nSegmentBytes);
+    if (ret != 0) {
+        std::cerr << "posix_fallocate " << path << " failed: " << strerror(ret) << std::endl;
+        ::close(fd);
+        unlink(path);
+        return false;
+    }
+    void* p = mmap(nullptr, m_nSegmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::cerr << "mmap " << path << " failed: " << strerror(errno) << std::endl;
+        unlink(path);
+        return false;
+    }
+
+    m_path = path;
+    m_pBase = static_cast<char*>(p);
+    m_nMapped = m_nSegmentBytes;
+    m_pHeader = new (m_pBase) TickFileHeader();
+    m_pRecords = reinterpret_cast<TickRecord*>(m_pBase + TICK_FILE_HEADER_SIZE);
+    m_nCount = 0;
+    m_nCapacity = (m_nSegmentBytes - TICK_FILE_HEADER_SIZE) / sizeof(TickRecord);
+    m_nPrefaulted = TICK_FILE_HEADER_SIZE;
+
+    m_pHeader->Magic = TICK_FILE_MAGIC;
+    m_pHeader->Version = TICK_FILE_VERSION;
+    m_pHeader->HeaderSize = TICK_FILE_HEADER_SIZE;
+    m_pHeader->RecordSize = sizeof(TickRecord);
+    m_pHeader->FieldSize = sizeof(CThostFtdcDepthMarketDataField);
+    strncpy(m_pHeader->TradingDay, tradingDay, sizeof(m_pHeader->TradingDay) - 1);
+    m_pHeader->SegmentIndex = m_nSegmentIndex - 1;
+    m_pHeader->CreateTimeNs = WallClockNanos();
+    m_pHeader->Capacity = m_nCapacity;
+    m_pHeader->RecordCount.store(0, std::memory_order_release);
+
+    m_nSegments.store(m_nSegments.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::cerr << "Recording segment " << m_path << " opened, capacity " << m_nCapacity << " ticks" << std::endl;
+    OnIdle();
+    return true;
+}
+
+// 截断到实际长度，释放未用完的预分配空间
+void TickRecorder::CloseSegment() {
+    if (!m_pBase) return;
+    uint64_t count = m_nCount;
+    munmap(m_pBase, m_nMapped);
+    m_pBase = nullptr;
+    m_pHeader = nullptr;
+    m_pRecords = nullptr;
+    if (truncate(m_path.c_str(), TICK_FILE_HEADER_SIZE + count * sizeof(TickRecord)) != 0) {
+        std::cerr << "truncate " << m_path << " failed: " << strerror(errno) << std::endl;
+    }
+    std::cerr << "Recording segment " << m_path << " closed, " << count << " ticks" << std::endl;
+}
+
+void TickRecorder::OnTick(TickContext& ctx) {
+    if (m_dir.empty()) return;
+    const TickRecord& tick = ctx.Tick();
+
+    // 交易日前进或当前段写满时换段。落后的前置、旧快照和夜盘各交易所的差异会使交易日来回交替，
+    // 交易日早于当前段的行情写入当前段，避免反复换段（每次换段都要预分配整段文件）；
+    // 行情未带交易日时沿用当前段
+    const char* day = tick.Field.TradingDay[0] ? tick.Field.TradingDay
+                                               : (m_tradingDay.empty() ? "00000000" : m_tradingDay.c_str());
+    bool newDay = m_tradingDay.empty() || strncmp(day, m_tradingDay.c_str(), sizeof(tick.Field.TradingDay)) > 0;
+    if (newDay || (m_pBase && m_nCount == m_nCapacity)) {
+        CloseSegment();
+        m_bFailed = false;
+    }
+    if (!m_pBase && (m_bFailed || !OpenSegment(newDay ? day : m_tradingDay.c_str()))) {
+        m_bFailed = true;
+        m_nFailedTicks.store(m_nFailedTicks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    memcpy(&m_pRecords[m_nCount], &tick, sizeof(TickRecord));
+    m_pHeader->RecordCount.store(++m_nCount, std::memory_order_release);
+
+    m_nTicks.store(m_nTicks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_nBytes.store(m_nBytes.load(std::memory_order_relaxed) + sizeof(TickRecord), std::memory_order_relaxed);
+}
+
+// 写入一个零字节即可让内核分配并映射该页；这些位置尚未写入记录，本来就是零
+void TickRecorder::OnIdle() {
+    if (!m_pBase) return;
+    size_t writePos = TICK_FILE_HEADER_SIZE + m_nCount * sizeof(TickRecord);
+    size_t target = std::min(m_nMapped, writePos + PREFAULT_BYTES);
+    if (m_nPrefaulted < writePos) m_nPrefaulted = writePos & ~(PAGE_BYTES - 1);
+    for (; m_nPrefaulted < target; m_nPrefaulted += PAGE_BYTES) {
+        if (m_nPrefaulted >= writePos) reinterpret_cast<volatile char*>(m_pBase)[m_nPrefaulted] = 0;
+    }
+}
+
+void TickRecorder::OnStop() {
+    CloseSegment();
+}
+
+void TickRecorder::ReportStats() {
+    std::cerr << "=== TickRecorder: file=" << (m_pBase ? m_path : std::string("none"))
+              << ", ticks=" << m_nTicks.load(std::memory_order_relaxed)
+              << ", bytes=" << m_nBytes.load(std::memory_order_relaxed)
+              << ", segments=" << m_nSegments.load(std::memory_order_relaxed)
+              << ", failed=" << m_nFailedTicks.load(std::memory_order_relaxed)
+              << " ===" << std::endl;
+}
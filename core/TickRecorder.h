@@ -0,0 +1,60 @@
+#ifndef TICK_RECORDER_H
+#define TICK_RECORDER_H
+
+#include "TickSink.h"
+#include "TickFileFormat.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// 行情录制端，文件格式见 TickFileFormat.h
+// 作为流水线的输出端运行在工作线程中，每条行情只是一次内存拷贝，不产生系统调用；
+// 换段（交易日前进或当前段写满）时才创建和映射新文件。
+// 空闲时预先触碰写入位置之后的若干页，把缺页处理移出行情路径。
+class TickRecorder : public TickSink
+{
+public:
+    TickRecorder();
+    ~TickRecorder();
+
+    // 录制到 dir 目录，每段预分配 segmentBytes 字节；目录不存在时创建。失败时返回 false 并在 stderr 输出原因
+    bool Open(const char* dir, uint64_t segmentBytes);
+    void Close();
+
+    virtual void OnTick(TickContext& ctx) override;
+    virtual void OnIdle() override;
+    virtual void OnStop() override;
+    virtual void ReportStats() override;
+    virtual const char* Name() const override { return "recorder"; }
+    virtual uint64_t BytesOut() const override { return Bytes(); }
+
+    uint64_t Ticks() const { return m_nTicks.load(std::memory_order_relaxed); }
+    uint64_t Bytes() const { return m_nBytes.load(std::memory_order_relaxed); }
+
+private:
+    bool OpenSegment(const char* tradingDay);
+    void CloseSegment();
+
+    std::string m_dir;
+    uint64_t m_nSegmentBytes;
+    std::string m_tradingDay;       // 当前段的交易日
+    std::string m_path;             // 当前段的文件名
+    uint32_t m_nSegmentIndex;
+    bool m_bFailed;                 // 创建分段失败后不再重试，直到交易日变化
+
+    char* m_pBase;
+    size_t m_nMapped;
+    TickFileHeader* m_pHeader;
+    TickRecord* m_pRecords;
+    uint64_t m_nCount;              // 当前段的记录数
+    uint64_t m_nCapacity;
+    size_t m_nPrefaulted;           // 已预先触碰到的字节偏移
+
+    std::atomic<uint64_t> m_nTicks;
+    std::atomic<uint64_t> m_nBytes;
+    std::atomic<uint64_t> m_nSegments;
+    std::atomic<uint64_t> m_nFailedTicks;
+};
+
+#endif // TICK_RECORDER_H
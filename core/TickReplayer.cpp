@@ -0,0 +1,146 @@
+#include "TickReplayer.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <thread>
+#include <unordered_set>
+
+// 距计划时间超过该值时休眠，之后空转等待，兼顾精度与 CPU 占用
+static const int64_t SLEEP_THRESHOLD_NS = 2 * 1000000LL;
+
+static bool HasSuffix(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+bool TickReplayer::Open(const char* path) {
+    m_files.clear();
+    memset(&m_stats, 0, sizeof(m_stats));
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        std::cerr << "Replay: cannot access " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        DIR* dir = opendir(path);
+        if (!dir) {
+            std::cerr << "Replay: cannot open directory " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        std::string prefix = path;
+        if (prefix.back() != '/') prefix += '/';
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (HasSuffix(name, ".ticks")) m_files.push_back(prefix + name);
+        }
+        closedir(dir);
+        // <TradingDay>-<NNN>.ticks 按文件名排序即按时间排序
+        std::sort(m_files.begin(), m_files.end());
+    } else {
+        m_files.push_back(path);
+    }
+
+    // 提前检查全部文件，避免回放到中途才发现格式不符
+    for (size_t i = 0; i < m_files.size(); ++i) {
+        TickFileReader reader;
+        if (!reader.Open(m_files[i].c_str())) {
+            std::cerr << "Replay: " << m_files[i] << " is not a tick file recorded by this build" << std::endl;
+            return false;
+        }
+    }
+    if (m_files.empty()) {
+        std::cerr << "Replay: no .ticks files in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void TickReplayer::CollectInstruments(std::vector<std::string>& ids) const {
+    std::unordered_set<std::string> seen;
+    for (size_t i = 0; i < m_files.size(); ++i) {
+        TickFileReader reader;
+        if (!reader.Open(m_files[i].c_str())) continue;
+        uint64_t count = reader.Count();
+        for (uint64_t j = 0; j < count; ++j) {
+            const CThostFtdcDepthMarketDataField& field = reader.Record(j).Field;
+            std::string id(field.InstrumentID, strnlen(field.InstrumentID, sizeof(field.InstrumentID)));
+            if (seen.insert(id).second) ids.push_back(id);
+        }
+    }
+}
+
+uint64_t TickReplayer::Dropped() const {
+    uint64_t dropped = 0;
+    for (size_t i = 0; i < m_pPipeline->LaneCount(); ++i) dropped += m_pPipeline->GetLaneStats(i).Dropped;
+    return dropped;
+}
+
+void TickReplayer::Run(CThostFtdcMdSpi* pSpi, double speed) {
+    memset(&m_stats, 0, sizeof(m_stats));
+    int64_t startNs = MonotonicNanos();
+    int64_t firstRecvNs = 0;
+    int64_t lastRecvNs = 0;
+    bool first = true;
+    // CTP 回调传入的是可写的指针，映射是只读的，逐条拷贝
+    CThostFtdcDepthMarketDataField field;
+
+    for (size_t i = 0; i < m_files.size(); ++i) {
+        TickFileReader reader;
+        if (!reader.Open(m_files[i].c_str())) continue;
+        std::cerr << "Replaying " << m_files[i] << " (" << reader.Count() << " ticks)" << std::endl;
+
+        uint64_t count = reader.Count();
+        for (uint64_t j = 0; j < count; ++j) {
+            const TickRecord& record = reader.Record(j);
+            if (first) {
+                firstRecvNs = record.RecvTimeNs;
+                first = false;
+            }
+            lastRecvNs = record.RecvTimeNs;
+
+            if (speed > 0) {
+                // 接收时间回退（如跨文件时钟调整）时不等待
+                int64_t due = startNs + static_cast<int64_t>((record.RecvTimeNs - firstRecvNs) / speed);
+                int64_t now = MonotonicNanos();
+                if (due - now > SLEEP_THRESHOLD_NS) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(due - now - SLEEP_THRESHOLD_NS / 2));
+                }
+                while ((now = MonotonicNanos()) < due) {
+                }
+                m_stats.MaxLateNs = std::max(m_stats.MaxLateNs, now - due);
+            }
+
+            memcpy(&field, &record.Field, sizeof(field));
+            if (!m_pPipeline) {
+                pSpi->OnRtnDepthMarketData(&field);
+            } else {
+                m_pPipeline->SetRecvTime(record.RecvTimeNs);
+                // 队列满时行情被丢弃，重发同一条（回调可能修改字段，每次重新拷贝）
+                while (true) {
+                    uint64_t dropped = Dropped();
+                    pSpi->OnRtnDepthMarketData(&field);
+                    if (Dropped() == dropped) break;
+                    ++m_stats.Retries;
+                    memcpy(&field, &record.Field, sizeof(field));
+                    std::this_thread::yield();
+                }
+            }
+            ++m_stats.Ticks;
+        }
+    }
+
+    if (m_pPipeline) m_pPipeline->SetRecvTime(0);
+    m_stats.ElapsedNs = MonotonicNanos() - startNs;
+    m_stats.RecordedSpanNs = lastRecvNs - firstRecvNs;
+    std::cerr << "=== TickReplayer: ticks=" << m_stats.Ticks
+              << ", elapsed_ms=" << m_stats.ElapsedNs / 1e6
+              << ", recorded_span_ms=" << m_stats.RecordedSpanNs / 1e6
+              << ", ticks_per_sec=" << (m_stats.ElapsedNs > 0 ? m_stats.Ticks * 1e9 / m_stats.ElapsedNs : 0.0)
+              << ", max_late_us=" << m_stats.MaxLateNs / 1e3
+              << ", retries=" << m_stats.Retries
+              << " ===" << std::endl;
+}
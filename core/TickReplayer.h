@@ -0,0 +1,55 @@
+#ifndef TICK_REPLAYER_H
+#define TICK_REPLAYER_H
+
+#include <ThostFtdcMdApi.h>
+#include "TickFileFormat.h"
+#include "TickPipeline.h"
+
+#include <string>
+#include <vector>
+
+// 回放录制文件（--replay=PATH，格式见 TickFileFormat.h）
+// 在调用线程中按记录顺序逐条调用 CThostFtdcMdSpi::OnRtnDepthMarketData，与 CTP 的回调线程行为一致，
+// 下游的流水线、缓存和各输出端无需区分实盘与回放。
+// 节奏按记录中的接收时间：speed 为 1 时按原始间隔，为 N 时加速 N 倍，为 0 时不等待（尽快回放）。
+// 设置了流水线时带反压：队列满导致行情被丢弃时让出 CPU 后重发同一条，回放不丢行情
+// （重发前的失败仍计入队列的丢弃数，回放统计中的 retries 即为这部分）。
+// 入队的行情沿用记录中的接收时间而不是回放时的当前时间，以任意速度回放时 K 线的日期都与录制时一致。
+class TickReplayer
+{
+public:
+    struct Stats
+    {
+        uint64_t Ticks;             // 已回放的记录数
+        int64_t ElapsedNs;          // 回放耗时
+        int64_t RecordedSpanNs;     // 录制时间跨度（首末记录的接收时间差）
+        int64_t MaxLateNs;          // 相对于计划时间的最大延迟（speed 为 0 时不统计）
+        uint64_t Retries;           // 队列满时的重发次数
+    };
+
+    TickReplayer() : m_pPipeline(nullptr) {}
+
+    // pSpi 写入的流水线，用于检测队列满并传递录制时的接收时间；须在 Run() 之前调用
+    void SetPipeline(TickPipeline* pPipeline) { m_pPipeline = pPipeline; }
+
+    // path 为单个 .ticks 文件或目录（按文件名排序回放目录中的全部 .ticks 文件）；
+    // 失败时返回 false 并在 stderr 输出原因
+    bool Open(const char* path);
+
+    // 录制文件中出现的全部合约代码，按首次出现的顺序；回放前登记到注册表
+    void CollectInstruments(std::vector<std::string>& ids) const;
+
+    // 回放全部记录，返回后统计可用
+    void Run(CThostFtdcMdSpi* pSpi, double speed);
+
+    Stats GetStats() const { return m_stats; }
+
+private:
+    uint64_t Dropped() const;
+
+    TickPipeline* m_pPipeline;
+    std::vector<std::string> m_files;
+    Stats m_stats;
+};
+
+#endif // TICK_REPLAYER_H
@@ -0,0 +1,74 @@
+#ifndef TICK_SINK_H
+#define TICK_SINK_H
+
+#include "TickRecord.h"
+#include "TickDeltaTracker.h"
+#include "MdJsonEncoder.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// 流水线工作线程处理单条行情时的上下文
+// 同一条行情的 JSON 帧只在第一次被请求时编码，多个输出端共享编码结果。
+class TickContext
+{
+public:
+    TickContext(const TickRecord& tick, uint32_t instrumentIndex, uint64_t sequence, const TickDelta& delta,
+                MdJsonEncoder& encoder)
+        : m_tick(tick), m_nInstrumentIndex(instrumentIndex), m_nSequence(sequence), m_delta(delta),
+          m_encoder(encoder), m_bJsonEncoded(false) {}
+
+    const TickRecord& Tick() const { return m_tick; }
+
+    // 相对同一合约上一条行情的成交量、成交额、持仓量增量，见 TickDeltaTracker
+    const TickDelta& Delta() const { return m_delta; }
+
+    // 合约编号，未注册的合约为 InstrumentRegistry::INVALID_INDEX
+    uint32_t InstrumentIndex() const { return m_nInstrumentIndex; }
+
+    // 流水线为每条行情分配的全局递增序号，从 1 开始
+    uint64_t Sequence() const { return m_nSequence; }
+
+    // SSE 帧（"data: {...}\n\n"），在本条行情处理结束前有效
+    const char* JsonFrame(size_t& len) {
+        if (!m_bJsonEncoded) {
+            m_encoder.EncodeSse(&m_tick.Field, &m_delta);
+            m_bJsonEncoded = true;
+        }
+        len = m_encoder.Size();
+        return m_encoder.Data();
+    }
+
+private:
+    const TickRecord& m_tick;
+    uint32_t m_nInstrumentIndex;
+    uint64_t m_nSequence;
+    const TickDelta& m_delta;
+    MdJsonEncoder& m_encoder;
+    bool m_bJsonEncoded;
+};
+
+// 行情输出端接口，所有回调都在流水线工作线程中执行
+class TickSink
+{
+public:
+    virtual ~TickSink() {}
+
+    // 处理一条行情
+    virtual void OnTick(TickContext& ctx) = 0;
+
+    // 上游队列暂时为空
+    virtual void OnIdle() {}
+
+    // 流水线停止前调用，此后不会再收到行情
+    virtual void OnStop() {}
+
+    // 输出统计信息到 stderr，由流水线按 STATS_INTERVAL_SEC 周期调用
+    virtual void ReportStats() {}
+
+    // /metrics 中的输出端名称和已输出的字节数，可在任意线程调用
+    virtual const char* Name() const { return "sink"; }
+    virtual uint64_t BytesOut() const { return 0; }
+};
+
+#endif // TICK_SINK_H
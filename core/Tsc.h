@@ -0,0 +1,47 @@
+#ifndef TSC_H
+#define TSC_H
+
+#include "TickRecord.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// 廉价的时间戳计数：x86 上直接读 TSC（不经过 vDSO，约数十个周期），其他平台退化为单调时钟（纳秒）。
+// 依赖 constant_tsc/nonstop_tsc（近年的 x86 处理器均支持），各核的 TSC 同步，
+// 可以在不同线程读取后相减；偶发的跨核偏差会得到负差值，由调用方按 0 处理。
+inline uint64_t ReadTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(MonotonicNanos());
+#endif
+}
+
+// 每个 TSC 周期对应的纳秒数，首次调用时以单调时钟校准（约 10 毫秒），应在启动阶段调用一次
+inline double TscNanosPerTick() {
+    static const double ratio = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        int64_t startNs = MonotonicNanos();
+        uint64_t startTsc = ReadTsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        int64_t endNs = MonotonicNanos();
+        uint64_t endTsc = ReadTsc();
+        return endTsc > startTsc ? static_cast<double>(endNs - startNs) / (endTsc - startTsc) : 1.0;
+#else
+        return 1.0;
+#endif
+    }();
+    return ratio;
+}
+
+// 两个时间戳之差（周期数），逆序时返回 0
+inline uint64_t TscElapsed(uint64_t from, uint64_t to) {
+    return to > from ? to - from : 0;
+}
+
+#endif // TSC_H
@@ -0,0 +1,148 @@
+// 合约查找微基准：对比按 std::string 查 unordered_map、FNV-1a 开放寻址与完美哈希
+// 用法：make bench-registry
+
+#include "InstrumentRegistry.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const int ITERATIONS = 10000000;
+
+// 防止编译器把被测代码优化掉
+static volatile uint64_t g_sink = 0;
+
+// 行情回调中的 InstrumentID：char[81]，'\0' 之后的内容不确定
+struct RawID
+{
+    char Data[81];
+};
+
+// 对照组：FNV-1a + 线性探测，键比较需要比较哈希、长度和字符串内容
+class FnvTable
+{
+public:
+    explicit FnvTable(const std::vector<std::string>& names) : m_names(names) {
+        size_t slots = 64;
+        while (slots < names.size() * 2) slots <<= 1;
+        m_slots.assign(slots, 0xFFFFFFFFu);
+        for (uint32_t i = 0; i < names.size(); ++i) {
+            m_hashes.push_back(Hash(names[i].data(), names[i].size()));
+            size_t pos = m_hashes[i] & (slots - 1);
+            while (m_slots[pos] != 0xFFFFFFFFu) pos = (pos + 1) & (slots - 1);
+            m_slots[pos] = i;
+        }
+    }
+
+    uint32_t Find(const char* id, size_t maxLen) const {
+        size_t len = strnlen(id, maxLen);
+        uint64_t h = Hash(id, len);
+        size_t mask = m_slots.size() - 1;
+        for (size_t pos = h & mask; m_slots[pos] != 0xFFFFFFFFu; pos = (pos + 1) & mask) {
+            uint32_t index = m_slots[pos];
+            if (m_hashes[index] == h && m_names[index].size() == len &&
+                memcmp(m_names[index].data(), id, len) == 0) {
+                return index;
+            }
+        }
+        return 0xFFFFFFFFu;
+    }
+
+private:
+    static uint64_t Hash(const char* str, size_t len) {
+        uint64_t h = 1469598103934665603ULL;
+        for (size_t i = 0; i < len; ++i) {
+            h ^= static_cast<unsigned char>(str[i]);
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    std::vector<std::string> m_names;
+    std::vector<uint64_t> m_hashes;
+    std::vector<uint32_t> m_slots;
+};
+
+template <typename Func>
+static void Run(const char* name, const std::vector<RawID>& ids, const std::vector<uint32_t>& sequence, Func func) {
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t total = 0;
+    for (int i = 0; i < ITERATIONS; ++i) {
+        total += func(ids[sequence[i & (sequence.size() - 1)]].Data);
+    }
+    auto end = std::chrono::steady_clock::now();
+    g_sink += total;
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count() / ITERATIONS;
+    printf("%-40s %8.1f ns/op\n", name, ns);
+}
+
+// 生成期货、期权与套利合约代码，数量与长度分布接近全市场订阅
+static std::vector<std::string> MakeInstruments(size_t count) {
+    static const char* PRODUCTS[] = {"rb", "hc", "au", "ag", "cu", "al", "zn", "ni", "sc", "fu", "m", "y", "p",
+                                     "c", "i", "j", "jm", "TA", "MA", "SR", "CF", "RM", "IF", "IH", "IC", "IM"};
+    std::vector<std::string> names;
+    char buf[64];
+    for (size_t i = 0; names.size() < count; ++i) {
+        const char* product = PRODUCTS[i % (sizeof(PRODUCTS) / sizeof(PRODUCTS[0]))];
+        int month = 2601 + static_cast<int>(i / 26 % 12) + static_cast<int>(i / 1248) * 100;
+        switch (i / 312 % 4) {
+            case 0: snprintf(buf, sizeof(buf), "%s%d", product, month); break;
+            case 1: snprintf(buf, sizeof(buf), "%s%d-C-%zu", product, month, 1000 + i); break;
+            case 2: snprintf(buf, sizeof(buf), "%s%d-P-%zu", product, month, 1000 + i); break;
+            default: snprintf(buf, sizeof(buf), "SPD %s%d&%s%zu", product, month, product, 2700 + i); break;
+        }
+        names.push_back(buf);
+    }
+    return names;
+}
+
+int main() {
+    const size_t counts[] = {10, 1000, 5000, 10000};
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        std::vector<std::string> names = MakeInstruments(counts[c]);
+
+        InstrumentRegistry registry;
+        std::unordered_map<std::string, uint32_t> map;
+        for (uint32_t i = 0; i < names.size(); ++i) {
+            registry.Add(names[i].c_str());
+            map.emplace(names[i], i);
+        }
+        auto buildBegin = std::chrono::steady_clock::now();
+        registry.Build();
+        auto buildEnd = std::chrono::steady_clock::now();
+        FnvTable fnv(names);
+
+        // '\0' 之后填充垃圾字节，确保实现只读取到结尾
+        std::vector<RawID> ids(names.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            memset(ids[i].Data, 'x', sizeof(ids[i].Data));
+            memcpy(ids[i].Data, names[i].c_str(), names[i].size() + 1);
+            if (registry.Find(ids[i].Data, sizeof(ids[i].Data)) != i) {
+                printf("lookup mismatch for %s\n", names[i].c_str());
+                return 1;
+            }
+        }
+
+        std::mt19937 rng(42);
+        std::vector<uint32_t> sequence(1 << 16);
+        for (size_t i = 0; i < sequence.size(); ++i) sequence[i] = rng() % names.size();
+
+        printf("--- %zu instruments (build %.2f ms) ---\n", names.size(),
+               std::chrono::duration<double, std::milli>(buildEnd - buildBegin).count());
+        Run("std::string + unordered_map", ids, sequence, [&map](const char* id) {
+            auto it = map.find(std::string(id));
+            return it != map.end() ? it->second : 0xFFFFFFFFu;
+        });
+        Run("FNV-1a open addressing", ids, sequence, [&fnv](const char* id) {
+            return fnv.Find(id, 81);
+        });
+        Run("InstrumentRegistry (perfect hash)", ids, sequence, [&registry](const char* id) {
+            return registry.Find(id, 81);
+        });
+    }
+    return 0;
+}
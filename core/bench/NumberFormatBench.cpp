@@ -0,0 +1,140 @@
+// 数值格式化微基准：对比 nlohmann::json 原有路径与 NumberFormat
+// 用法：make bench-numfmt
+
+#include "NumberFormat.h"
+#include "MdJsonEncoder.h"
+#include <json.hpp>
+
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// 原有的行情输出路径：拷贝到结构体 -> 构建 json -> dump -> 拼接 SSE 帧
+namespace MarketData
+{
+    struct DepthMarketData
+    {
+        std::string InstrumentID;
+        double LastPrice;
+        int Volume;
+        double BidPrice1;
+        int BidVolume1;
+        double AskPrice1;
+        int AskVolume1;
+        std::string UpdateTime;
+        int UpdateMillisec;
+    };
+
+    NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(DepthMarketData, InstrumentID, LastPrice, Volume,
+                                       BidPrice1, BidVolume1, AskPrice1, AskVolume1,
+                                       UpdateTime, UpdateMillisec)
+} // namespace MarketData
+
+static const int ITERATIONS = 2000000;
+
+// 防止编译器把被测代码优化掉
+static volatile size_t g_sink = 0;
+
+template <typename Func>
+static void Run(const char* name, int count, Func func) {
+    auto begin = std::chrono::steady_clock::now();
+    size_t total = 0;
+    for (int i = 0; i < ITERATIONS; ++i) {
+        total += func(i % count);
+    }
+    auto end = std::chrono::steady_clock::now();
+    g_sink += total;
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count() / ITERATIONS;
+    printf("%-40s %8.1f ns/op\n", name, ns);
+}
+
+int main() {
+    // 模拟行情价格：两位小数的价格、整数价格，以及少量 DBL_MAX 空档位
+    std::mt19937_64 rng(42);
+    std::vector<double> prices(4096);
+    for (size_t i = 0; i < prices.size(); ++i) {
+        switch (i % 8) {
+            case 0: prices[i] = DBL_MAX; break;
+            case 1: prices[i] = static_cast<double>(rng() % 100000); break;
+            default: prices[i] = static_cast<double>(rng() % 10000000) / 100.0; break;
+        }
+    }
+    std::vector<int64_t> volumes(4096);
+    for (size_t i = 0; i < volumes.size(); ++i) {
+        volumes[i] = static_cast<int64_t>(rng() % (i % 2 ? 1000 : 100000000));
+    }
+
+    char buf[64];
+    const int n = static_cast<int>(prices.size());
+
+    printf("--- double ---\n");
+    Run("nlohmann::detail::to_chars", n, [&](int i) {
+        return static_cast<size_t>(nlohmann::detail::to_chars(buf, buf + sizeof(buf), prices[i]) - buf);
+    });
+    Run("NumberFormat::FormatDouble", n, [&](int i) {
+        return static_cast<size_t>(NumberFormat::FormatDouble(buf, prices[i]) - buf);
+    });
+    Run("snprintf %.17g", n, [&](int i) {
+        return static_cast<size_t>(snprintf(buf, sizeof(buf), "%.17g", prices[i]));
+    });
+
+    printf("--- integer ---\n");
+    Run("json(int).dump()", n, [&](int i) {
+        return json(volumes[i]).dump().size();
+    });
+    Run("NumberFormat::FormatInt", n, [&](int i) {
+        return static_cast<size_t>(NumberFormat::FormatInt(buf, volumes[i]) - buf);
+    });
+    Run("snprintf %lld", n, [&](int i) {
+        return static_cast<size_t>(snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(volumes[i])));
+    });
+
+    printf("--- full tick (SSE frame) ---\n");
+    std::vector<CThostFtdcDepthMarketDataField> ticks(256);
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        CThostFtdcDepthMarketDataField& f = ticks[i];
+        memset(&f, 0, sizeof(f));
+        snprintf(f.InstrumentID, sizeof(f.InstrumentID), "au26%02d", static_cast<int>(i % 12 + 1));
+        snprintf(f.UpdateTime, sizeof(f.UpdateTime), "09:%02d:%02d", static_cast<int>(i % 60), static_cast<int>(i % 60));
+        f.LastPrice = prices[i];
+        f.BidPrice1 = prices[i + 1];
+        f.AskPrice1 = prices[i + 2];
+        f.Volume = static_cast<int>(volumes[i]);
+        f.BidVolume1 = static_cast<int>(volumes[i + 1]);
+        f.AskVolume1 = static_cast<int>(volumes[i + 3]);
+        f.UpdateMillisec = static_cast<int>(i % 2) * 500;
+    }
+    const int t = static_cast<int>(ticks.size());
+    Run("nlohmann struct -> dump -> concat", t, [&](int i) {
+        const CThostFtdcDepthMarketDataField& f = ticks[i];
+        MarketData::DepthMarketData data;
+        data.InstrumentID = f.InstrumentID;
+        data.LastPrice = f.LastPrice;
+        data.Volume = f.Volume;
+        data.BidPrice1 = f.BidPrice1;
+        data.BidVolume1 = f.BidVolume1;
+        data.AskPrice1 = f.AskPrice1;
+        data.AskVolume1 = f.AskVolume1;
+        data.UpdateTime = f.UpdateTime;
+        data.UpdateMillisec = f.UpdateMillisec;
+        json j = data;
+        std::string output = "data: " + j.dump(-1) + "\n\n";
+        return output.size();
+    });
+    MdJsonEncoder encoder;
+    Run("MdJsonEncoder::EncodeSse", t, [&](int i) {
+        return encoder.EncodeSse(&ticks[i]);
+    });
+    encoder.SetNullInvalidPrices(true);
+    Run("MdJsonEncoder::EncodeSse (null prices)", t, [&](int i) {
+        return encoder.EncodeSse(&ticks[i]);
+    });
+
+    return 0;
+}
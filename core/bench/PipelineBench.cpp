@@ -0,0 +1,334 @@
+// 端到端流水线基准：从 OnRtnDepthMarketData 入口到字节写出标准输出
+// 用法：make bench（或 build/pipeline_bench [--ticks=N] [--latency-ticks=N] [--rate=R]）
+//
+// 按合约数（10、1000、10000）和输出格式（json、binary、none）组合运行，每组两个阶段：
+//   吞吐：单个回调线程不限速调用 MyMdSpi::OnRtnDepthMarketData，队列满时重发（不计丢弃），
+//         统计从第一条行情进入到最后一个字节被读出的速率；
+//   延迟：按固定速率调用，记录每条行情从进入回调到其帧被读出的时间，输出分位数。
+// 标准输出被重定向到管道，由读取线程按格式切分帧（json 以空行结尾，binary 按消息头的长度），
+// 第 k 个行情帧对应第 k 条输入行情；none 格式不产生输出，延迟以输出端收到行情为终点。
+// 结果以 JSON 写到原标准输出，进度和流水线统计写到 stderr。
+
+#include "MyMdSpi.h"
+#include "MdBinaryFormat.h"
+#include "config.h"
+#include <json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using json = nlohmann::json;
+
+static const size_t PIPE_BYTES = 1 << 20;
+static const int READ_BUFFER_BYTES = 1 << 16;
+
+// 读取线程：从管道读出流水线写出的字节，按格式切分出行情帧并记录读出时间
+class OutputReader
+{
+public:
+    explicit OutputReader(int fd)
+        : m_fd(fd), m_format(OutputFormat::None), m_pEntryNs(nullptr), m_bHeaderSeen(false), m_nFrames(0) {
+        m_thread = std::thread(&OutputReader::Run, this);
+    }
+
+    // 写端全部关闭后读取线程读到 EOF 退出
+    ~OutputReader() {
+        m_thread.join();
+        close(m_fd);
+    }
+
+    // 在流水线启动之前调用；pEntryNs 非空时记录每帧的延迟
+    void Reset(OutputFormat format, const std::atomic<int64_t>* pEntryNs, size_t expected) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_format = format;
+        m_pEntryNs = pEntryNs;
+        m_pending.clear();
+        m_bHeaderSeen = false;
+        m_latencies.clear();
+        m_latencies.reserve(pEntryNs ? expected : 0);
+        m_nFrames.store(0, std::memory_order_release);
+    }
+
+    // 行情帧计数，也用于 none 格式（由 CountingSink 累加）
+    uint64_t Frames() const { return m_nFrames.load(std::memory_order_acquire); }
+    void AddFrame(int64_t latencyNs) {
+        if (latencyNs >= 0) m_latencies.push_back(latencyNs);
+        m_nFrames.store(m_nFrames.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    std::vector<int64_t> TakeLatencies() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::move(m_latencies);
+    }
+
+private:
+    void Run() {
+        std::vector<char> buffer(READ_BUFFER_BYTES);
+        while (true) {
+            ssize_t n = read(m_fd, buffer.data(), buffer.size());
+            if (n <= 0) return;
+            int64_t now = MonotonicNanos();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.insert(m_pending.end(), buffer.data(), buffer.data() + n);
+            size_t used = m_format == OutputFormat::Binary ? SplitBinary(now) : SplitJson(now);
+            m_pending.erase(m_pending.begin(), m_pending.begin() + used);
+        }
+    }
+
+    void OnFrame(int64_t now) {
+        uint64_t k = m_nFrames.load(std::memory_order_relaxed);
+        AddFrame(m_pEntryNs ? now - m_pEntryNs[k].load(std::memory_order_relaxed) : -1);
+    }
+
+    // SSE 帧以 "\n\n" 结尾
+    size_t SplitJson(int64_t now) {
+        size_t used = 0;
+        for (size_t i = 1; i < m_pending.size(); ++i) {
+            if (m_pending[i] == '\n' && m_pending[i - 1] == '\n') {
+                OnFrame(now);
+                used = i + 1;
+            }
+        }
+        return used;
+    }
+
+    // 跳过流头和合约定义，只计行情消息
+    size_t SplitBinary(int64_t now) {
+        size_t pos = 0;
+        if (!m_bHeaderSeen) {
+            if (m_pending.size() < sizeof(MdBinaryStreamHeader)) return 0;
+            pos = sizeof(MdBinaryStreamHeader);
+            m_bHeaderSeen = true;
+        }
+        while (m_pending.size() - pos >= sizeof(MdBinaryMsgHeader)) {
+            MdBinaryMsgHeader header;
+            memcpy(&header, &m_pending[pos], sizeof(header));
+            if (m_pending.size() - pos < header.Length) break;
+            if (header.Type == MD_BINARY_MSG_TICK_L1 || header.Type == MD_BINARY_MSG_TICK_L5) OnFrame(now);
+            pos += header.Length;
+        }
+        return pos;
+    }
+
+    int m_fd;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    OutputFormat m_format;
+    const std::atomic<int64_t>* m_pEntryNs;
+    std::vector<char> m_pending;
+    bool m_bHeaderSeen;
+    std::vector<int64_t> m_latencies;
+    std::atomic<uint64_t> m_nFrames;
+};
+
+// none 格式没有输出字节，以输出端收到行情作为终点
+class CountingSink : public TickSink
+{
+public:
+    CountingSink(OutputReader& reader, const std::atomic<int64_t>* pEntryNs) : m_reader(reader), m_pEntryNs(pEntryNs) {}
+
+    virtual void OnTick(TickContext& ctx) override {
+        int64_t now = MonotonicNanos();
+        m_reader.AddFrame(m_pEntryNs ? now - m_pEntryNs[ctx.Sequence() - 1].load(std::memory_order_relaxed) : -1);
+    }
+
+private:
+    OutputReader& m_reader;
+    const std::atomic<int64_t>* m_pEntryNs;
+};
+
+struct PhaseResult
+{
+    double TicksPerSec;
+    double BytesPerTick;
+    double FramesPerSyscall;
+    uint64_t Retries;           // 队列满时的重发次数
+    std::vector<int64_t> Latencies;
+};
+
+// 运行一个阶段：rate 为 0 时不限速；pEntryNs 非空时记录每条行情的进入时间
+static PhaseResult RunPhase(OutputReader& reader, InstrumentRegistry& registry,
+                            std::vector<CThostFtdcDepthMarketDataField>& fields, OutputFormat format,
+                            uint64_t ticks, double rate, std::atomic<int64_t>* pEntryNs) {
+    BatchWriter::Policy policy;
+    policy.MaxBytes = OUTPUT_MAX_BATCH_BYTES;
+    policy.MaxFrames = OUTPUT_MAX_BATCH_FRAMES;
+    policy.MaxDelayUs = OUTPUT_MAX_DELAY_US;
+    policy.FlushWhenIdle = OUTPUT_FLUSH_WHEN_IDLE;
+    TickPipeline pipeline(TICK_RING_CAPACITY, policy, 1);
+    pipeline.SetOutputFormat(format);
+    pipeline.SetRegistry(&registry);
+    LastValueCache lastValues(registry.Capacity());
+    pipeline.SetLastValueCache(&lastValues);
+    CountingSink sink(reader, pEntryNs);
+    if (format == OutputFormat::None) pipeline.AddSink(&sink);
+
+    MyMdSpi spi;
+    spi.SetPipeline(&pipeline);
+
+    reader.Reset(format, format == OutputFormat::None ? nullptr : pEntryNs, ticks);
+    pipeline.Start();
+
+    uint64_t retries = 0;
+    int64_t startNs = MonotonicNanos();
+    for (uint64_t k = 0; k < ticks; ++k) {
+        CThostFtdcDepthMarketDataField& field = fields[k % fields.size()];
+        ++field.Volume;
+        if (rate > 0) {
+            int64_t due = startNs + static_cast<int64_t>(k * 1e9 / rate);
+            // 让出 CPU 而不是空转，核数少时工作线程和读取线程才能及时运行
+            while (MonotonicNanos() < due) std::this_thread::yield();
+        }
+        // 队列满时行情被丢弃，重发同一条以保持帧与输入一一对应
+        while (true) {
+            uint64_t dropped = pipeline.GetLaneStats(0).Dropped;
+            if (pEntryNs) pEntryNs[k].store(MonotonicNanos(), std::memory_order_relaxed);
+            spi.OnRtnDepthMarketData(&field);
+            if (pipeline.GetLaneStats(0).Dropped == dropped) break;
+            ++retries;
+            std::this_thread::yield();
+        }
+    }
+    while (reader.Frames() < ticks) std::this_thread::yield();
+    int64_t elapsedNs = MonotonicNanos() - startNs;
+    pipeline.Stop();
+
+    BatchWriter::Stats output = pipeline.GetOutputStats();
+    PhaseResult result;
+    result.TicksPerSec = ticks * 1e9 / elapsedNs;
+    result.BytesPerTick = static_cast<double>(output.Bytes) / ticks;
+    result.FramesPerSyscall = output.Syscalls ? static_cast<double>(output.Frames) / output.Syscalls : 0;
+    result.Retries = retries;
+    result.Latencies = reader.TakeLatencies();
+    return result;
+}
+
+static int64_t Percentile(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+static std::vector<CThostFtdcDepthMarketDataField> MakeFields(InstrumentRegistry& registry, size_t count) {
+    std::vector<CThostFtdcDepthMarketDataField> fields(count);
+    char id[32];
+    for (size_t i = 0; i < count; ++i) {
+        snprintf(id, sizeof(id), "bench%05zu", i);
+        registry.Add(id);
+        CThostFtdcDepthMarketDataField& f = fields[i];
+        memset(&f, 0, sizeof(f));
+        strcpy(f.TradingDay, "20260105");
+        strcpy(f.ActionDay, "20260105");
+        strcpy(f.InstrumentID, id);
+        strcpy(f.UpdateTime, "09:30:00");
+        f.UpdateMillisec = 500;
+        f.LastPrice = 3000.2 + i;
+        f.PreSettlementPrice = f.PreClosePrice = f.OpenPrice = f.HighestPrice = f.LowestPrice = f.LastPrice;
+        f.UpperLimitPrice = f.LastPrice * 1.1;
+        f.LowerLimitPrice = f.LastPrice * 0.9;
+        f.Turnover = 1.5e9;
+        f.OpenInterest = 123456;
+        f.AveragePrice = f.LastPrice * 10;
+        f.BidPrice1 = f.LastPrice - 0.2;
+        f.AskPrice1 = f.LastPrice + 0.2;
+        f.BidVolume1 = 12;
+        f.AskVolume1 = 34;
+    }
+    registry.Build();
+    return fields;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t throughputTicks = 2000000;
+    uint64_t latencyTicks = 200000;
+    double rate = 100000;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--ticks=", 8) == 0) {
+            throughputTicks = strtoull(argv[i] + 8, nullptr, 10);
+        } else if (strncmp(argv[i], "--latency-ticks=", 16) == 0) {
+            latencyTicks = strtoull(argv[i] + 16, nullptr, 10);
+        } else if (strncmp(argv[i], "--rate=", 7) == 0) {
+            rate = atof(argv[i] + 7);
+        } else {
+            fprintf(stderr, "Usage: %s [--ticks=N] [--latency-ticks=N] [--rate=TICKS_PER_SEC]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (throughputTicks == 0 || latencyTicks == 0 || rate <= 0) {
+        fprintf(stderr, "ticks and rate must be positive\n");
+        return 1;
+    }
+    STATS_INTERVAL_SEC = 0;
+
+    // 流水线写 STDOUT_FILENO：换成管道，结果写到原标准输出
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    fcntl(pipeFds[1], F_SETPIPE_SZ, static_cast<int>(PIPE_BYTES));
+    int resultFd = dup(STDOUT_FILENO);
+    dup2(pipeFds[1], STDOUT_FILENO);
+    close(pipeFds[1]);
+    OutputReader reader(pipeFds[0]);
+
+    std::unique_ptr<std::atomic<int64_t>[]> entryNs(new std::atomic<int64_t>[latencyTicks]);
+
+    const size_t counts[] = {10, 1000, 10000};
+    const OutputFormat formats[] = {OutputFormat::Json, OutputFormat::Binary, OutputFormat::None};
+    const char* formatNames[] = {"json", "binary", "none"};
+
+    json results = json::array();
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        InstrumentRegistry registry;
+        std::vector<CThostFtdcDepthMarketDataField> fields = MakeFields(registry, counts[c]);
+
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+            fprintf(stderr, "--- %zu instruments, %s ---\n", counts[c], formatNames[f]);
+            PhaseResult throughput = RunPhase(reader, registry, fields, formats[f], throughputTicks, 0, nullptr);
+            PhaseResult latency = RunPhase(reader, registry, fields, formats[f], latencyTicks, rate, entryNs.get());
+            std::vector<int64_t>& sorted = latency.Latencies;
+            std::sort(sorted.begin(), sorted.end());
+
+            json entry;
+            entry["instruments"] = counts[c];
+            entry["format"] = formatNames[f];
+            entry["throughput_ticks_per_sec"] = throughput.TicksPerSec;
+            entry["bytes_per_tick"] = throughput.BytesPerTick;
+            entry["frames_per_syscall"] = throughput.FramesPerSyscall;
+            entry["queue_full_retries"] = throughput.Retries;
+            entry["latency_rate_ticks_per_sec"] = rate;
+            entry["latency_endpoint"] = formats[f] == OutputFormat::None ? "sink" : "bytes_read";
+            entry["latency_ns"] = {{"p50", Percentile(sorted, 0.50)},   {"p90", Percentile(sorted, 0.90)},
+                                   {"p99", Percentile(sorted, 0.99)},   {"p999", Percentile(sorted, 0.999)},
+                                   {"max", sorted.empty() ? 0 : sorted.back()}, {"samples", sorted.size()}};
+            results.push_back(entry);
+            fprintf(stderr, "throughput %.0f ticks/s, latency p50 %.1f us, p99 %.1f us\n", throughput.TicksPerSec,
+                    Percentile(sorted, 0.50) / 1e3, Percentile(sorted, 0.99) / 1e3);
+        }
+    }
+
+    json doc;
+    doc["benchmark"] = "pipeline";
+    doc["throughput_ticks"] = throughputTicks;
+    doc["latency_ticks"] = latencyTicks;
+    doc["cpus"] = std::thread::hardware_concurrency();
+    doc["ring_capacity"] = TICK_RING_CAPACITY;
+    doc["output_policy"] = {{"max_batch_bytes", OUTPUT_MAX_BATCH_BYTES}, {"max_batch_frames", OUTPUT_MAX_BATCH_FRAMES},
+                            {"max_delay_us", OUTPUT_MAX_DELAY_US}, {"flush_when_idle", OUTPUT_FLUSH_WHEN_IDLE}};
+    doc["results"] = results;
+    std::string text = doc.dump(2) + "\n";
+    bool ok = write(resultFd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+    close(STDOUT_FILENO);
+    return ok ? 0 : 1;
+}
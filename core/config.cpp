@@ -1,8 +1,365 @@
 #include "config.h"
+#include <json.hpp>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
 
-const char* FRONT_ADDR = "tcp://182.254.243.31:30013";
-const char* BROKER_ID = "9999";
-const char* USER_ID = "anon";
-const char* PASSWORD = "123456";
-const char* INSTRUMENT_IDS[] = {"au2602", "au2603"};
-const int INSTRUMENT_COUNT = sizeof(INSTRUMENT_IDS) / sizeof(INSTRUMENT_IDS[0]);
\ No newline at end of file
+std::string FRONT_ADDR = "tcp://182.254.243.31:30013";
+std::vector<std::string> FRONT_ADDRS;
+std::string BROKER_ID = "9999";
+std::string USER_ID = "anon";
+std::string PASSWORD = "123456";
+std::vector<std::string> INSTRUMENT_IDS = {"au2602", "au2603"};
+std::string INSTRUMENT_FILE;
+int INSTRUMENT_CAPACITY = 16384;
+
+int MD_SESSIONS = 1;
+std::string FLOW_PATH;
+std::vector<std::vector<std::string>> SESSION_GROUPS;
+
+int SUBSCRIBE_CHUNK_SIZE = 500;
+int SUBSCRIBE_MAX_ATTEMPTS = 5;
+int SUBSCRIBE_RETRY_INTERVAL_MS = 1000;
+int SUBSCRIBE_RESPONSE_TIMEOUT_MS = 10000;
+
+int TICK_RING_CAPACITY = 65536;
+int STATS_INTERVAL_SEC = 60;
+bool LATENCY_STATS = true;
+
+int OUTPUT_MAX_BATCH_BYTES = 64 * 1024;
+int OUTPUT_MAX_BATCH_FRAMES = 512;
+int OUTPUT_MAX_DELAY_US = 50;
+bool OUTPUT_FLUSH_WHEN_IDLE = true;
+
+bool OUTPUT_NULL_INVALID_PRICE = false;
+int OUTPUT_DEPTH = 1;
+bool OUTPUT_TICK_DELTAS = false;
+
+int SHM_SLOT_COUNT = 1 << 17;
+int SHM_INSTRUMENT_CAPACITY = 65536;
+
+int RECORD_SEGMENT_MB = 1024;
+
+double REPLAY_SPEED = 1.0;
+
+int MOCK_TICK_RATE = 1000;
+int MOCK_INSTRUMENT_COUNT = 0;
+int MOCK_RESPONSE_DELAY_MS = 1;
+int MOCK_DISCONNECT_INTERVAL_SEC = 0;
+int MOCK_DURATION_SEC = 0;
+
+int BAR_HISTORY = 16;
+int BAR_CLOSE_DELAY_MS = 500;
+
+int SSE_MAX_CLIENTS = 10000;
+int SSE_INBOUND_CAPACITY = 16384;
+int SSE_LOG_BYTES = 64 * 1024 * 1024;
+int SSE_LOG_FRAMES = 262144;
+int SSE_CLIENT_MAX_QUEUE_FRAMES = 65536;
+int SSE_CONFLATE_LAG_FRAMES = 1024;
+bool SSE_DELTA_FRAMES = false;
+int SSE_DELTA_REFRESH_FRAMES = 100;
+
+// --- 配置项表 ---
+
+enum class OptionType
+{
+    String,
+    StringList,     // JSON 字符串数组，命令行中以逗号分隔
+    Int,
+    Double,
+    Bool
+};
+
+struct ConfigOption
+{
+    const char* Key;
+    OptionType Type;
+    void* Target;
+    int MinValue;       // 整数项和浮点项的下限
+};
+
+static const ConfigOption CONFIG_OPTIONS[] = {
+    {"front_addr", OptionType::String, &FRONT_ADDR, 0},
+    {"front_addrs", OptionType::StringList, &FRONT_ADDRS, 0},
+    {"broker_id", OptionType::String, &BROKER_ID, 0},
+    {"user_id", OptionType::String, &USER_ID, 0},
+    {"password", OptionType::String, &PASSWORD, 0},
+    {"instrument_file", OptionType::String, &INSTRUMENT_FILE, 0},
+    {"instrument_capacity", OptionType::Int, &INSTRUMENT_CAPACITY, 1},
+    {"md_sessions", OptionType::Int, &MD_SESSIONS, 1},
+    {"flow_path", OptionType::String, &FLOW_PATH, 0},
+    {"subscribe_chunk_size", OptionType::Int, &SUBSCRIBE_CHUNK_SIZE, 1},
+    {"subscribe_max_attempts", OptionType::Int, &SUBSCRIBE_MAX_ATTEMPTS, 1},
+    {"subscribe_retry_interval_ms", OptionType::Int, &SUBSCRIBE_RETRY_INTERVAL_MS, 0},
+    {"subscribe_response_timeout_ms", OptionType::Int, &SUBSCRIBE_RESPONSE_TIMEOUT_MS, 1},
+    {"tick_ring_capacity", OptionType::Int, &TICK_RING_CAPACITY, 2},
+    {"stats_interval_sec", OptionType::Int, &STATS_INTERVAL_SEC, 0},
+    {"latency_stats", OptionType::Bool, &LATENCY_STATS, 0},
+    {"output_max_batch_bytes", OptionType::Int, &OUTPUT_MAX_BATCH_BYTES, 1},
+    {"output_max_batch_frames", OptionType::Int, &OUTPUT_MAX_BATCH_FRAMES, 1},
+    {"output_max_delay_us", OptionType::Int, &OUTPUT_MAX_DELAY_US, 0},
+    {"output_flush_when_idle", OptionType::Bool, &OUTPUT_FLUSH_WHEN_IDLE, 0},
+    {"output_null_invalid_price", OptionType::Bool, &OUTPUT_NULL_INVALID_PRICE, 0},
+    {"output_depth", OptionType::Int, &OUTPUT_DEPTH, 1},
+    {"output_tick_deltas", OptionType::Bool, &OUTPUT_TICK_DELTAS, 0},
+    {"shm_slot_count", OptionType::Int, &SHM_SLOT_COUNT, 2},
+    {"shm_instrument_capacity", OptionType::Int, &SHM_INSTRUMENT_CAPACITY, 1},
+    {"record_segment_mb", OptionType::Int, &RECORD_SEGMENT_MB, 1},
+    {"replay_speed", OptionType::Double, &REPLAY_SPEED, 0},
+    {"mock_tick_rate", OptionType::Int, &MOCK_TICK_RATE, 0},
+    {"mock_instrument_count", OptionType::Int, &MOCK_INSTRUMENT_COUNT, 0},
+    {"mock_response_delay_ms", OptionType::Int, &MOCK_RESPONSE_DELAY_MS, 0},
+    {"mock_disconnect_interval_sec", OptionType::Int, &MOCK_DISCONNECT_INTERVAL_SEC, 0},
+    {"mock_duration_sec", OptionType::Int, &MOCK_DURATION_SEC, 0},
+    {"bar_history", OptionType::Int, &BAR_HISTORY, 1},
+    {"bar_close_delay_ms", OptionType::Int, &BAR_CLOSE_DELAY_MS, 0},
+    {"sse_max_clients", OptionType::Int, &SSE_MAX_CLIENTS, 1},
+    {"sse_inbound_capacity", OptionType::Int, &SSE_INBOUND_CAPACITY, 2},
+    {"sse_log_bytes", OptionType::Int, &SSE_LOG_BYTES, 4096},
+    {"sse_log_frames", OptionType::Int, &SSE_LOG_FRAMES, 2},
+    {"sse_client_max_queue_frames", OptionType::Int, &SSE_CLIENT_MAX_QUEUE_FRAMES, 1},
+    {"sse_conflate_lag_frames", OptionType::Int, &SSE_CONFLATE_LAG_FRAMES, 0},
+    {"sse_delta_frames", OptionType::Bool, &SSE_DELTA_FRAMES, 0},
+    {"sse_delta_refresh_frames", OptionType::Int, &SSE_DELTA_REFRESH_FRAMES, 1},
+};
+
+static const ConfigOption* FindOption(const std::string& key) {
+    for (size_t i = 0; i < sizeof(CONFIG_OPTIONS) / sizeof(CONFIG_OPTIONS[0]); ++i) {
+        if (key == CONFIG_OPTIONS[i].Key) return &CONFIG_OPTIONS[i];
+    }
+    return nullptr;
+}
+
+static bool SetInt(const ConfigOption& option, long long value) {
+    if (value < option.MinValue || value > INT_MAX) {
+        std::cerr << "Config: " << option.Key << " out of range: " << value << std::endl;
+        return false;
+    }
+    *static_cast<int*>(option.Target) = static_cast<int>(value);
+    return true;
+}
+
+static bool SetDouble(const ConfigOption& option, double value) {
+    if (!(value >= option.MinValue) || std::isinf(value)) {
+        std::cerr << "Config: " << option.Key << " out of range: " << value << std::endl;
+        return false;
+    }
+    *static_cast<double*>(option.Target) = value;
+    return true;
+}
+
+static bool ParseBool(const char* value, bool& result) {
+    if (strcmp(value, "true") == 0 || strcmp(value, "1") == 0) {
+        result = true;
+    } else if (strcmp(value, "false") == 0 || strcmp(value, "0") == 0) {
+        result = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ApplyConfigOverride(const std::string& key, const char* value) {
+    std::string name = key;
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (name[i] == '-') name[i] = '_';
+    }
+    const ConfigOption* option = FindOption(name);
+    if (!option) {
+        std::cerr << "Config: unknown option " << key << std::endl;
+        return false;
+    }
+
+    switch (option->Type) {
+    case OptionType::String:
+        *static_cast<std::string*>(option->Target) = value;
+        return true;
+    case OptionType::StringList: {
+        std::vector<std::string>& list = *static_cast<std::vector<std::string>*>(option->Target);
+        list.clear();
+        for (const char* p = value; *p;) {
+            const char* comma = strchr(p, ',');
+            size_t len = comma ? static_cast<size_t>(comma - p) : strlen(p);
+            if (len > 0) list.emplace_back(p, len);
+            p += len + (comma ? 1 : 0);
+        }
+        return true;
+    }
+    case OptionType::Int: {
+        char* end = nullptr;
+        errno = 0;
+        long long n = strtoll(value, &end, 10);
+        if (errno != 0 || end == value || *end != '\0') {
+            std::cerr << "Config: " << option->Key << " expects an integer, got \"" << value << "\"" << std::endl;
+            return false;
+        }
+        return SetInt(*option, n);
+    }
+    case OptionType::Double: {
+        char* end = nullptr;
+        errno = 0;
+        double d = strtod(value, &end);
+        if (errno != 0 || end == value || *end != '\0') {
+            std::cerr << "Config: " << option->Key << " expects a number, got \"" << value << "\"" << std::endl;
+            return false;
+        }
+        return SetDouble(*option, d);
+    }
+    case OptionType::Bool:
+        if (!ParseBool(value, *static_cast<bool*>(option->Target))) {
+            std::cerr << "Config: " << option->Key << " expects true or false, got \"" << value << "\"" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+static bool ParseSessionGroups(const nlohmann::json& value) {
+    if (!value.is_array()) return false;
+    std::vector<std::vector<std::string>> groups(value.size());
+    for (size_t g = 0; g < value.size(); ++g) {
+        if (!value[g].is_array()) return false;
+        for (size_t i = 0; i < value[g].size(); ++i) {
+            if (!value[g][i].is_string()) return false;
+            groups[g].push_back(value[g][i].get<std::string>());
+        }
+    }
+    SESSION_GROUPS.swap(groups);
+    return true;
+}
+
+bool LoadConfigFile(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Config: cannot open " << path << std::endl;
+        return false;
+    }
+    nlohmann::json doc = nlohmann::json::parse(in, nullptr, false, true);
+    if (doc.is_discarded() || !doc.is_object()) {
+        std::cerr << "Config: " << path << " is not a valid JSON object" << std::endl;
+        return false;
+    }
+
+    for (auto it = doc.begin(); it != doc.end(); ++it) {
+        const nlohmann::json& value = it.value();
+        if (it.key() == "instruments") {
+            if (!value.is_array()) {
+                std::cerr << "Config: instruments must be an array of strings" << std::endl;
+                return false;
+            }
+            INSTRUMENT_IDS.clear();
+            INSTRUMENT_IDS.reserve(value.size());
+            for (size_t i = 0; i < value.size(); ++i) {
+                if (!value[i].is_string()) {
+                    std::cerr << "Config: instruments must be an array of strings" << std::endl;
+                    return false;
+                }
+                INSTRUMENT_IDS.push_back(value[i].get<std::string>());
+            }
+            continue;
+        }
+
+        if (it.key() == "session_groups") {
+            if (!ParseSessionGroups(value)) {
+                std::cerr << "Config: session_groups must be an array of string arrays" << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        const ConfigOption* option = FindOption(it.key());
+        if (!option) {
+            std::cerr << "Config: unknown option " << it.key() << " in " << path << std::endl;
+            return false;
+        }
+        bool ok = false;
+        switch (option->Type) {
+        case OptionType::String:
+            ok = value.is_string();
+            if (ok) *static_cast<std::string*>(option->Target) = value.get<std::string>();
+            break;
+        case OptionType::StringList: {
+            ok = value.is_array();
+            std::vector<std::string> list;
+            for (size_t i = 0; ok && i < value.size(); ++i) {
+                ok = value[i].is_string();
+                if (ok) list.push_back(value[i].get<std::string>());
+            }
+            if (ok) static_cast<std::vector<std::string>*>(option->Target)->swap(list);
+            break;
+        }
+        case OptionType::Int:
+            if (value.is_number_integer()) {
+                if (!SetInt(*option, value.get<long long>())) return false;
+                ok = true;
+            }
+            break;
+        case OptionType::Double:
+            if (value.is_number()) {
+                if (!SetDouble(*option, value.get<double>())) return false;
+                ok = true;
+            }
+            break;
+        case OptionType::Bool:
+            ok = value.is_boolean();
+            if (ok) *static_cast<bool*>(option->Target) = value.get<bool>();
+            break;
+        }
+        if (!ok) {
+            std::cerr << "Config: " << it.key() << " has the wrong type in " << path << std::endl;
+            return false;
+        }
+    }
+
+    // 合约列表文件的相对路径相对于配置文件所在目录
+    if (doc.contains("instrument_file") && !INSTRUMENT_FILE.empty() && INSTRUMENT_FILE[0] != '/') {
+        const char* slash = strrchr(path, '/');
+        if (slash) INSTRUMENT_FILE = std::string(path, slash + 1 - path) + INSTRUMENT_FILE;
+    }
+    return true;
+}
+
+// 整个文件一次读入，按行切分；数万行的列表在毫秒级完成
+bool LoadInstrumentList() {
+    if (INSTRUMENT_FILE.empty()) return true;
+
+    FILE* fp = fopen(INSTRUMENT_FILE.c_str(), "rb");
+    if (!fp) {
+        std::cerr << "Config: cannot open instrument file " << INSTRUMENT_FILE << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::string data;
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) data.append(chunk, n);
+    bool failed = ferror(fp) != 0;
+    fclose(fp);
+    if (failed) {
+        std::cerr << "Config: failed to read instrument file " << INSTRUMENT_FILE << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> ids;
+    const char* p = data.data();
+    const char* end = p + data.size();
+    while (p < end) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        const char* begin = p;
+        const char* last = eol;
+        while (begin < last && (*begin == ' ' || *begin == '\t')) ++begin;
+        while (last > begin && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) --last;
+        if (begin < last && *begin != '#') ids.emplace_back(begin, last - begin);
+        p = eol + 1;
+    }
+
+    INSTRUMENT_IDS.swap(ids);
+    return true;
+}
\ No newline at end of file
@@ -1,14 +1,97 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-// 定义一些常量，实际使用时应从配置文件或命令行参数读取
-extern const char* FRONT_ADDR; // 行情前置机地址
-extern const char* BROKER_ID; // 经纪公司代码
-extern const char* USER_ID; // 用户ID
-extern const char* PASSWORD; // 密码
+#include <string>
+#include <vector>
+
+// 运行参数，下面的值为默认值
+// 启动时依次由配置文件（--config=FILE）和命令行（--key=value）覆盖，之后只读（INSTRUMENT_IDS 只在启动时使用）。
+// 配置文件与命令行使用的键名为变量名的小写形式，例如 front_addr、tick_ring_capacity。
+
+extern std::string FRONT_ADDR; // 行情前置机地址
+// 冗余前置：设置两个及以上地址时取代 FRONT_ADDR，每个地址各建一组会话订阅相同的合约，
+// 同一条行情只输出最先到达的一份（命令行中以逗号分隔）
+extern std::vector<std::string> FRONT_ADDRS;
+extern std::string BROKER_ID; // 经纪公司代码
+extern std::string USER_ID; // 用户ID
+extern std::string PASSWORD; // 密码
 
 // 要订阅的合约列表
-extern const char* INSTRUMENT_IDS[]; // 合约代码
-extern const int INSTRUMENT_COUNT;
+extern std::vector<std::string> INSTRUMENT_IDS; // 合约代码
+extern std::string INSTRUMENT_FILE; // 合约列表文件，每行一个合约代码，设置后取代 INSTRUMENT_IDS
+extern int INSTRUMENT_CAPACITY; // 合约编号容量，含运行中通过控制通道（--control=PATH）新增的合约
+
+// 多会话：创建 MD_SESSIONS 个 CThostFtdcMdApi 实例分摊回调负载，每个合约只由一个会话订阅
+extern int MD_SESSIONS;         // 会话数
+extern std::string FLOW_PATH;   // 订阅信息文件目录，多会话时各会话使用其下的 md<N>/ 子目录
+extern std::vector<std::vector<std::string>> SESSION_GROUPS; // 显式分组，第 g 组的合约由会话 g 订阅，其余合约按哈希分配
+
+// 分批订阅
+extern int SUBSCRIBE_CHUNK_SIZE;          // 单次 SubscribeMarketData 的合约数
+extern int SUBSCRIBE_MAX_ATTEMPTS;        // 每批最多发送次数（含首次）
+extern int SUBSCRIBE_RETRY_INTERVAL_MS;   // 订阅失败或请求被流控拒绝后的重发间隔（毫秒）
+extern int SUBSCRIBE_RESPONSE_TIMEOUT_MS; // 已发送的批次超过该时间仍有合约未应答时重发（毫秒）
+
+// 行情流水线参数
+extern int TICK_RING_CAPACITY; // 回调线程与工作线程之间的环形队列容量（条）
+extern int STATS_INTERVAL_SEC; // 统计信息输出到 stderr 的间隔（秒），0 表示不输出
+extern bool LATENCY_STATS;     // 按阶段统计每条行情的处理延迟（TSC 时间戳 + 直方图），随统计信息输出
+
+// 标准输出批量写出策略，满足任一条件即执行一次 writev
+extern int OUTPUT_MAX_BATCH_BYTES;   // 单批最大字节数
+extern int OUTPUT_MAX_BATCH_FRAMES;  // 单批最大帧数
+extern int OUTPUT_MAX_DELAY_US;      // 帧最长暂存时间（微秒），0 表示不限制
+extern bool OUTPUT_FLUSH_WHEN_IDLE;  // 队列为空时立即写出
+
+// 将 CTP 的无效价格（DBL_MAX）输出为 null
+extern bool OUTPUT_NULL_INVALID_PRICE;
+
+// 输出的盘口深度：1 为一档（兼容原有格式），5 为五档完整盘口
+extern int OUTPUT_DEPTH;
+
+// 开启时标准输出和 SSE 的每条行情附带相对上一条行情的成交量、成交额、持仓量增量和成交均价（见 TickDeltaTracker.h）；
+// 默认关闭，此时 JSON 与原有格式一致，二进制流不输出 MdBinaryTickDelta；需要增量的部署在 config.json 中开启
+extern bool OUTPUT_TICK_DELTAS;
+
+// 共享内存广播环（通过 --shm=NAME 启用）
+extern int SHM_SLOT_COUNT;          // 槽位数，每个槽位 256 字节（注意 Docker 默认 /dev/shm 只有 64MB）
+extern int SHM_INSTRUMENT_CAPACITY; // 合约表容量
+
+// 行情录制（通过 --record=DIR 启用）
+extern int RECORD_SEGMENT_MB; // 单个分段文件预分配的大小（MB），写满后换新段
+
+// 行情回放（通过 --replay=PATH 启用，取代连接前置机）
+extern double REPLAY_SPEED; // 回放速度倍数：1 为原始节奏，10 为十倍速，0 为不等待（尽快回放）
+
+// 模拟前置（--mock 或 make mock 构建的程序），见 MockMdApi.h
+extern int MOCK_TICK_RATE;                // 每个会话每秒生成的行情数，0 表示不限速
+extern int MOCK_INSTRUMENT_COUNT;         // --mock 下大于 0 时以 mock00000 起的合成合约代码取代配置的合约列表
+extern int MOCK_RESPONSE_DELAY_MS;        // 登录、订阅等请求的应答延迟（毫秒）
+extern int MOCK_DISCONNECT_INTERVAL_SEC;  // 模拟断线的间隔（秒），0 表示不断线
+extern int MOCK_DURATION_SEC;             // 运行时长（秒），到时停止行情并正常退出，0 表示一直运行
+
+// K 线合成（通过 --bar-port=PORT 启用），见 BarBuilder.h
+extern int BAR_HISTORY;         // 每个合约每个周期保留的已收盘 K 线根数，新客户端连接时全部发送
+extern int BAR_CLOSE_DELAY_MS;  // 没有新行情的合约，交易所时钟越过区间终点该时间（毫秒）后收盘
+
+// 内置 SSE 服务器（通过 --sse-port=PORT 启用）
+extern int SSE_MAX_CLIENTS;             // 最大客户端连接数
+extern int SSE_INBOUND_CAPACITY;        // 流水线到服务器线程的队列容量（帧）
+extern int SSE_LOG_BYTES;               // 广播日志容量（字节）
+extern int SSE_LOG_FRAMES;              // 广播日志最多保留的帧数
+extern int SSE_CLIENT_MAX_QUEUE_FRAMES; // 单个客户端最多积压的帧数，超出部分丢弃
+extern int SSE_CONFLATE_LAG_FRAMES;     // 合并模式客户端积压超过该帧数时按合约合并
+extern bool SSE_DELTA_FRAMES;           // 行情帧只输出相对同一合约上一条行情变化的字段
+extern int SSE_DELTA_REFRESH_FRAMES;    // 变化字段模式下每个合约每隔该帧数输出一次完整帧
+
+// 读取 JSON 配置文件，只覆盖文件中出现的键；失败时返回 false 并在 stderr 输出原因
+// 文件中 instrument_file 的相对路径相对于配置文件所在目录
+bool LoadConfigFile(const char* path);
+
+// 应用一项命令行覆盖（key 中的 '-' 视同 '_'），键名未知或取值非法时返回 false
+bool ApplyConfigOverride(const std::string& key, const char* value);
+
+// 设置了 INSTRUMENT_FILE 时从文件读取合约列表（忽略空行和 # 开头的注释），失败时返回 false
+bool LoadInstrumentList();
 
 #endif // CONFIG_H
@@ -1,37 +1,273 @@
 #include "MyMdSpi.h"
 #include "config.h"
+#include "ShmPublisher.h"
+#include "TickRecorder.h"
+#include "SseServer.h"
+#include "ControlServer.h"
+#include "MetricsServer.h"
+#include "BarBuilder.h"
+#include "SessionRouter.h"
+#include "FrontArbiter.h"
+#include "TickReplayer.h"
+#include "MockMdApi.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <cerrno>
+#include <sys/stat.h>
 #include <json.hpp>
 #include <thread>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-int main()
+int main(int argc, char* argv[])
 {
-    // 1. 创建CThostFtdcMdApi实例
-    // 第一个参数是存储订阅信息文件的目录，默认为当前目录
+    // 0. 解析命令行参数：先读取配置文件，其余的 --key=value 覆盖配置文件中的值
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--config=", 9) == 0 && !LoadConfigFile(argv[i] + 9)) {
+            return -1;
+        }
+    }
+
+    OutputFormat outputFormat = OutputFormat::Json;
+    const char* shmName = nullptr;
+    int ssePort = 0;
+    int metricsPort = 0;
+    int barPort = 0;
+    const char* controlPath = nullptr;
+    const char* recordDir = nullptr;
+    const char* replayPath = nullptr;
+    bool useMock = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* eq = strchr(argv[i], '=');
+        if (strncmp(argv[i], "--config=", 9) == 0) {
+            continue;
+        } else if (strcmp(argv[i], "--format=json") == 0) {
+            outputFormat = OutputFormat::Json;
+        } else if (strcmp(argv[i], "--format=binary") == 0) {
+            outputFormat = OutputFormat::Binary;
+        } else if (strcmp(argv[i], "--format=none") == 0) {
+            outputFormat = OutputFormat::None;
+        } else if (strncmp(argv[i], "--shm=", 6) == 0 && argv[i][6] != '\0') {
+            shmName = argv[i] + 6;
+        } else if (strncmp(argv[i], "--sse-port=", 11) == 0 && atoi(argv[i] + 11) > 0) {
+            ssePort = atoi(argv[i] + 11);
+        } else if (strncmp(argv[i], "--bar-port=", 11) == 0 && atoi(argv[i] + 11) > 0) {
+            barPort = atoi(argv[i] + 11);
+        } else if (strncmp(argv[i], "--metrics-port=", 15) == 0 && atoi(argv[i] + 15) > 0) {
+            metricsPort = atoi(argv[i] + 15);
+        } else if (strncmp(argv[i], "--record=", 9) == 0 && argv[i][9] != '\0') {
+            recordDir = argv[i] + 9;
+        } else if (strcmp(argv[i], "--mock") == 0) {
+            useMock = true;
+        } else if (strncmp(argv[i], "--replay=", 9) == 0 && argv[i][9] != '\0') {
+            replayPath = argv[i] + 9;
+        } else if (strncmp(argv[i], "--control=", 10) == 0 && argv[i][10] != '\0') {
+            controlPath = argv[i] + 10;
+        } else if (strncmp(argv[i], "--", 2) == 0 && eq && ApplyConfigOverride(std::string(argv[i] + 2, eq - argv[i] - 2), eq + 1)) {
+            continue;
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            std::cerr << "Usage: " << argv[0] << " [--config=FILE] [--format=json|binary|none] [--shm=NAME] [--sse-port=PORT] [--bar-port=PORT] [--record=DIR]"
+                      << " [--replay=PATH] [--mock] [--control=PATH] [--metrics-port=PORT] [--KEY=VALUE ...]" << std::endl;
+            return -1;
+        }
+    }
+    if (!LoadInstrumentList()) {
+        return -1;
+    }
+
+    // 模拟前置：以合成合约代码取代配置的合约列表，仅 --mock 下生效，连接真实前置时保持配置的合约
+    if (useMock && MOCK_INSTRUMENT_COUNT > 0) {
+        INSTRUMENT_IDS.clear();
+        char id[32];
+        for (int i = 0; i < MOCK_INSTRUMENT_COUNT; ++i) {
+            snprintf(id, sizeof(id), "mock%05d", i);
+            INSTRUMENT_IDS.push_back(id);
+        }
+    }
+
+    // 回放模式：不连接前置机，录制文件中出现的合约全部登记
+    TickReplayer replayer;
+    if (replayPath) {
+        if (!replayer.Open(replayPath)) {
+            return -1;
+        }
+        INSTRUMENT_IDS.clear();
+        replayer.CollectInstruments(INSTRUMENT_IDS);
+    }
+    if (INSTRUMENT_IDS.empty()) {
+        std::cerr << "No instruments configured." << std::endl;
+        return -1;
+    }
+
+    // 为订阅的合约分配连续编号，预留运行中新增合约的容量
+    InstrumentRegistry registry;
+    registry.Reserve(static_cast<uint32_t>(std::max<size_t>(INSTRUMENT_CAPACITY, INSTRUMENT_IDS.size())));
+    for (size_t i = 0; i < INSTRUMENT_IDS.size(); ++i) {
+        registry.Add(INSTRUMENT_IDS[i].c_str());
+    }
+    if (!registry.Build()) return -1;
+
+    // 1. 创建CThostFtdcMdApi实例，多会话时每个会话一个实例，合约按 SessionRouter 分配；
+    // 冗余前置时每个前置各有一组会话，会话 i 连接前置 i / MD_SESSIONS，订阅第 i % MD_SESSIONS 组合约
+    // 第一个参数是存储订阅信息文件的目录，默认为当前目录；多会话时各会话使用独立的子目录
     // 第二个参数是是否使用UDP，默认为false
     // 第三个参数是是否使用组播，默认为false
-    CThostFtdcMdApi* pMdApi = CThostFtdcMdApi::CreateFtdcMdApi("", false, false);
-    if (!pMdApi) {
-        std::cerr << "Failed to create CThostFtdcMdApi instance." << std::endl;
+    std::vector<std::string> fronts = FRONT_ADDRS;
+    if (fronts.empty()) fronts.push_back(FRONT_ADDR);
+    SessionRouter router(static_cast<uint32_t>(MD_SESSIONS), SESSION_GROUPS);
+    uint32_t sessionCount = replayPath ? 0 : static_cast<uint32_t>(fronts.size()) * router.SessionCount();
+    std::vector<CThostFtdcMdApi*> mdApis;
+    for (uint32_t i = 0; i < sessionCount; ++i) {
+        std::string flowPath = FLOW_PATH;
+        if (!flowPath.empty() && flowPath.back() != '/') flowPath += '/';
+        if (sessionCount > 1) {
+            flowPath += "md" + std::to_string(i) + "/";
+            if (mkdir(flowPath.c_str(), 0755) != 0 && errno != EEXIST) {
+                std::cerr << "mkdir " << flowPath << " failed: " << strerror(errno) << std::endl;
+                return -1;
+            }
+        }
+        CThostFtdcMdApi* pMdApi = useMock ? new MockMdApi(flowPath.c_str(), MockMdApi::OptionsFromConfig())
+                                          : CThostFtdcMdApi::CreateFtdcMdApi(flowPath.c_str(), false, false);
+        if (!pMdApi) {
+            std::cerr << "Failed to create CThostFtdcMdApi instance." << std::endl;
+            return -1;
+        }
+        mdApis.push_back(pMdApi);
+    }
+
+    // 2. 创建行情处理流水线，编码和输出在独立的工作线程中进行；每个会话的回调线程写入各自的队列
+    BatchWriter::Policy outputPolicy;
+    outputPolicy.MaxBytes = OUTPUT_MAX_BATCH_BYTES;
+    outputPolicy.MaxFrames = OUTPUT_MAX_BATCH_FRAMES;
+    outputPolicy.MaxDelayUs = OUTPUT_MAX_DELAY_US;
+    outputPolicy.FlushWhenIdle = OUTPUT_FLUSH_WHEN_IDLE;
+    TickPipeline pipeline(TICK_RING_CAPACITY, outputPolicy, mdApis.size());
+    pipeline.SetOutputFormat(outputFormat);
+    pipeline.SetRegistry(&registry);
+
+    // 各合约的最新行情，新连接的 SSE 客户端据此获得快照
+    LastValueCache lastValues(registry.Capacity());
+    pipeline.SetLastValueCache(&lastValues);
+
+    // 冗余前置：同一条行情只输出最先到达的一份
+    std::vector<uint32_t> laneFronts;
+    for (uint32_t i = 0; i < sessionCount; ++i) laneFronts.push_back(i / router.SessionCount());
+    bool arbitrate = !replayPath && fronts.size() > 1;
+    FrontArbiter arbiter(fronts, laneFronts, arbitrate ? registry.Capacity() : 0);
+    if (arbitrate) pipeline.SetFrontArbiter(&arbiter);
+
+    // 可选：共享内存广播环，供本机其他进程只读挂载
+    ShmPublisher shmPublisher;
+    if (shmName) {
+        if (!shmPublisher.Open(shmName, SHM_SLOT_COUNT, SHM_INSTRUMENT_CAPACITY, registry)) {
+            return -1;
+        }
+        pipeline.AddSink(&shmPublisher);
+    }
+
+    // 可选：按交易日分段录制原始行情
+    TickRecorder recorder;
+    if (recordDir) {
+        if (!recorder.Open(recordDir, static_cast<uint64_t>(RECORD_SEGMENT_MB) * 1024 * 1024)) {
+            return -1;
+        }
+        pipeline.AddSink(&recorder);
+    }
+
+    // 可选：内置 SSE 服务器，直接向客户端推送 /events
+    SseServer sseServer;
+    if (ssePort > 0) {
+        sseServer.SetLastValueCache(&lastValues);
+        sseServer.SetDeltaFrames(SSE_DELTA_FRAMES);
+        if (!sseServer.Start(ssePort)) {
+            return -1;
+        }
+        pipeline.AddSink(&sseServer);
+    }
+
+    // 可选：合成 1 秒、1 分钟、5 分钟 K 线，由独立的 SSE 服务器作为单独的数据流推送
+    BarBuilder barBuilder(registry.Capacity(), static_cast<uint32_t>(BAR_HISTORY));
+    SseServer barServer;
+    if (barPort > 0) {
+        barBuilder.SetRegistry(&registry);
+        barServer.SetName("bars");
+        barServer.SetSnapshotSource(&barBuilder);
+        if (!barServer.Start(barPort)) {
+            return -1;
+        }
+        barBuilder.SetPublisher(&barServer);
+        pipeline.AddSink(&barBuilder);
+    }
+    pipeline.Start();
+
+    // 回放模式：在主线程中代替 CTP 回调线程调用 OnRtnDepthMarketData，回放结束后正常停止
+    if (replayPath) {
+        MyMdSpi replaySpi;
+        replaySpi.SetPipeline(&pipeline);
+        replayer.SetPipeline(&pipeline);
+        replayer.Run(&replaySpi, REPLAY_SPEED);
+        pipeline.Stop();
+        sseServer.Stop();
+        barServer.Stop();
+        std::cerr << "Program exited." << std::endl;
+        return 0;
+    }
+
+    // 创建并注册回调实例，每个会话只订阅分配给它的合约
+    std::vector<std::unique_ptr<MyMdSpi>> mdSpis;
+    std::vector<std::unique_ptr<SubscriptionManager>> subscriptions;
+    std::vector<SubscriptionManager*> subscriptionList;
+    for (uint32_t i = 0; i < mdApis.size(); ++i) {
+        subscriptions.emplace_back(new SubscriptionManager(registry, &router, i % router.SessionCount()));
+        subscriptionList.push_back(subscriptions.back().get());
+        mdSpis.emplace_back(new MyMdSpi());
+        MyMdSpi& mdSpi = *mdSpis.back();
+        mdSpi.SetMdApi(mdApis[i]); // 将MdApi实例传递给Spi
+        mdSpi.SetPipeline(&pipeline);
+        if (mdApis.size() > 1) mdSpi.SetSession(i);
+        mdSpi.SetSubscriptions(subscriptions.back().get());
+        mdApis[i]->RegisterSpi(&mdSpi);
+    }
+
+    // 可选：本地控制通道，运行中增删订阅的合约
+    ControlServer controlServer;
+    controlServer.SetPipeline(&pipeline);
+    if (controlPath && !controlServer.Start(controlPath, subscriptionList)) {
+        for (size_t i = 0; i < mdApis.size(); ++i) mdApis[i]->Release();
         return -1;
     }
 
-    // 2. 创建并注册回调实例
-    MyMdSpi mdSpi;
-    mdSpi.SetMdApi(pMdApi); // 将MdApi实例传递给Spi
-    pMdApi->RegisterSpi(&mdSpi);
+    // 可选：Prometheus 指标端点
+    MetricsServer metricsServer;
+    metricsServer.SetPipeline(&pipeline);
+    for (size_t i = 0; i < mdSpis.size(); ++i) metricsServer.AddSession(mdSpis[i].get());
+    if (metricsPort > 0 && !metricsServer.Start(metricsPort)) {
+        controlServer.Stop();
+        for (size_t i = 0; i < mdApis.size(); ++i) mdApis[i]->Release();
+        return -1;
+    }
 
     // 3. 注册前置机地址
     // 请确保FRONT_ADDR是有效的行情前置机地址
-    char frontAddr[256];
-    strncpy(frontAddr, FRONT_ADDR, sizeof(frontAddr) - 1);
-    frontAddr[sizeof(frontAddr) - 1] = '\0'; // 确保字符串以null结尾
-    pMdApi->RegisterFront(frontAddr);
+    for (size_t i = 0; i < mdApis.size(); ++i) {
+        char frontAddr[256];
+        strncpy(frontAddr, fronts[laneFronts[i]].c_str(), sizeof(frontAddr) - 1);
+        frontAddr[sizeof(frontAddr) - 1] = '\0'; // 确保字符串以null结尾
+        mdApis[i]->RegisterFront(frontAddr);
+    }
 
     // 4. 初始化API
     // Init()会启动API内部的线程，并尝试连接前置机
-    std::cerr << "Initializing CThostFtdcMdApi..." << std::endl;
-    pMdApi->Init();
+    std::cerr << "Initializing CThostFtdcMdApi" << (mdApis.size() > 1 ? " x" + std::to_string(mdApis.size()) : "")
+              << "..." << std::endl;
+    for (size_t i = 0; i < mdApis.size(); ++i) {
+        mdApis[i]->Init();
+    }
 
     // 5. 等待API线程结束
     // Join()会阻塞当前线程，直到API内部线程退出。
@@ -46,20 +282,38 @@ int main()
     // 例如，可以等待一个标志位，当登录成功并接收到足够行情后，再执行登出和释放。
     
     // 为了演示，我们让主线程等待一段时间，以便观察行情数据
-    pMdApi->Join(); // 等待API线程结束
+    for (size_t i = 0; i < mdApis.size(); ++i) {
+        mdApis[i]->Join(); // 等待API线程结束
+    }
 
     // 在程序退出前，执行登出和取消订阅操作
-    if (mdSpi.m_bIsLogin) {
-        mdSpi.UnSubscribeMarketData();
+    bool anyLogin = false;
+    for (size_t i = 0; i < mdSpis.size(); ++i) {
+        if (!mdSpis[i]->m_bIsLogin) continue;
+        mdSpis[i]->UnSubscribeMarketData();
+        anyLogin = true;
+    }
+    if (anyLogin) {
         std::this_thread::sleep_for(std::chrono::seconds(1)); // 稍等片刻，确保取消订阅请求发出
-        mdSpi.ReqUserLogout();
+        for (size_t i = 0; i < mdSpis.size(); ++i) mdSpis[i]->ReqUserLogout();
         std::this_thread::sleep_for(std::chrono::seconds(1)); // 稍等片刻，确保登出请求发出
     }
     
+    controlServer.Stop();
+    metricsServer.Stop();
+    for (size_t i = 0; i < subscriptions.size(); ++i) subscriptions[i]->Stop();
+
     // 6. 释放API实例
     std::cerr << "Releasing CThostFtdcMdApi..." << std::endl;
-    pMdApi->Release();
-    pMdApi = nullptr; // 避免悬空指针
+    for (size_t i = 0; i < mdApis.size(); ++i) {
+        mdApis[i]->Release();
+    }
+    mdApis.clear(); // 避免悬空指针
+
+    // 7. 处理完队列中剩余的行情后停止流水线和各输出端
+    pipeline.Stop();
+    sseServer.Stop();
+    barServer.Stop();
 
     std::cerr << "Program exited." << std::endl;
     return 0;
@@ -2,56 +2,109 @@ from fastapi import FastAPI
 from fastapi.responses import StreamingResponse
 import asyncio
 import sys
+import re
 import logging
-from typing import Set
+from typing import Dict, Optional, Set
 
 # 配置日志，便于调试
 logging.basicConfig(level=logging.INFO, stream=sys.stderr,
                     format='%(asctime)s - %(levelname)s - %(message)s')
 logger = logging.getLogger(__name__)
 
+# 从行情 JSON 中提取合约代码，作为合并的键
+INSTRUMENT_ID_PATTERN = re.compile(r'"InstrumentID":"([^"]*)"')
+
+class ConflatingQueue:
+    """
+    合并队列：每个合约最多保留一条待发送的行情，新行情到达时替换尚未发送的旧行情。
+    慢客户端看到的始终是各合约一致的最新状态，而不是随机丢弃后的结果。
+    """
+    def __init__(self):
+        self._pending: Dict[Optional[str], str] = {}  # 合约代码 -> 最新消息，按首次到达的顺序发送
+        self._event = asyncio.Event()
+        self.published = 0  # 发布给该订阅者的消息数
+        self.conflated = 0  # 被更新消息取代而未发送的消息数
+        self.sent = 0       # 已取出发送的消息数
+
+    def put(self, key: Optional[str], message: str):
+        self.published += 1
+        if key in self._pending:
+            self.conflated += 1
+        self._pending[key] = message
+        self._event.set()
+
+    async def get(self) -> str:
+        while not self._pending:
+            self._event.clear()
+            await self._event.wait()
+        key = next(iter(self._pending))
+        self.sent += 1
+        return self._pending.pop(key)
+
+    def qsize(self) -> int:
+        return len(self._pending)
+
+    def conflation_ratio(self) -> float:
+        return self.conflated / self.published if self.published else 0.0
+
+    def stats(self) -> dict:
+        return {
+            "published": self.published,
+            "conflated": self.conflated,
+            "sent": self.sent,
+            "pending": self.qsize(),
+            "conflation_ratio": self.conflation_ratio(),
+        }
+
 # 定义一个广播通道类
 class BroadcastChannel:
-    def __init__(self, max_queue_size: int = 100):
+    def __init__(self):
         """
-        初始化广播通道。
-        :param max_queue_size: 每个订阅者队列的最大容量。如果队列满，消息将被丢弃。
+        初始化广播通道。每个订阅者持有一个合并队列，慢订阅者不会阻塞发布者，也不会丢失合约的最新行情。
         """
-        self._subscribers: Set[asyncio.Queue] = set()
+        self._subscribers: Set[ConflatingQueue] = set()
         self._lock = asyncio.Lock() # 用于保护 _subscribers 集合
-        self._max_queue_size = max_queue_size
-        logger.info(f"BroadcastChannel initialized with max_queue_size={max_queue_size}")
+        # 已取消订阅者的累计统计
+        self._closed_published = 0
+        self._closed_conflated = 0
+        logger.info("BroadcastChannel initialized with per-instrument conflation")
 
-    async def subscribe(self) -> asyncio.Queue:
+    async def subscribe(self) -> ConflatingQueue:
         """
-        订阅广播通道。返回一个专门用于接收消息的异步队列。
+        订阅广播通道。返回一个专门用于接收消息的合并队列。
         """
-        queue = asyncio.Queue(maxsize=self._max_queue_size)
+        queue = ConflatingQueue()
         async with self._lock:
             self._subscribers.add(queue)
         logger.info(f"New subscriber {id(queue)} added. Total subscribers: {len(self._subscribers)}")
         return queue
 
-    async def unsubscribe(self, queue: asyncio.Queue):
+    async def unsubscribe(self, queue: ConflatingQueue):
         """
         取消订阅广播通道。
         """
         async with self._lock:
             if queue in self._subscribers:
                 self._subscribers.remove(queue)
+                self._closed_published += queue.published
+                self._closed_conflated += queue.conflated
                 # 可以选择在这里清空队列，但通常在客户端断开时，队列会被垃圾回收
-                logger.info(f"Subscriber {id(queue)} removed. Total subscribers: {len(self._subscribers)}")
+                logger.info(f"Subscriber {id(queue)} removed ({queue.stats()}). "
+                            f"Total subscribers: {len(self._subscribers)}")
             else:
                 logger.warning(f"Attempted to remove non-existent subscriber {id(queue)}.")
 
     async def publish(self, message: str):
         """
         发布消息到所有订阅者。
-        如果订阅者的队列已满，消息将被丢弃，以防止慢客户端阻塞发布者。
+        订阅者尚未取走的同一合约的旧消息被新消息替换，发布者永远不会被慢客户端阻塞。
         """
         if not message.strip(): # 不发布空消息
             return
 
+        match = INSTRUMENT_ID_PATTERN.search(message)
+        key = match.group(1) if match else None
+
         # 在获取锁的情况下复制订阅者列表，以避免在迭代时因修改集合而引发错误
         async with self._lock:
             subscribers_to_notify = list(self._subscribers)
@@ -59,15 +112,29 @@ class BroadcastChannel:
         # 非阻塞地将消息放入每个订阅者的队列
         for queue in subscribers_to_notify:
             try:
-                queue.put_nowait(message) # 使用 put_nowait 实现非阻塞
-            except asyncio.QueueFull:
-                logger.warning(f"Subscriber queue {id(queue)} is full, dropping message: '{message[:50]}...'")
+                queue.put(key, message)
             except Exception as e:
                 logger.error(f"Error putting message to subscriber queue {id(queue)}: {e}")
 
+    async def stats(self) -> dict:
+        """
+        合并统计：conflation_ratio 为发布的消息中被更新消息取代而未发送的比例。
+        """
+        async with self._lock:
+            subscribers = list(self._subscribers)
+        published = self._closed_published + sum(q.published for q in subscribers)
+        conflated = self._closed_conflated + sum(q.conflated for q in subscribers)
+        return {
+            "subscribers": len(subscribers),
+            "published": published,
+            "conflated": conflated,
+            "conflation_ratio": conflated / published if published else 0.0,
+            "clients": {str(id(q)): q.stats() for q in subscribers},
+        }
+
 app = FastAPI()
 # 创建一个全局的广播通道实例
-broadcast_channel = BroadcastChannel(max_queue_size=50) # 可以调整队列大小
+broadcast_channel = BroadcastChannel()
 
 async def read_input_and_publish():
     """
@@ -107,7 +174,7 @@ async def startup_event():
     asyncio.create_task(read_input_and_publish())
     logger.info("Application startup: stdin reader task initiated.")
 
-async def event_generator(client_queue: asyncio.Queue):
+async def event_generator(client_queue: ConflatingQueue):
     """
     为每个连接的客户端生成 SSE 事件流。
     """
@@ -119,7 +186,6 @@ async def event_generator(client_queue: asyncio.Queue):
             
             # 按照 SSE 格式发送数据
             yield f"data: {line}\n\n"
-            client_queue.task_done() # 标记任务完成
     except asyncio.CancelledError:
         # 当客户端断开连接时，FastAPI 会取消这个协程
         logger.info(f"Client {id(client_queue)} disconnected (CancelledError).")
@@ -142,6 +208,14 @@ async def sse_endpoint():
     # 返回 StreamingResponse，使用 event_generator 生成 SSE 事件
     return StreamingResponse(event_generator(client_queue), media_type="text/event-stream")
 
+
+@app.get("/stats")
+async def stats_endpoint():
+    """
+    返回各订阅者的合并统计。
+    """
+    return await broadcast_channel.stats()
+
 if __name__ == "__main__":
     import uvicorn
     # 运行 FastAPI 应用